@@ -0,0 +1,827 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * LibOSDP micro benchmarks.
+ *
+ * Times the hot paths of the library (phy packet build/parse, SC MAC, CRC,
+ * ring buffer, AES) and an end-to-end CP <-> PD command loop over an
+ * in-memory channel. Results are written as JSON so runs with different
+ * crypto backends and build options can be diffed by a script.
+ *
+ * Usage: osdp_bench [-o FILE] [-n COMMANDS] [-t MIN_MS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <osdp.h>
+#include "osdp_common.h"
+#include "crypto/tinyaes_hw.h"
+#include "crypto/tinyaes_ct.h"
+
+#define BENCH_PIPE_DEPTH      8
+#define BENCH_PKT_MAX         (OSDP_PACKET_BUF_SIZE + 64)
+#define BENCH_MAX_RESULTS     32
+#define BENCH_CMD_TIMEOUT_MS  2000
+
+struct bench_pipe {
+	struct {
+		int len;
+		uint8_t data[BENCH_PKT_MAX];
+	} slot[BENCH_PIPE_DEPTH];
+	int head;
+	int tail;
+	int off; /* bytes of slot[tail] already read (stream mode) */
+};
+
+struct bench_link {
+	struct bench_pipe *tx;
+	struct bench_pipe *rx;
+};
+
+struct bench_result {
+	char name[32];
+	long iterations;
+	double ns_per_op;
+	long bytes_per_op;
+	/* cp_pd_loop only */
+	double p50_us;
+	double p99_us;
+};
+
+static struct bench_pipe g_cp_to_pd, g_pd_to_cp;
+static struct bench_link g_cp_link = { &g_cp_to_pd, &g_pd_to_cp };
+static struct bench_link g_pd_link = { &g_pd_to_cp, &g_cp_to_pd };
+
+static struct bench_result g_results[BENCH_MAX_RESULTS];
+static int g_num_results;
+static long g_min_ns = 200 * 1000 * 1000L;
+static int g_loop_commands = 2000;
+
+static volatile int g_completions;
+static volatile uint16_t g_sink;
+
+static inline uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* --- in-memory channel; one slot per packet sent --- */
+
+static void pipe_flush(void *data)
+{
+	struct bench_link *link = data;
+
+	link->rx->head = link->rx->tail = link->rx->off = 0;
+}
+
+static void pipe_reset(void)
+{
+	pipe_flush(&g_cp_link);
+	pipe_flush(&g_pd_link);
+}
+
+static int pipe_send(void *data, uint8_t *buf, int len)
+{
+	struct bench_link *link = data;
+	struct bench_pipe *p = link->tx;
+	int next = (p->head + 1) % BENCH_PIPE_DEPTH;
+
+	if (next == p->tail) {
+		return 0;
+	}
+	if (len > BENCH_PKT_MAX) {
+		return -1;
+	}
+	memcpy(p->slot[p->head].data, buf, len);
+	p->slot[p->head].len = len;
+	p->head = next;
+	return len;
+}
+
+#ifndef OPT_OSDP_RX_ZERO_COPY
+static int pipe_recv(void *data, uint8_t *buf, int max_len)
+{
+	struct bench_link *link = data;
+	struct bench_pipe *p = link->rx;
+	int n, total = 0;
+
+	while (p->tail != p->head && total < max_len) {
+		n = p->slot[p->tail].len - p->off;
+		if (n > max_len - total) {
+			n = max_len - total;
+		}
+		memcpy(buf + total, p->slot[p->tail].data + p->off, n);
+		total += n;
+		p->off += n;
+		if (p->off == p->slot[p->tail].len) {
+			p->tail = (p->tail + 1) % BENCH_PIPE_DEPTH;
+			p->off = 0;
+		}
+	}
+	return total;
+}
+#else
+static int pipe_recv_pkt(void *data, const uint8_t **buf, int *max_len)
+{
+	struct bench_link *link = data;
+	struct bench_pipe *p = link->rx;
+
+	if (p->tail == p->head) {
+		return -1;
+	}
+	*buf = p->slot[p->tail].data;
+	*max_len = p->slot[p->tail].len;
+	return 0;
+}
+
+static void pipe_release_pkt(void *data, const uint8_t *buf)
+{
+	struct bench_link *link = data;
+	struct bench_pipe *p = link->rx;
+
+	if (p->tail != p->head && buf == p->slot[p->tail].data) {
+		p->tail = (p->tail + 1) % BENCH_PIPE_DEPTH;
+	}
+}
+#endif /* OPT_OSDP_RX_ZERO_COPY */
+
+static void bench_channel(struct osdp_channel *ch, struct bench_link *link)
+{
+	memset(ch, 0, sizeof(*ch));
+	ch->data = link;
+	ch->send = pipe_send;
+	ch->flush = pipe_flush;
+#ifndef OPT_OSDP_RX_ZERO_COPY
+	ch->recv = pipe_recv;
+#else
+	ch->recv_pkt = pipe_recv_pkt;
+	ch->release_pkt = pipe_release_pkt;
+#endif
+}
+
+/* --- CP/PD pair --- */
+
+static void bench_completion_cb(void *arg, int pd, const struct osdp_cmd *cmd,
+				enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(cmd);
+
+	if (status == OSDP_COMPLETION_OK) {
+		g_completions++;
+	} else {
+		g_completions = -1;
+	}
+}
+
+static int bench_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(cmd);
+
+	return 0;
+}
+
+static int bench_pair_setup(osdp_t **cp, osdp_t **pd, bool secure)
+{
+	static uint8_t scbk[16] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+	};
+	struct osdp_pd_cap cap[] = {
+		{ OSDP_PD_CAP_READER_LED_CONTROL, 1, 1 },
+		{ -1, -1, -1 }
+	};
+	struct osdp_channel cp_channel, pd_channel;
+	osdp_pd_info_t info_cp = {
+		.address = 101,
+		.baud_rate = 115200,
+		.scbk = secure ? scbk : NULL,
+	};
+	osdp_pd_info_t info_pd = {
+		.address = 101,
+		.baud_rate = 115200,
+		.id = { .version = 1, .model = 1, .vendor_code = 1 },
+		.cap = cap,
+		.scbk = secure ? scbk : NULL,
+	};
+	uint64_t start;
+	uint8_t online = 0, sc = 0;
+
+	pipe_reset();
+	bench_channel(&cp_channel, &g_cp_link);
+	bench_channel(&pd_channel, &g_pd_link);
+
+	*cp = osdp_cp_setup(&cp_channel, 1, &info_cp);
+	if (*cp == NULL) {
+		return -1;
+	}
+	*pd = osdp_pd_setup(&pd_channel, &info_pd);
+	if (*pd == NULL) {
+		osdp_cp_teardown(*cp);
+		return -1;
+	}
+	osdp_pd_set_command_callback(*pd, bench_pd_command_cb, NULL);
+	osdp_cp_set_command_completion_callback(*cp, bench_completion_cb, NULL);
+
+	start = bench_now_ns();
+	while (bench_now_ns() - start < 10000000000ULL) {
+		osdp_cp_refresh(*cp);
+		osdp_pd_refresh(*pd);
+		osdp_get_status_mask(*cp, &online);
+		osdp_get_sc_status_mask(*cp, &sc);
+		if ((online & 1) && (!secure || (sc & 1))) {
+			return 0;
+		}
+		usleep(100);
+	}
+	fprintf(stderr, "bench: PD did not come online (secure: %d)\n", secure);
+	osdp_cp_teardown(*cp);
+	osdp_pd_teardown(*pd);
+	return -1;
+}
+
+static void bench_pair_teardown(osdp_t *cp, osdp_t *pd)
+{
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+}
+
+/* --- result bookkeeping --- */
+
+static struct bench_result *bench_add_result(const char *name)
+{
+	struct bench_result *r;
+
+	if (g_num_results >= BENCH_MAX_RESULTS) {
+		return NULL;
+	}
+	r = &g_results[g_num_results++];
+	memset(r, 0, sizeof(*r));
+	snprintf(r->name, sizeof(r->name), "%s", name);
+	return r;
+}
+
+typedef int (*bench_fn_t)(void *arg, long iterations);
+
+/**
+ * Run fn in batches of growing size until a batch takes at least g_min_ns,
+ * then report that batch. Same approach as Google Benchmark's iteration
+ * count estimate, minus the statistics.
+ */
+static int bench_run(const char *name, bench_fn_t fn, void *arg,
+		     long bytes_per_op)
+{
+	struct bench_result *r;
+	uint64_t start, elapsed;
+	long n = 1;
+
+	for (;;) {
+		start = bench_now_ns();
+		if (fn(arg, n)) {
+			fprintf(stderr, "bench: %s failed\n", name);
+			return -1;
+		}
+		elapsed = bench_now_ns() - start;
+		if (elapsed >= (uint64_t)g_min_ns || n >= (1L << 30)) {
+			break;
+		}
+		n = (elapsed < 1000) ? n * 100 :
+			(long)((double)n * 1.4 * (double)g_min_ns /
+			       (double)elapsed) + 1;
+	}
+
+	r = bench_add_result(name);
+	if (r) {
+		r->iterations = n;
+		r->ns_per_op = (double)elapsed / (double)n;
+		r->bytes_per_op = bytes_per_op;
+	}
+	return 0;
+}
+
+/* --- micro benchmarks --- */
+
+static uint8_t g_data[128];
+
+static int bench_crc16(void *arg, long n)
+{
+	ARG_UNUSED(arg);
+
+	while (n--) {
+		g_sink ^= osdp_compute_crc16(g_data, sizeof(g_data));
+	}
+	return 0;
+}
+
+/* The engines osdp_compute_crc16() can pick from, one entry each */
+static const struct bench_crc16_engine {
+	const char *name;
+	uint16_t (*fn)(uint16_t crc, const uint8_t *buf, size_t len);
+	bool (*supported)(void);
+} g_crc16_engines[] = {
+	{ "crc16_bitwise/128", osdp_crc16_bitwise, NULL },
+#if OSDP_CRC16_ENGINE >= 1
+	{ "crc16_table/128", osdp_crc16_table, NULL },
+#endif
+#if OSDP_CRC16_ENGINE >= 2
+	{ "crc16_slice8/128", osdp_crc16_slice8, NULL },
+#endif
+#if OSDP_CRC16_ENGINE >= 2 && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+	{ "crc16_clmul/128", osdp_crc16_clmul, osdp_crc16_clmul_supported },
+#endif
+};
+
+static int bench_crc16_engine(void *arg, long n)
+{
+	const struct bench_crc16_engine *e = arg;
+
+	while (n--) {
+		g_sink ^= e->fn(0x1D0F, g_data, sizeof(g_data));
+	}
+	return 0;
+}
+
+static int bench_crc16_engines(void)
+{
+	size_t i;
+	const struct bench_crc16_engine *e;
+
+	for (i = 0; i < ARRAY_SIZEOF(g_crc16_engines); i++) {
+		e = &g_crc16_engines[i];
+		if (e->supported && !e->supported()) {
+			continue;
+		}
+		if (bench_run(e->name, bench_crc16_engine, (void *)e,
+			      sizeof(g_data))) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int bench_rb(void *arg, long n)
+{
+	static struct osdp_rb rb;
+	uint8_t out[64];
+
+	ARG_UNUSED(arg);
+
+	osdp_rb_reset(&rb);
+	while (n--) {
+		if (osdp_rb_push_buf(&rb, g_data, sizeof(out)) != sizeof(out) ||
+		    osdp_rb_pop_buf(&rb, out, sizeof(out)) != sizeof(out)) {
+			return -1;
+		}
+	}
+	g_sink ^= out[0];
+	return 0;
+}
+
+/* The same traffic a byte at a time, as the ring was used before _buf */
+static int bench_rb_bytewise(void *arg, long n)
+{
+	static struct osdp_rb rb;
+	uint8_t out[64];
+	int i;
+
+	ARG_UNUSED(arg);
+
+	osdp_rb_reset(&rb);
+	while (n--) {
+		for (i = 0; i < (int)sizeof(out); i++) {
+			if (osdp_rb_push(&rb, g_data[i])) {
+				return -1;
+			}
+		}
+		for (i = 0; i < (int)sizeof(out); i++) {
+			if (osdp_rb_pop(&rb, &out[i])) {
+				return -1;
+			}
+		}
+	}
+	g_sink ^= out[0];
+	return 0;
+}
+
+static int bench_compute_mac(void *arg, long n)
+{
+	struct osdp_pd *pd = arg;
+
+	while (n--) {
+		osdp_compute_mac(pd, 1, g_data, 64);
+	}
+	g_sink ^= pd->sc.c_mac[0];
+	return 0;
+}
+
+static const uint8_t g_aes_key[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static int bench_aes_key_setup(void *arg, long n)
+{
+	struct osdp_crypt_key key;
+
+	ARG_UNUSED(arg);
+
+	while (n--) {
+		osdp_crypt_key_setup(&key, g_aes_key, false);
+		osdp_crypt_key_teardown(&key);
+	}
+	return 0;
+}
+
+/* CBC over all of g_data, on a copy; @arg is a key for that direction */
+static int bench_aes_cbc(void *arg, long n, bool decrypt)
+{
+	struct osdp_crypt_key *key = arg;
+	uint8_t iv[16] = { 0 }, buf[sizeof(g_data)];
+
+	memcpy(buf, g_data, sizeof(buf));
+	while (n--) {
+		if (decrypt) {
+			osdp_crypt_key_decrypt(key, iv, buf, sizeof(buf));
+		} else {
+			osdp_crypt_key_encrypt(key, iv, buf, sizeof(buf));
+		}
+	}
+	g_sink ^= buf[0];
+	return 0;
+}
+
+static int bench_aes_cbc_encrypt(void *arg, long n)
+{
+	return bench_aes_cbc(arg, n, false);
+}
+
+static int bench_aes_cbc_decrypt(void *arg, long n)
+{
+	return bench_aes_cbc(arg, n, true);
+}
+
+static int bench_aes(void)
+{
+	int rc;
+	struct osdp_crypt_key enc, dec;
+
+	osdp_crypt_setup();
+	osdp_crypt_key_setup(&enc, g_aes_key, false);
+	osdp_crypt_key_setup(&dec, g_aes_key, true);
+	rc = bench_run("aes_key_setup", bench_aes_key_setup, NULL, 0) ||
+	     bench_run("aes_cbc_encrypt/128", bench_aes_cbc_encrypt, &enc,
+		       sizeof(g_data)) ||
+	     bench_run("aes_cbc_decrypt/128", bench_aes_cbc_decrypt, &dec,
+		       sizeof(g_data));
+	osdp_crypt_key_teardown(&enc);
+	osdp_crypt_key_teardown(&dec);
+	osdp_crypt_teardown();
+	return rc;
+}
+
+/* Build a CMD_LED packet the way cp_build_command() lays it out */
+static int bench_build_led(struct osdp_pd *pd, uint8_t *buf, int max_len)
+{
+	int len;
+	uint8_t *smb;
+
+	pd->cmd_id = CMD_LED;
+	len = osdp_phy_packet_init(pd, buf, max_len);
+	if (len < 0) {
+		return -1;
+	}
+	buf[len++] = CMD_LED;
+	memcpy(buf + len, g_data, 14);
+	len += 14;
+	smb = osdp_phy_packet_get_smb(pd, buf);
+	if (smb && sc_is_active(pd)) {
+		smb[1] = SCS_17;
+	}
+	return osdp_phy_finalize_packet(pd, buf, len, max_len);
+}
+
+static int bench_phy_finalize(void *arg, long n)
+{
+	struct osdp_pd *pd = arg;
+	uint8_t buf[BENCH_PKT_MAX];
+
+	while (n--) {
+		if (bench_build_led(pd, buf, sizeof(buf)) <= 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+struct bench_rx {
+	struct osdp_pd *cp_pd;
+	struct osdp_pd *pd;
+	uint8_t pkt[BENCH_PKT_MAX];
+	int len;
+	bool decode;
+};
+
+static int bench_phy_rx(void *arg, long n)
+{
+	struct bench_rx *rx = arg;
+	uint8_t *data;
+
+	while (n--) {
+		if (pipe_send(&g_cp_link, rx->pkt, rx->len) != rx->len ||
+		    osdp_phy_check_packet(rx->pd) != OSDP_ERR_PKT_NONE) {
+			return -1;
+		}
+		if (rx->decode &&
+		    osdp_phy_decode_packet(rx->pd, &data) <= 0) {
+			return -1;
+		}
+		osdp_phy_state_reset(rx->pd, false);
+	}
+	return 0;
+}
+
+static int bench_phy(osdp_t *cp, osdp_t *pd, const char *tag)
+{
+	char name[32];
+	struct bench_rx rx = {
+		.cp_pd = osdp_to_pd(TO_OSDP(cp), 0),
+		.pd = osdp_to_pd(TO_OSDP(pd), 0),
+	};
+
+	/* Both ends hold the same SC state; keep it that way by never letting
+	 * the PD reply while the CP is driven by hand. */
+	pipe_reset();
+	SET_FLAG(rx.pd, PD_FLAG_SKIP_SEQ_CHECK);
+
+	snprintf(name, sizeof(name), "phy_finalize/%s", tag);
+	if (bench_run(name, bench_phy_finalize, rx.cp_pd, 0)) {
+		return -1;
+	}
+
+	rx.len = bench_build_led(rx.cp_pd, rx.pkt, sizeof(rx.pkt));
+	if (rx.len <= 0) {
+		return -1;
+	}
+	snprintf(name, sizeof(name), "phy_check/%s", tag);
+	if (bench_run(name, bench_phy_rx, &rx, rx.len)) {
+		return -1;
+	}
+	rx.decode = true;
+	snprintf(name, sizeof(name), "phy_check_decode/%s", tag);
+	if (bench_run(name, bench_phy_rx, &rx, rx.len)) {
+		return -1;
+	}
+
+	if (sc_is_active(rx.cp_pd) &&
+	    bench_run("compute_mac/64", bench_compute_mac, rx.cp_pd, 64)) {
+		return -1;
+	}
+	return 0;
+}
+
+/* --- end-to-end CP <-> PD loop --- */
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int bench_loop(osdp_t *cp, osdp_t *pd, const char *tag)
+{
+	int i, target;
+	uint64_t *lat, start, t0;
+	struct bench_result *r;
+	struct osdp_cmd cmd = {
+		.id = OSDP_CMD_LED,
+		.led = {
+			.permanent = {
+				.control_code = 1,
+				.on_count = 10,
+				.off_count = 10,
+				.on_color = OSDP_LED_COLOR_GREEN,
+			},
+		},
+	};
+
+	lat = calloc(g_loop_commands, sizeof(*lat));
+	if (lat == NULL) {
+		return -1;
+	}
+
+	g_completions = 0;
+	start = bench_now_ns();
+	for (i = 0; i < g_loop_commands; i++) {
+		target = g_completions + 1;
+		t0 = bench_now_ns();
+		if (osdp_cp_submit_command(cp, 0, &cmd)) {
+			goto fail;
+		}
+		while (g_completions >= 0 && g_completions < target) {
+			osdp_cp_refresh(cp);
+			osdp_pd_refresh(pd);
+			if (bench_now_ns() - t0 > BENCH_CMD_TIMEOUT_MS * 1000000ULL) {
+				break;
+			}
+		}
+		if (g_completions != target) {
+			goto fail;
+		}
+		lat[i] = bench_now_ns() - t0;
+	}
+
+	r = bench_add_result("");
+	if (r) {
+		snprintf(r->name, sizeof(r->name), "cp_pd_loop/%s", tag);
+		r->iterations = g_loop_commands;
+		r->ns_per_op = (double)(bench_now_ns() - start) / g_loop_commands;
+		qsort(lat, g_loop_commands, sizeof(*lat), cmp_u64);
+		r->p50_us = lat[g_loop_commands / 2] / 1000.0;
+		r->p99_us = lat[(g_loop_commands * 99) / 100] / 1000.0;
+	}
+	free(lat);
+	return 0;
+fail:
+	fprintf(stderr, "bench: cp_pd_loop/%s: command %d failed\n", tag, i);
+	free(lat);
+	return -1;
+}
+
+static int bench_pair(bool secure)
+{
+	int rc;
+	osdp_t *cp, *pd;
+	const char *tag = secure ? "sc" : "plain";
+
+	if (bench_pair_setup(&cp, &pd, secure)) {
+		return -1;
+	}
+	/* the loop leaves the CP idle with the last reply consumed */
+	rc = bench_loop(cp, pd, tag);
+	if (rc == 0) {
+		rc = bench_phy(cp, pd, tag);
+	}
+	bench_pair_teardown(cp, pd);
+	return rc;
+}
+
+/* --- output --- */
+
+static const char *bench_crypto_backend(void)
+{
+#if defined(OPT_OSDP_USE_OPENSSL)
+	return "openssl";
+#elif defined(OPT_OSDP_USE_MBEDTLS)
+	return "mbedtls";
+#else
+	return "tinyaes";
+#endif
+}
+
+/* AES code TinyAES runs on; the other backends pick their own */
+static const char *bench_crypto_accel(void)
+{
+#if defined(OPT_OSDP_USE_OPENSSL) || defined(OPT_OSDP_USE_MBEDTLS)
+	return "library";
+#else
+	const char *name = tinyaes_hw_name();
+
+	if (name) {
+		return name;
+	}
+#ifdef TINYAES_CT
+	return "bitsliced";
+#else
+	return "none";
+#endif
+#endif
+}
+
+static void bench_write_json(FILE *f)
+{
+	int i;
+	struct bench_result *r;
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"context\": {\n");
+	fprintf(f, "    \"library\": \"libosdp\",\n");
+	fprintf(f, "    \"version\": \"%s\",\n", osdp_get_version());
+	fprintf(f, "    \"source\": \"%s\",\n", osdp_get_source_info());
+	fprintf(f, "    \"crypto\": \"%s\",\n", bench_crypto_backend());
+	fprintf(f, "    \"crypto_accel\": \"%s\",\n", bench_crypto_accel());
+	fprintf(f, "    \"options\": {\n");
+	fprintf(f, "      \"rx_zero_copy\": %s,\n",
+		IS_ENABLED(OPT_OSDP_RX_ZERO_COPY) ? "true" : "false");
+	fprintf(f, "      \"rx_arena\": %s,\n",
+		IS_ENABLED(OPT_OSDP_RX_ARENA) ? "true" : "false");
+	fprintf(f, "      \"static\": %s,\n",
+		IS_ENABLED(OPT_OSDP_STATIC) ? "true" : "false");
+	fprintf(f, "      \"skip_mark_byte\": %s,\n",
+		IS_ENABLED(OPT_OSDP_SKIP_MARK_BYTE) ? "true" : "false");
+	fprintf(f, "      \"packet_trace\": %s\n",
+		IS_ENABLED(OPT_OSDP_PACKET_TRACE) ? "true" : "false");
+	fprintf(f, "    }\n");
+	fprintf(f, "  },\n");
+	fprintf(f, "  \"benchmarks\": [\n");
+	for (i = 0; i < g_num_results; i++) {
+		r = &g_results[i];
+		fprintf(f, "    {\"name\": \"%s\", \"iterations\": %ld, "
+			"\"ns_per_op\": %.1f", r->name, r->iterations,
+			r->ns_per_op);
+		if (r->bytes_per_op) {
+			fprintf(f, ", \"bytes_per_second\": %.0f",
+				r->bytes_per_op * 1e9 / r->ns_per_op);
+		}
+		if (strncmp(r->name, "cp_pd_loop/", 11) == 0) {
+			fprintf(f, ", \"commands_per_second\": %.1f, "
+				"\"latency_p50_us\": %.1f, "
+				"\"latency_p99_us\": %.1f",
+				1e9 / r->ns_per_op, r->p50_us, r->p99_us);
+		}
+		fprintf(f, "}%s\n", (i + 1 < g_num_results) ? "," : "");
+	}
+	fprintf(f, "  ]\n");
+	fprintf(f, "}\n");
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-o FILE] [-n COMMANDS] [-t MIN_MS]\n"
+		"  -o FILE      write JSON results to FILE (default: stdout)\n"
+		"  -n COMMANDS  commands per CP <-> PD loop run (default: %d)\n"
+		"  -t MIN_MS    minimum time per micro benchmark (default: %ld)\n",
+		prog, g_loop_commands, g_min_ns / 1000000);
+}
+
+int main(int argc, char *argv[])
+{
+	int opt, rc = 0;
+	size_t i;
+	FILE *f = stdout;
+	const char *out = NULL;
+
+	while ((opt = getopt(argc, argv, "o:n:t:h")) != -1) {
+		switch (opt) {
+		case 'o':
+			out = optarg;
+			break;
+		case 'n':
+			g_loop_commands = atoi(optarg);
+			break;
+		case 't':
+			g_min_ns = atol(optarg) * 1000000L;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (g_loop_commands <= 0 || g_min_ns <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+#ifndef OPT_OSDP_LOG_MINIMAL
+	osdp_logger_init("osdp", OSDP_LOG_ERROR, NULL);
+#endif
+	for (i = 0; i < sizeof(g_data); i++) {
+		g_data[i] = (uint8_t)(i * 7 + 1);
+	}
+
+	if (bench_run("crc16/128", bench_crc16, NULL, sizeof(g_data)) ||
+	    bench_crc16_engines() ||
+	    bench_run("rb_push_pop/64", bench_rb, NULL, 64) ||
+	    bench_run("rb_push_pop_bytewise/64", bench_rb_bytewise, NULL, 64) ||
+	    bench_aes() ||
+	    bench_pair(false) || bench_pair(true)) {
+		rc = 1;
+	}
+
+	if (out) {
+		f = fopen(out, "w");
+		if (f == NULL) {
+			perror(out);
+			return 1;
+		}
+	}
+	bench_write_json(f);
+	if (out) {
+		fclose(f);
+	}
+	return rc;
+}
@@ -18,8 +18,14 @@ usage() {
 	  --data-trace                 Enable command/reply data buffer tracing
 	  --skip-mark                  Don't send the leading mark byte (0xFF)
 	  --zero-copy                  Enable zero-copy RX buffers (requires recv_pkt/release_pkt)
+	  --rx-arena                   Receive into a contiguous arena and parse packets in place
+	  --early-address-filter       PD skips other PDs' commands by header before the CRC check
 	  --log-minimal                Minimize logger RAM/stack usage
+	  --cp-pool                    Build the multi-bus CP pool (needs pthreads)
+	  --linux-channel              Build the epoll based Linux channel drivers
+	  --virtual-bus                Build the in-memory RS-485 bus simulator
 	  --crypto LIB                 Crypto backend: auto|openssl|mbedtls|tinyaes (default: auto)
+	  --tinyaes-ct                 Constant time TinyAES when there are no AES instructions (~1.7x slower SC)
 	  --crypto-include-dir DIR     Include directory for crypto LIB if not in system path
 	  --crypto-ld-flags            Args to pass to linker for the crypto LIB
 	  --no-colours                 Don't colourize log ouputs
@@ -46,10 +52,16 @@ while [ $# -gt 0 ]; do
 	--data-trace)          DATA_TRACE=1;;
 	--skip-mark)           SKIP_MARK_BYTE=1;;
 	--zero-copy)           ZERO_COPY=1;;
+	--rx-arena)            RX_ARENA=1;;
+	--early-address-filter) EARLY_ADDRESS_FILTER=1;;
 	--log-minimal)         LOG_MINIMAL=1;;
+	--cp-pool)             CP_POOL=1;;
+	--linux-channel)       LINUX_CHANNEL=1;;
+	--virtual-bus)         VIRTUAL_BUS=1;;
 	--cross-compile)       CROSS_COMPILE=$2; shift;;
 	--prefix)              PREFIX=$2; shift;;
 	--crypto)              CRYPTO=$2; shift;;
+	--tinyaes-ct)          TINYAES_CT=1;;
 	--crypto-include-dir)  CRYPTO_INCLUDE_DIR=$2; shift;;
 	--crypto-ld-flags)     CRYPTO_LD_FLAGS=$2; shift;;
 	--no-colours)          NO_COLOURS=1;;
@@ -109,10 +121,35 @@ if [[ ! -z "${ZERO_COPY}" ]]; then
 	CCFLAGS+=" -DOPT_OSDP_RX_ZERO_COPY"
 fi
 
+if [[ ! -z "${RX_ARENA}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_RX_ARENA"
+fi
+
+if [[ ! -z "${EARLY_ADDRESS_FILTER}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_EARLY_ADDRESS_FILTER"
+fi
+
+if [[ ! -z "${TINYAES_CT}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_TINYAES_CT"
+fi
+
 if [[ ! -z "${LOG_MINIMAL}" ]]; then
 	CCFLAGS+=" -DOPT_OSDP_LOG_MINIMAL"
 fi
 
+if [[ ! -z "${CP_POOL}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_CP_POOL"
+	LDFLAGS+=" -lpthread"
+fi
+
+if [[ ! -z "${LINUX_CHANNEL}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_LINUX_CHANNEL"
+fi
+
+if [[ ! -z "${VIRTUAL_BUS}" ]]; then
+	CCFLAGS+=" -DOPT_OSDP_VIRTUAL_BUS"
+fi
+
 if [[ ! -z "${STATIC}" ]]; then
 	CCFLAGS+=" -DOPT_OSDP_STATIC"
 fi
@@ -171,16 +208,18 @@ case "${CRYPTO}" in
 openssl)
 	echo "Crypto backend: OpenSSL"
 	LIBOSDP_SOURCES+=" src/crypto/openssl.c"
+	CCFLAGS+=" -DOPT_OSDP_USE_OPENSSL"
 	LDFLAGS+=" -lcrypto"
 	;;
 mbedtls)
 	echo "Crypto backend: MbedTLS"
 	LIBOSDP_SOURCES+=" src/crypto/mbedtls.c"
+	CCFLAGS+=" -DOPT_OSDP_USE_MBEDTLS"
 	LDFLAGS+=" -lmbedcrypto -lmbedtls"
 	;;
 tinyaes)
 	echo "Crypto backend: TinyAES (bundled)"
-	LIBOSDP_SOURCES+=" src/crypto/tinyaes_src.c src/crypto/tinyaes.c"
+	LIBOSDP_SOURCES+=" src/crypto/tinyaes_src.c src/crypto/tinyaes_hw.c src/crypto/tinyaes_ct.c src/crypto/tinyaes.c"
 	;;
 *)
 	echo "--crypto must be one of: auto, openssl, mbedtls, tinyaes (got '${CRYPTO}')"
@@ -199,7 +238,7 @@ fi
 
 ## Declare sources
 LIBOSDP_SOURCES+=" src/osdp_common.c src/osdp_phy.c src/osdp_sc.c src/osdp_file.c src/osdp_pd.c"
-LIBOSDP_SOURCES+=" src/osdp_cp.c src/osdp_metrics.c"
+LIBOSDP_SOURCES+=" src/osdp_cp.c src/osdp_metrics.c src/osdp_crc.c"
 LIBOSDP_SOURCES+=" utils/src/list.c utils/src/queue.c utils/src/utils.c"
 LIBOSDP_SOURCES+=" utils/src/disjoint_set.c utils/src/crc16.c"
 if [[ -z "${LOG_MINIMAL}" ]]; then
@@ -212,6 +251,18 @@ if [[ ! -z "${PACKET_TRACE}" ]] || [[ ! -z "${DATA_TRACE}" ]]; then
 	LIBOSDP_SOURCES+=" src/osdp_diag.c utils/src/pcap_gen.c"
 fi
 
+if [[ ! -z "${CP_POOL}" ]]; then
+	LIBOSDP_SOURCES+=" src/osdp_cp_pool.c"
+fi
+
+if [[ ! -z "${LINUX_CHANNEL}" ]]; then
+	LIBOSDP_SOURCES+=" src/osdp_channel_linux.c"
+fi
+
+if [[ ! -z "${VIRTUAL_BUS}" ]]; then
+	LIBOSDP_SOURCES+=" src/osdp_vbus.c"
+fi
+
 TARGETS="cp_app pd_app"
 
 TEST_SOURCES="tests/unit-tests/test.c"
@@ -226,6 +277,21 @@ TEST_SOURCES+=" tests/unit-tests/test-hotplug.c"
 TEST_SOURCES+=" tests/unit-tests/test-sc.c"
 TEST_SOURCES+=" tests/unit-tests/test-sc-sia-vectors.c"
 TEST_SOURCES+=" tests/unit-tests/test-notifications.c"
+TEST_SOURCES+=" tests/unit-tests/test-crc.c"
+TEST_SOURCES+=" tests/unit-tests/test-rb.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-pool.c"
+TEST_SOURCES+=" tests/unit-tests/test-wakeup.c"
+TEST_SOURCES+=" tests/unit-tests/test-linux-channel.c"
+TEST_SOURCES+=" tests/unit-tests/test-poll-sched.c"
+TEST_SOURCES+=" tests/unit-tests/test-metrics.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-mpsc.c"
+TEST_SOURCES+=" tests/unit-tests/test-event-ring.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-batch.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-pack.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-template.c"
+TEST_SOURCES+=" tests/unit-tests/test-vbus.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-backoff.c"
+TEST_SOURCES+=" tests/unit-tests/test-cp-secure.c"
 TEST_SOURCES+=" ${LIBOSDP_SOURCES} ${UTILS_SOURCES}"
 
 if [[ ! -z "${LIB_ONLY}" ]]; then
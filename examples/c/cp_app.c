@@ -69,7 +69,8 @@ int main()
 		// your application code.
 
 		osdp_cp_refresh(ctx);
-		// delay();
+		// Sleep until the next library deadline or until the channel
+		// has data, e.g. poll(&fd, 1, osdp_cp_next_wakeup(ctx));
 	}
 	return 0;
 }
@@ -103,7 +103,9 @@ int main()
 		osdp_pd_refresh(ctx);
 
 		// your application code.
-		// delay();
+
+		// Sleep until the next library deadline or until the channel
+		// has data, e.g. poll(&fd, 1, osdp_pd_next_wakeup(ctx));
 	}
 
 	return 0;
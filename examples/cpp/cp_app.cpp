@@ -5,6 +5,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <osdp.hpp>
@@ -71,7 +72,10 @@ int main()
 		// your application code.
 
 		cp.refresh();
-		std::this_thread::sleep_for(std::chrono::microseconds(10 * 1000));
+		// Sleep until the next library deadline. These sample channels
+		// can't signal incoming data, so don't sleep longer than 10ms.
+		std::this_thread::sleep_for(std::chrono::milliseconds(
+			std::min(cp.next_wakeup(), 10)));
 	}
 
 	return 0;
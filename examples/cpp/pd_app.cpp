@@ -5,6 +5,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <osdp.hpp>
@@ -88,7 +89,10 @@ int main()
 		pd.refresh();
 
 		// your application code.
-		std::this_thread::sleep_for(std::chrono::microseconds(10 * 1000));
+		// Sleep until the next library deadline. These sample channels
+		// can't signal incoming data, so don't sleep longer than 10ms.
+		std::this_thread::sleep_for(std::chrono::milliseconds(
+			std::min(pd.next_wakeup(), 10)));
 	}
 
 	return 0;
@@ -844,6 +844,12 @@ enum osdp_cmd_e {
  */
 #define OSDP_CMD_FLAG_BROADCAST 0x000000001
 
+/**
+ * @brief Set by osdp_cp_compile_command() on the command embedded in a
+ * `struct osdp_cmd_template`. Don't set it on a command yourself.
+ */
+#define OSDP_CMD_FLAG_TEMPLATE  0x000000002
+
 /**
  * @brief Queue linkage node; layout-compatible with node_t from list.h.
  * Embedded as @c _node in osdp_cmd and osdp_event. Do not read or write this
@@ -878,6 +884,17 @@ struct osdp_cmd {
 	};
 };
 
+/**
+ * @brief A command with its packet data encoded ahead of time; see
+ * osdp_cp_compile_command(). Only @c cmd is meant to be touched by the app:
+ * submit `&tmpl->cmd` with osdp_cp_submit_command() as often as needed.
+ */
+struct osdp_cmd_template {
+	struct osdp_cmd cmd;   /**< Command to submit; flags has OSDP_CMD_FLAG_TEMPLATE */
+	uint16_t len;          /**< Reserved: length of data */
+	uint8_t data[3 + OSDP_CMD_MFG_MAX_DATALEN]; /**< Reserved: encoded data */
+};
+
 /* ------------------------------- */
 /*          OSDP Events            */
 /* ------------------------------- */
@@ -1085,6 +1102,20 @@ osdp_t *osdp_pd_setup(struct osdp_channel *channel, const osdp_pd_info_t *info);
 OSDP_EXPORT
 void osdp_pd_refresh(osdp_t *ctx);
 
+/**
+ * @brief Time until the PD has timer-driven work to do (SC session expiry,
+ * loss of CP link, partial packet timeout). Event loops can sleep this long
+ * or until the channel becomes readable, whichever comes first, and then
+ * call osdp_pd_refresh().
+ *
+ * @param ctx OSDP context
+ *
+ * @retval milliseconds to the next deadline; 0 if osdp_pd_refresh() should
+ * be called right away. Never more than OSDP_WAKEUP_MAX_MS.
+ */
+OSDP_EXPORT
+int osdp_pd_next_wakeup(const osdp_t *ctx);
+
 /**
  * @brief Cleanup all osdp resources. The context pointer is no longer valid
  * after this call.
@@ -1208,6 +1239,37 @@ int osdp_cp_add_pd(osdp_t *ctx, int num_pd, const osdp_pd_info_t *info);
 OSDP_EXPORT
 void osdp_cp_refresh(osdp_t *ctx);
 
+/**
+ * @brief Earliest deadline across all PDs of this CP (reply timeout, retry
+ * back-off, next POLL, offline retry, file transfer delay). Event loops can
+ * sleep this long or until the channel becomes readable, whichever comes
+ * first, and then call osdp_cp_refresh().
+ *
+ * @param ctx OSDP context
+ *
+ * @retval milliseconds to the next deadline; 0 if osdp_cp_refresh() should
+ * be called right away. Never more than OSDP_WAKEUP_MAX_MS.
+ *
+ * @note Commands submitted after this call are not accounted for; call
+ * osdp_cp_refresh() (or wake the event loop) after osdp_cp_submit_command().
+ */
+OSDP_EXPORT
+int osdp_cp_next_wakeup(const osdp_t *ctx);
+
+/**
+ * @brief Time it took for the bus to become fully secure: from
+ * osdp_cp_setup() (or from the last time a PD lost its secure channel)
+ * until every PD that has a SCBK and is not disabled was online with a
+ * secure channel.
+ *
+ * @param ctx OSDP context
+ *
+ * @retval milliseconds; -1 while some PDs are not secure yet (and always on
+ * a bus where no PD uses secure channel).
+ */
+OSDP_EXPORT
+int osdp_cp_get_time_to_secure(const osdp_t *ctx);
+
 /**
  * @brief Cleanup all osdp resources. The context pointer is no longer valid
  * after this call.
@@ -1249,21 +1311,120 @@ int osdp_cp_send_command(osdp_t *ctx, int pd, const struct osdp_cmd *cmd);
  *
  * @note This method only adds the command on to a particular PD's command
  * queue. The command itself can fail due to various reasons.
+ *
+ * @note Safe to call from any number of threads concurrently with the thread
+ * that calls osdp_cp_refresh(); submission is lock-free. OSDP_CMD_FILE_TX is
+ * the exception and must be submitted from the refresh thread.
  */
 OSDP_EXPORT
 int osdp_cp_submit_command(osdp_t *ctx, int pd, const struct osdp_cmd *cmd);
 
+/**
+ * @brief PD offset passed to the command completion callback for the single
+ * aggregated completion of osdp_cp_submit_commands().
+ */
+#define OSDP_CP_BATCH_PD (-1)
+
+/**
+ * @brief Submit the same commands to several PDs at once, e.g. to flash the
+ * LEDs of every reader in a lobby.
+ *
+ * The commands are checked once, and the whole batch is either accepted for
+ * every selected PD or rejected. Batch entries are sent in place of each PD's
+ * next POLL, so with N PDs selected all of them have the first command after
+ * one pass over the bus.
+ *
+ * Individual entries are not reported to the command completion callback.
+ * Instead, once every entry has completed on every selected PD, the callback
+ * is invoked once with @a pd set to @ref OSDP_CP_BATCH_PD, @a cmd pointing to
+ * @a cmds[0] and @a status set to OSDP_COMPLETION_OK if all of them succeeded
+ * (otherwise the first other status seen).
+ *
+ * @param ctx OSDP context
+ * @param pd_mask PDs to send to; bit i of byte i / 8 selects PD offset i (same
+ * layout as osdp_get_status_mask()). All selected PDs must be online.
+ * @param cmds Array of @a n commands, sent to each PD in this order; entry i
+ * goes out to every selected PD before entry i + 1 goes to any of them. Owned
+ * by the application; must not be modified until the completion is reported.
+ * OSDP_CMD_FILE_TX, OSDP_CMD_KEYSET and command flags are not allowed.
+ * @param n Number of commands in @a cmds; @a n times the number of selected
+ * PDs must fit in an int.
+ *
+ * @retval 0 on success
+ * @retval -1 on failure, including when another batch is still in progress
+ *
+ * @note Only one batch is in flight per context. Like
+ * osdp_cp_submit_command(), this may be called from any thread.
+ */
+OSDP_EXPORT
+int osdp_cp_submit_commands(osdp_t *ctx, const uint8_t *pd_mask,
+			    const struct osdp_cmd *cmds, int n);
+
 /**
  * @brief Deletes all commands queued for a give PD
  *
  * @param ctx OSDP context
  * @param pd PD offset (0-indexed) of this PD in `osdp_pd_info_t *` passed to
  * osdp_cp_setup()
- * @return int Count of events dequeued
+ * @return int Count of events dequeued (including unsent entries of a command
+ * batch, see osdp_cp_submit_commands())
+ *
+ * @note Unlike osdp_cp_submit_command(), this must be called from the thread
+ * that calls osdp_cp_refresh().
  */
 OSDP_EXPORT
 int osdp_cp_flush_commands(osdp_t *ctx, int pd);
 
+/**
+ * @brief Let the CP pack consecutive queued commands of the same kind
+ * (OSDP_CMD_OUTPUT, OSDP_CMD_LED or OSDP_CMD_BUZZER) for this PD into one
+ * multi-record packet, so that they take a single command/reply turn on the
+ * bus. Each packed command still gets its own completion callback; they all
+ * share the outcome of the packet. Turns saved this way are counted in
+ * osdp_metrics::cmd_packed_count.
+ *
+ * @param ctx OSDP context
+ * @param pd PD offset (0-indexed) of this PD in `osdp_pd_info_t *` passed to
+ * osdp_cp_setup()
+ * @param max_records Records per packet, up to OSDP_CP_CMD_PACK_MAX; 0 or 1
+ * (default) sends one command per packet. Fewer are packed when the PD's
+ * receive buffer is too small.
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ *
+ * @note The PD applies the records in order and NAKs the packet at the
+ * first one it rejects; the records before it have taken effect by then.
+ */
+OSDP_EXPORT
+int osdp_cp_set_command_packing(osdp_t *ctx, int pd, int max_records);
+
+/**
+ * @brief Encode a command once for repeated use. Commands sent over and over
+ * with the same contents (a "granted" LED pattern, a "denied" beep) can be
+ * compiled into a template whose packet data is kept ready; sending it then
+ * only builds the packet header, sequence number and CRC/MAC around that
+ * data.
+ *
+ * @param ctx OSDP context
+ * @param cmd Command to compile; one of OSDP_CMD_OUTPUT, OSDP_CMD_LED,
+ * OSDP_CMD_BUZZER, OSDP_CMD_TEXT or OSDP_CMD_MFG with no flags set.
+ * @param tmpl Template to fill; submit `&tmpl->cmd` to any PD of this
+ * context with osdp_cp_submit_command().
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ *
+ * @note Like any other command, a template is referenced (not copied) while
+ * queued, so submit it again only after its completion has been reported.
+ * Changes to `tmpl->cmd` after compiling it are not sent; compile it again.
+ * Templates are never packed with other commands (see
+ * osdp_cp_set_command_packing()).
+ */
+OSDP_EXPORT
+int osdp_cp_compile_command(osdp_t *ctx, const struct osdp_cmd *cmd,
+			    struct osdp_cmd_template *tmpl);
+
 /**
  * @brief Get PD ID information as reported by the PD. Calling this method
  * before the CP has had a the chance to get this information will return
@@ -1309,6 +1470,69 @@ int osdp_cp_get_capability(const osdp_t *ctx, int pd, struct osdp_pd_cap *cap);
 OSDP_EXPORT
 void osdp_cp_set_event_callback(osdp_t *ctx, cp_event_callback_t cb, void *arg);
 
+/**
+ * @brief What the CP does when the event ring is full; see
+ * osdp_cp_set_event_ring().
+ */
+enum osdp_cp_event_overflow {
+	/** Drop events that don't fit; counted in osdp_metrics::event_drop_count */
+	OSDP_CP_EVENT_DROP,
+	/**
+	 * Stop polling PDs while the ring is full so that events stay
+	 * buffered on the PDs. Events that arrive in replies to commands
+	 * can still be dropped.
+	 */
+	OSDP_CP_EVENT_THROTTLE,
+};
+
+/**
+ * @brief One slot of the CP event ring.
+ */
+struct osdp_cp_event {
+	int pd;                  /**< PD offset the event came from */
+	struct osdp_event event; /**< The event, as it would be passed to the callback */
+};
+
+/**
+ * @brief Deliver events through a ring that the application drains with
+ * osdp_cp_poll_events() instead of calling the event callback from inside
+ * osdp_cp_refresh(). A slow consumer then no longer stalls the bus.
+ *
+ * The ring is single-producer/single-consumer: osdp_cp_refresh() fills it
+ * and osdp_cp_poll_events() may drain it from one other thread without any
+ * locking.
+ *
+ * @param ctx OSDP context
+ * @param buf Ring storage; owned by the application and must outlive the
+ * context (or a later call that replaces it). NULL switches back to the
+ * event callback.
+ * @param size Number of slots in @a buf; must be a power of two.
+ * @param policy What to do when the ring is full.
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ *
+ * @note Call this before osdp_cp_refresh() is running on another thread.
+ * With @ref OSDP_CP_EVENT_THROTTLE, a PD that isn't polled for longer than
+ * its online timeout considers the CP lost; drain the ring accordingly.
+ */
+OSDP_EXPORT
+int osdp_cp_set_event_ring(osdp_t *ctx, struct osdp_cp_event *buf, int size,
+			   enum osdp_cp_event_overflow policy);
+
+/**
+ * @brief Take up to @a n events out of the event ring, oldest first.
+ *
+ * @param ctx OSDP context
+ * @param events Destination array
+ * @param n Length of @a events
+ *
+ * @retval number of events copied to @a events (0 if the ring is empty)
+ * @retval -1 if no event ring is set
+ */
+OSDP_EXPORT
+int osdp_cp_poll_events(osdp_t *ctx, struct osdp_cp_event *events, int n);
+
 /**
  * @brief Set callback method for CP command completion.
  *
@@ -1381,6 +1605,546 @@ int osdp_cp_enable_pd(osdp_t *ctx, int pd);
 OSDP_EXPORT
 bool osdp_cp_is_pd_enabled(const osdp_t *ctx, int pd);
 
+/**
+ * @brief Policies that decide how often the CP sends CMD_POLL to an online PD
+ * that has no commands pending. Queued commands are always sent first,
+ * regardless of the policy.
+ */
+enum osdp_cp_poll_policy {
+	/**
+	 * Poll every PD each OSDP_PD_POLL_TIMEOUT_MS (default).
+	 */
+	OSDP_CP_POLL_FIXED,
+	/**
+	 * Double a PD's poll interval for each consecutive idle poll (up to
+	 * OSDP_PD_POLL_IDLE_MAX_MS) and go back to the full rate as soon as it
+	 * reports something or is sent a command. Busy readers get the bus time
+	 * that idle ones give up.
+	 */
+	OSDP_CP_POLL_ACTIVITY,
+	/**
+	 * Poll a PD every OSDP_PD_POLL_TIMEOUT_MS << class; see
+	 * osdp_cp_set_poll_priority().
+	 */
+	OSDP_CP_POLL_PRIORITY,
+	/**
+	 * Poll a PD so that the worst-case time for one of its events to reach
+	 * the CP stays within a per-PD target; see osdp_cp_set_poll_latency().
+	 * The measured time of one round over all PDs of the bus is subtracted
+	 * from the target to get the poll interval.
+	 */
+	OSDP_CP_POLL_LATENCY,
+};
+
+/**
+ * @brief Set the poll scheduling policy for all PDs of this CP context.
+ *
+ * @param ctx OSDP context
+ * @param policy One of enum osdp_cp_poll_policy
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ */
+OSDP_EXPORT
+int osdp_cp_set_poll_policy(osdp_t *ctx, enum osdp_cp_poll_policy policy);
+
+/**
+ * @brief Set the priority class used by OSDP_CP_POLL_PRIORITY for a PD. Class
+ * 0 (default) is polled at the full rate; each higher class halves it.
+ *
+ * @param ctx OSDP context
+ * @param pd PD offset (0-indexed) of this PD in `osdp_pd_info_t *` passed to
+ * osdp_cp_setup()
+ * @param priority Class 0 to OSDP_PD_POLL_PRIORITY_MAX
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ */
+OSDP_EXPORT
+int osdp_cp_set_poll_priority(osdp_t *ctx, int pd, int priority);
+
+/**
+ * @brief Set the event latency target used by OSDP_CP_POLL_LATENCY for a PD.
+ *
+ * @param ctx OSDP context
+ * @param pd PD offset (0-indexed) of this PD in `osdp_pd_info_t *` passed to
+ * osdp_cp_setup()
+ * @param latency_ms Target in milliseconds; 0 (default) polls at the fixed
+ * rate. Targets the bus can't meet poll every OSDP_PD_POLL_MIN_MS.
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ */
+OSDP_EXPORT
+int osdp_cp_set_poll_latency(osdp_t *ctx, int pd, int latency_ms);
+
+/* ------------------------------- */
+/*       CP Multi-bus Methods      */
+/* ------------------------------- */
+
+/**
+ * @brief Describes one bus (a channel and the PDs connected to it) managed by
+ * a multi-bus CP pool. See osdp_cp_pool_setup().
+ */
+struct osdp_cp_bus_info {
+	/**
+	 * Channel ops for this bus. Each bus must have its own channel.
+	 */
+	const struct osdp_channel *channel;
+	/**
+	 * Number of PDs on this bus.
+	 */
+	int num_pd;
+	/**
+	 * Array of num_pd PD descriptors for this bus.
+	 */
+	const osdp_pd_info_t *info;
+};
+
+/**
+ * @brief Opaque handle for a multi-bus CP pool.
+ */
+typedef void osdp_cp_pool_t;
+
+/**
+ * @brief Callback for CP events coming from a multi-bus pool. Same as
+ * `cp_event_callback_t` with the bus index added.
+ *
+ * @param arg Opaque pointer provided by the application during callback
+ * registration.
+ * @param bus Bus offset (0-indexed) in the `struct osdp_cp_bus_info *` passed
+ * to osdp_cp_pool_setup()
+ * @param pd PD offset (0-indexed) on that bus
+ * @param ev pointer to osdp_event struct (filled by libosdp).
+ *
+ * @retval 0 on handling the event successfully.
+ * @retval -ve on errors.
+ */
+typedef int (*cp_pool_event_callback_t)(void *arg, int bus, int pd,
+					struct osdp_event *ev);
+
+/**
+ * @brief Callback for command completions coming from a multi-bus pool. Same
+ * as `cp_command_completion_callback_t` with the bus index added.
+ */
+typedef void (*cp_pool_command_completion_callback_t)(void *arg, int bus,
+				int pd, const struct osdp_cmd *cmd,
+				enum osdp_completion_status status);
+
+/**
+ * @brief Setup a CP that drives several independent buses in parallel. One
+ * CP context is created per bus and the buses are distributed over a pool of
+ * worker threads that refresh them; the application does not have to call
+ * osdp_cp_refresh().
+ *
+ * Events and command completions from all buses are merged into a single
+ * queue which is drained by osdp_cp_pool_dispatch() on the application's
+ * thread, so the callbacks never run concurrently with each other.
+ *
+ * @param num_bus Number of buses; `bus` is treated as an array of this length.
+ * @param bus Bus descriptors.
+ * @param num_workers Number of worker threads. Values <= 0 pick one thread
+ * per online CPU. Never more than num_bus threads are started.
+ *
+ * @retval Pool handle on success
+ * @retval NULL on errors
+ *
+ * @note Available only when LibOSDP is built with OPT_OSDP_CP_POOL (hosted
+ * builds with pthreads).
+ */
+OSDP_EXPORT
+osdp_cp_pool_t *osdp_cp_pool_setup(int num_bus,
+				   const struct osdp_cp_bus_info *bus,
+				   int num_workers);
+
+/**
+ * @brief Stop all workers and tear down every bus of the pool. Pending
+ * completions (including OSDP_COMPLETION_ABORTED ones generated during
+ * teardown) are dispatched on the calling thread before this returns.
+ *
+ * @param pool Pool handle
+ */
+OSDP_EXPORT
+void osdp_cp_pool_teardown(osdp_cp_pool_t *pool);
+
+/**
+ * @brief Set the event callback for all buses of the pool.
+ *
+ * @param pool Pool handle
+ * @param cb The callback function's pointer
+ * @param arg A pointer that will be passed as the first argument of `cb`
+ */
+OSDP_EXPORT
+void osdp_cp_pool_set_event_callback(osdp_cp_pool_t *pool,
+				     cp_pool_event_callback_t cb, void *arg);
+
+/**
+ * @brief Set the command completion callback for all buses of the pool.
+ *
+ * @param pool Pool handle
+ * @param cb The callback function's pointer
+ * @param arg A pointer that will be passed as the first argument of `cb`
+ */
+OSDP_EXPORT
+void osdp_cp_pool_set_command_completion_callback(osdp_cp_pool_t *pool,
+				cp_pool_command_completion_callback_t cb,
+				void *arg);
+
+/**
+ * @brief Submit a command to a PD on any bus of the pool. Safe to call from
+ * any thread.
+ *
+ * @param pool Pool handle
+ * @param bus Bus offset (0-indexed)
+ * @param pd PD offset (0-indexed) on that bus
+ * @param cmd command pointer. Must be filled by application.
+ *
+ * @retval 0 on success
+ * @retval -1 on failure
+ *
+ * @note As with osdp_cp_submit_command(), @a cmd is queued by reference and
+ * must not be reused until its completion has been dispatched.
+ */
+OSDP_EXPORT
+int osdp_cp_pool_submit_command(osdp_cp_pool_t *pool, int bus, int pd,
+				const struct osdp_cmd *cmd);
+
+/**
+ * @brief Deliver queued events and command completions from all buses to the
+ * registered callbacks. Must be called by the application periodically, from
+ * a single thread.
+ *
+ * @param pool Pool handle
+ * @param timeout_ms Time to wait for the first entry when the queue is empty;
+ * 0 returns immediately and -ve waits forever.
+ *
+ * @retval Number of entries dispatched
+ */
+OSDP_EXPORT
+int osdp_cp_pool_dispatch(osdp_cp_pool_t *pool, int timeout_ms);
+
+/**
+ * @brief Lock and get the CP context that drives a given bus. Until it is
+ * released with osdp_cp_pool_put_ctx(), the bus is not refreshed and any
+ * osdp_cp_*() method other than refresh and teardown may be called on the
+ * context. Hold it only briefly; replies that are due are not read
+ * meanwhile.
+ *
+ * @param pool Pool handle
+ * @param bus Bus offset (0-indexed)
+ *
+ * @retval OSDP context on success
+ * @retval NULL on errors
+ */
+OSDP_EXPORT
+osdp_t *osdp_cp_pool_get_ctx(osdp_cp_pool_t *pool, int bus);
+
+/**
+ * @brief Release a context obtained with osdp_cp_pool_get_ctx().
+ *
+ * @param pool Pool handle
+ * @param bus Bus offset (0-indexed)
+ */
+OSDP_EXPORT
+void osdp_cp_pool_put_ctx(osdp_cp_pool_t *pool, int bus);
+
+/* ------------------------------- */
+/*      Linux Channel Methods      */
+/* ------------------------------- */
+
+/**
+ * @brief Opaque handle for a set of Linux channels that share one epoll
+ * instance. See osdp_channel_loop_create().
+ */
+typedef void osdp_channel_loop_t;
+
+/**
+ * @brief Create an (epoll based) event loop that ready-made Linux channels
+ * can be attached to. A loop can hold any number of channels, and is meant to
+ * be driven by a single thread.
+ *
+ * @retval Loop handle on success
+ * @retval NULL on errors
+ *
+ * @note Available only when LibOSDP is built with OPT_OSDP_LINUX_CHANNEL.
+ */
+OSDP_EXPORT
+osdp_channel_loop_t *osdp_channel_loop_create(void);
+
+/**
+ * @brief Destroy a channel loop. Channels attached to it are closed by
+ * LibOSDP when their context is torn down, so do that first.
+ *
+ * @param loop Loop handle
+ */
+OSDP_EXPORT
+void osdp_channel_loop_destroy(osdp_channel_loop_t *loop);
+
+/**
+ * @brief Get the epoll fd of the loop. It becomes readable when any attached
+ * channel has I/O pending, so it can be nested in the application's own
+ * poll()/epoll set; call osdp_channel_loop_wait() with 0 timeout when it does.
+ *
+ * @param loop Loop handle
+ *
+ * @retval file descriptor
+ */
+OSDP_EXPORT
+int osdp_channel_loop_fd(osdp_channel_loop_t *loop);
+
+/**
+ * @brief Wait for I/O on any attached channel and service it: receive data is
+ * read into the channel's buffer with one read() per ready fd and any TX
+ * backlog is written out. Typical use:
+ *
+ * @code
+ * while (1) {
+ *         osdp_channel_loop_wait(loop, osdp_cp_next_wakeup(ctx));
+ *         osdp_cp_refresh(ctx);
+ * }
+ * @endcode
+ *
+ * @param loop Loop handle
+ * @param timeout_ms Max time to wait; 0 returns immediately, -ve waits
+ * forever.
+ *
+ * @retval Number of channels with receive data (or an error) to look at
+ * @retval -1 on errors
+ *
+ * @note Channels only read from their fd after the loop has seen it become
+ * readable, so this method must be called between refreshes.
+ */
+OSDP_EXPORT
+int osdp_channel_loop_wait(osdp_channel_loop_t *loop, int timeout_ms);
+
+/**
+ * @brief Populate @a channel with methods that operate on an already open
+ * stream fd (an accepted socket, a pty, etc.,) and attach it to @a loop. The
+ * fd is made non-blocking and is owned by the channel from here on; it is
+ * closed through osdp_channel::close when the OSDP context is torn down.
+ *
+ * @param loop Loop handle
+ * @param channel Channel to populate
+ * @param fd Stream file descriptor
+ *
+ * @retval 0 on success
+ * @retval -1 on errors
+ */
+OSDP_EXPORT
+int osdp_channel_open_fd(osdp_channel_loop_t *loop,
+			 struct osdp_channel *channel, int fd);
+
+/**
+ * @brief Open a serial port in raw 8N1 mode and attach it to @a loop.
+ *
+ * @param loop Loop handle
+ * @param channel Channel to populate
+ * @param device Path to the tty device (eg., /dev/ttyUSB0)
+ * @param baud_rate One of 9600/19200/38400/57600/115200/230400
+ *
+ * @retval 0 on success
+ * @retval -1 on errors
+ */
+OSDP_EXPORT
+int osdp_channel_open_serial(osdp_channel_loop_t *loop,
+			     struct osdp_channel *channel,
+			     const char *device, int baud_rate);
+
+/**
+ * @brief Connect to a TCP endpoint (eg., a serial-over-IP gateway) and attach
+ * the connection to @a loop. The connect itself is blocking.
+ *
+ * @param loop Loop handle
+ * @param channel Channel to populate
+ * @param host Host name or address
+ * @param port TCP port
+ *
+ * @retval 0 on success
+ * @retval -1 on errors
+ */
+OSDP_EXPORT
+int osdp_channel_open_tcp(osdp_channel_loop_t *loop,
+			  struct osdp_channel *channel,
+			  const char *host, int port);
+
+/**
+ * @brief Connect to a Unix stream socket and attach it to @a loop.
+ *
+ * @param loop Loop handle
+ * @param channel Channel to populate
+ * @param path Socket path
+ *
+ * @retval 0 on success
+ * @retval -1 on errors
+ */
+OSDP_EXPORT
+int osdp_channel_open_unix(osdp_channel_loop_t *loop,
+			   struct osdp_channel *channel, const char *path);
+
+/**
+ * @brief Get the file descriptor behind a channel populated by one of the
+ * osdp_channel_open_*() methods.
+ *
+ * @param channel Channel populated by osdp_channel_open_*()
+ *
+ * @retval file descriptor
+ */
+OSDP_EXPORT
+int osdp_channel_get_fd(const struct osdp_channel *channel);
+
+/* ------------------------------- */
+/*       Virtual Bus Methods       */
+/* ------------------------------- */
+
+/**
+ * @brief Describes a simulated RS-485 multi-drop bus. See osdp_vbus_create().
+ */
+struct osdp_vbus_config {
+	/**
+	 * Line rate used to time each byte (10 bits per byte, 8N1). 0 delivers
+	 * bytes without any wire time.
+	 */
+	int baud_rate;
+	/**
+	 * Delay between a node handing bytes to send() and the first bit going
+	 * out on the wire (driver enable/turnaround time) in microseconds.
+	 */
+	int turnaround_us;
+	/**
+	 * Probability, in parts per million, that a byte on the wire is lost.
+	 */
+	uint32_t drop_ppm;
+	/**
+	 * Probability, in parts per million, that a byte on the wire has one
+	 * of its bits flipped.
+	 */
+	uint32_t flip_ppm;
+	/**
+	 * Seed for the impairment generator; runs with the same seed (and the
+	 * same sequence of calls) see the same drops and bit flips.
+	 */
+	uint32_t seed;
+	/**
+	 * When set, LibOSDP's notion of time (osdp_millis_now()) is taken from
+	 * this bus and only moves when osdp_vbus_advance() is called. This
+	 * applies to every context in the process, so only one bus can own the
+	 * clock at a time.
+	 */
+	bool virtual_clock;
+};
+
+/**
+ * @brief Counters maintained by a virtual bus.
+ */
+struct osdp_vbus_stats {
+	uint64_t bytes_sent;     /**< Bytes put on the wire by all nodes */
+	uint64_t bytes_dropped;  /**< Bytes lost to drop_ppm */
+	uint64_t bits_flipped;   /**< Bytes corrupted by flip_ppm */
+	uint64_t collisions;     /**< Frames that overlapped another on the wire */
+	uint64_t rx_overflows;   /**< Bytes lost to a full node RX FIFO */
+};
+
+/**
+ * @brief Opaque handle for a virtual bus.
+ */
+typedef void osdp_vbus_t;
+
+/**
+ * @brief Create an in-memory RS-485 bus simulator. Any number of CP and PD
+ * contexts (up to OSDP_VBUS_MAX_NODES) can be attached to it with
+ * osdp_vbus_attach(). Like a real multi-drop line, every byte sent by one
+ * node is seen by all the others; frames sent by two nodes at the same time
+ * corrupt each other.
+ *
+ * Nothing moves on the bus until osdp_vbus_advance() is called, so a test
+ * or load generator drives it like this:
+ *
+ * @code
+ * while (1) {
+ *         osdp_cp_refresh(cp);
+ *         for (i = 0; i < num_pd; i++)
+ *                 osdp_pd_refresh(pd[i]);
+ *         osdp_vbus_advance(bus, 100);
+ * }
+ * @endcode
+ *
+ * @param config Bus description
+ *
+ * @retval Bus handle on success
+ * @retval NULL on errors
+ *
+ * @note Available only when LibOSDP is built with OPT_OSDP_VIRTUAL_BUS.
+ */
+OSDP_EXPORT
+osdp_vbus_t *osdp_vbus_create(const struct osdp_vbus_config *config);
+
+/**
+ * @brief Destroy a virtual bus. Tear down the contexts attached to it first.
+ *
+ * @param bus Bus handle
+ */
+OSDP_EXPORT
+void osdp_vbus_destroy(osdp_vbus_t *bus);
+
+/**
+ * @brief Add a node to @a bus and populate @a channel with methods that send
+ * and receive through it. The node leaves the bus when the context using the
+ * channel is torn down (osdp_channel::close).
+ *
+ * @param bus Bus handle
+ * @param channel Channel to populate
+ *
+ * @retval 0 on success
+ * @retval -1 on errors
+ */
+OSDP_EXPORT
+int osdp_vbus_attach(osdp_vbus_t *bus, struct osdp_channel *channel);
+
+/**
+ * @brief Move bus time forward by @a us microseconds, delivering every byte
+ * that finishes its wire time in that window to the other nodes' RX FIFOs.
+ *
+ * @param bus Bus handle
+ * @param us Microseconds to advance
+ *
+ * @retval Number of bytes delivered
+ */
+OSDP_EXPORT
+int osdp_vbus_advance(osdp_vbus_t *bus, uint32_t us);
+
+/**
+ * @brief Time until the earliest frame on the wire has been fully delivered.
+ * Along with osdp_cp_next_wakeup() and osdp_pd_next_wakeup() this lets a
+ * simulation jump straight to the next point where something can happen
+ * instead of advancing the bus in small fixed steps.
+ *
+ * @param bus Bus handle
+ *
+ * @retval microseconds to the next frame end; 0 if one is already due
+ * @retval -1 when the wire is idle
+ */
+OSDP_EXPORT
+int osdp_vbus_next_event_us(osdp_vbus_t *bus);
+
+/**
+ * @brief Get the current bus time in microseconds.
+ *
+ * @param bus Bus handle
+ *
+ * @retval bus time
+ */
+OSDP_EXPORT
+uint64_t osdp_vbus_now_us(osdp_vbus_t *bus);
+
+/**
+ * @brief Get a snapshot of the bus counters.
+ *
+ * @param bus Bus handle
+ * @param stats Output
+ */
+OSDP_EXPORT
+void osdp_vbus_get_stats(osdp_vbus_t *bus, struct osdp_vbus_stats *stats);
+
 /* ------------------------------- */
 /*          Common Methods         */
 /* ------------------------------- */
@@ -1496,6 +2260,14 @@ void osdp_get_status_mask(const osdp_t *ctx, uint8_t *bitmask);
 OSDP_EXPORT
 void osdp_get_sc_status_mask(const osdp_t *ctx, uint8_t *bitmask);
 
+/**
+ * @brief Number of buckets in the latency histograms of struct osdp_metrics.
+ * Bucket 0 counts samples under 1 ms, bucket i (0 < i < N - 1) counts samples
+ * in [2^(i-1), 2^i) ms and the last bucket everything from 2^(N-2) ms (256 ms)
+ * up.
+ */
+#define OSDP_METRICS_HIST_BUCKETS 10
+
 /**
  * @brief Link/protocol health counters accumulated since the last
  * @ref osdp_get_metrics() call.
@@ -1516,7 +2288,9 @@ struct osdp_metrics {
 	 * Packets received with a well-formed frame. Frames that failed
 	 * the CRC/checksum integrity check are still counted here; only
 	 * frames rejected earlier (bad SOM, bad length, bad direction
-	 * bit, etc.) are excluded.
+	 * bit, etc.) are excluded. Packets meant for someone else are
+	 * counted in packets_observed instead (other PDs' commands only
+	 * with OPT_OSDP_EARLY_ADDRESS_FILTER).
 	 */
 	uint32_t packets_received;
 	/**
@@ -1539,6 +2313,114 @@ struct osdp_metrics {
 	uint32_t command_count;
 	/** Events dispatched to the application callback. */
 	uint32_t event_count;
+	/** Encrypted (SCS_17/SCS_18) packets built on this context. */
+	uint32_t sc_sealed_count;
+	/**
+	 * CPU cycles spent encrypting and MAC-ing the packets counted in
+	 * @ref sc_sealed_count; divide the two for a per-packet cost. Stays
+	 * 0 on targets without a cycle counter.
+	 */
+	uint32_t sc_seal_cycles;
+	/** Encrypted (SCS_17/SCS_18) packets verified and decrypted. */
+	uint32_t sc_opened_count;
+	/** CPU cycles spent on the packets counted in @ref sc_opened_count. */
+	uint32_t sc_open_cycles;
+	/** CMD_POLL sent to this PD (CP mode only). */
+	uint32_t poll_count;
+	/** Polls in @ref poll_count that the PD answered with a bare ACK. */
+	uint32_t poll_idle_count;
+	/**
+	 * Current poll interval chosen by the poll scheduler for this PD.
+	 * This is a gauge; it is not reset by @ref osdp_get_metrics().
+	 */
+	uint32_t poll_interval_ms;
+	/**
+	 * Smoothed time from sending a command to this PD until its reply
+	 * was received. Also a gauge.
+	 */
+	uint32_t poll_rtt_ms;
+	/** Bytes handed to the channel for this PD (incl. mark byte). */
+	uint32_t tx_bytes;
+	/**
+	 * Bytes read from the channel while servicing this PD. On a shared
+	 * bus this includes noise and bytes that turned out not to be part
+	 * of a valid packet.
+	 */
+	uint32_t rx_bytes;
+	/**
+	 * Estimated time on the wire for @ref tx_bytes + @ref rx_bytes at
+	 * the PD's baud rate, assuming 10 bits per byte (8N1).
+	 */
+	uint32_t wire_time_us;
+	/**
+	 * Time the bus was held by completed command/reply exchanges with
+	 * this PD (CP mode only). Summed over all PDs of a bus and divided
+	 * by the sampling interval, this is the bus utilisation.
+	 */
+	uint32_t bus_busy_ms;
+	/**
+	 * Histogram of the time from a command being sent until the first
+	 * byte of the reply was seen (CP mode only). This includes the
+	 * command's own time on the wire.
+	 */
+	uint32_t turnaround_hist[OSDP_METRICS_HIST_BUCKETS];
+	/**
+	 * Histogram of the time from a command being sent until a valid
+	 * reply was received (CP mode only).
+	 */
+	uint32_t rtt_hist[OSDP_METRICS_HIST_BUCKETS];
+	/**
+	 * Events from this PD discarded because the CP event ring was full
+	 * (see osdp_cp_set_event_ring()).
+	 */
+	uint32_t event_drop_count;
+	/**
+	 * Highest event ring occupancy seen when queuing an event from this
+	 * PD, including that event. Compare with the ring size to tell how
+	 * close the consumer came to falling behind.
+	 */
+	uint32_t event_ring_hwm;
+	/**
+	 * Commands that were sent as an extra record of another command's
+	 * packet; i.e. bus turns saved by osdp_cp_set_command_packing().
+	 */
+	uint32_t cmd_packed_count;
+	/**
+	 * Received bytes dropped without being decoded: line noise skipped
+	 * while looking for the start of a packet, and whole packets skipped
+	 * by their length field because they were not meant for this end
+	 * (e.g. other PDs' replies seen by a PD on a multi-drop bus).
+	 */
+	uint32_t rx_discarded_bytes;
+	/**
+	 * Well-formed packets seen on the bus that were meant for someone
+	 * else and skipped without an integrity check: in PD mode, replies
+	 * from other PDs (and, with OPT_OSDP_EARLY_ADDRESS_FILTER, commands
+	 * for them); in CP mode, commands from another CP.
+	 */
+	uint32_t packets_observed;
+	/**
+	 * Reconnect probes sent while this PD was offline (CP mode only).
+	 * Each probe is a single CMD_POLL that is not retried.
+	 */
+	uint32_t probe_count;
+	/** Times this PD came back online after being lost (CP mode only). */
+	uint32_t recover_count;
+	/**
+	 * Time from losing this PD until it was back online, summed over
+	 * @ref recover_count; divide the two for the mean time to recover.
+	 */
+	uint32_t recover_time_ms;
+	/**
+	 * SC handshakes that found the expanded SCBK schedule of this PD
+	 * already cached.
+	 */
+	uint32_t sc_key_cache_hits;
+	/**
+	 * Times the SCBK schedule had to be expanded because
+	 * it was not cached yet or the key changed since it was.
+	 */
+	uint32_t sc_key_cache_misses;
 };
 
 /**
@@ -112,6 +112,11 @@ public:
 		osdp_cp_refresh(_ctx);
 	}
 
+	int next_wakeup()
+	{
+		return osdp_cp_next_wakeup(_ctx);
+	}
+
 	[[deprecated]]
 	int send_command(int pd, const struct osdp_cmd *cmd)
 	{
@@ -123,6 +128,18 @@ public:
 		return osdp_cp_submit_command(_ctx, pd, cmd);
 	}
 
+	int submit_commands(const uint8_t *pd_mask, const struct osdp_cmd *cmds,
+			    int n)
+	{
+		return osdp_cp_submit_commands(_ctx, pd_mask, cmds, n);
+	}
+
+	int compile_command(const struct osdp_cmd *cmd,
+			    struct osdp_cmd_template *tmpl)
+	{
+		return osdp_cp_compile_command(_ctx, cmd, tmpl);
+	}
+
 	int flush_commands(int pd)
 	{
 		return osdp_cp_flush_commands(_ctx, pd);
@@ -133,6 +150,17 @@ public:
 		osdp_cp_set_event_callback(_ctx, cb, arg);
 	}
 
+	int set_event_ring(struct osdp_cp_event *buf, int size,
+			   enum osdp_cp_event_overflow policy)
+	{
+		return osdp_cp_set_event_ring(_ctx, buf, size, policy);
+	}
+
+	int poll_events(struct osdp_cp_event *events, int n)
+	{
+		return osdp_cp_poll_events(_ctx, events, n);
+	}
+
 	void set_command_completion_callback(cp_command_completion_callback_t cb,
 					     void *arg)
 	{
@@ -169,6 +197,26 @@ public:
 		return osdp_cp_is_pd_enabled(_ctx, pd);
 	}
 
+	int set_poll_policy(enum osdp_cp_poll_policy policy)
+	{
+		return osdp_cp_set_poll_policy(_ctx, policy);
+	}
+
+	int set_poll_priority(int pd, int priority)
+	{
+		return osdp_cp_set_poll_priority(_ctx, pd, priority);
+	}
+
+	int set_poll_latency(int pd, int latency_ms)
+	{
+		return osdp_cp_set_poll_latency(_ctx, pd, latency_ms);
+	}
+
+	int set_command_packing(int pd, int max_records)
+	{
+		return osdp_cp_set_command_packing(_ctx, pd, max_records);
+	}
+
 };
 
 class OSDP_EXPORT PeripheralDevice : public Common {
@@ -201,6 +249,11 @@ public:
 		osdp_pd_refresh(_ctx);
 	}
 
+	int next_wakeup()
+	{
+		return osdp_pd_next_wakeup(_ctx);
+	}
+
 	void set_capabilities(const struct osdp_pd_cap *cap)
 	{
 		osdp_pd_set_capabilities(_ctx, cap);
@@ -48,7 +48,10 @@ class ControlPanel():
         while not event.is_set():
             with lock:
                 ctx.refresh()
-            time.sleep(0.020) #sleep for 20ms
+                wakeup_ms = ctx.next_wakeup()
+            # Python channels can't signal incoming data; keep the
+            # 20ms ceiling but don't sleep past a library deadline.
+            event.wait(min(wakeup_ms, 20) / 1000)
 
     def set_event_handler(self, handler: Callable[[int, dict], int]):
         """Set user event handler while maintaining queue functionality"""
@@ -41,7 +41,10 @@ class PeripheralDevice():
         while not event.is_set():
             with lock:
                 ctx.refresh()
-            time.sleep(0.020) #sleep for 20ms
+                wakeup_ms = ctx.next_wakeup()
+            # Python channels can't signal incoming data; keep the
+            # 20ms ceiling but don't sleep past a library deadline.
+            event.wait(min(wakeup_ms, 20) / 1000)
 
     def _internal_command_handler(self, command) -> Tuple[int, dict]:
         """Internal handler that manages both queue and user callback"""
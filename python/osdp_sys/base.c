@@ -170,7 +170,41 @@ static PyObject *pyosdp_get_metrics(pyosdp_base_t *self, PyObject *args)
 	    pyosdp_dict_add_int(dict, "sc_handshake_count", metrics.sc_handshake_count) ||
 	    pyosdp_dict_add_int(dict, "sc_failure_count", metrics.sc_failure_count) ||
 	    pyosdp_dict_add_int(dict, "command_count", metrics.command_count) ||
-	    pyosdp_dict_add_int(dict, "event_count", metrics.event_count)) {
+	    pyosdp_dict_add_int(dict, "event_count", metrics.event_count) ||
+	    pyosdp_dict_add_int(dict, "sc_sealed_count", metrics.sc_sealed_count) ||
+	    pyosdp_dict_add_int(dict, "sc_seal_cycles", metrics.sc_seal_cycles) ||
+	    pyosdp_dict_add_int(dict, "sc_opened_count", metrics.sc_opened_count) ||
+	    pyosdp_dict_add_int(dict, "sc_open_cycles", metrics.sc_open_cycles) ||
+	    pyosdp_dict_add_int(dict, "poll_count", metrics.poll_count) ||
+	    pyosdp_dict_add_int(dict, "poll_idle_count", metrics.poll_idle_count) ||
+	    pyosdp_dict_add_int(dict, "poll_interval_ms", metrics.poll_interval_ms) ||
+	    pyosdp_dict_add_int(dict, "poll_rtt_ms", metrics.poll_rtt_ms) ||
+	    pyosdp_dict_add_int(dict, "tx_bytes", metrics.tx_bytes) ||
+	    pyosdp_dict_add_int(dict, "rx_bytes", metrics.rx_bytes) ||
+	    pyosdp_dict_add_int(dict, "wire_time_us", metrics.wire_time_us) ||
+	    pyosdp_dict_add_int(dict, "bus_busy_ms", metrics.bus_busy_ms) ||
+	    pyosdp_dict_add_u32_list(dict, "turnaround_hist",
+				     metrics.turnaround_hist,
+				     OSDP_METRICS_HIST_BUCKETS) ||
+	    pyosdp_dict_add_u32_list(dict, "rtt_hist", metrics.rtt_hist,
+				     OSDP_METRICS_HIST_BUCKETS) ||
+	    pyosdp_dict_add_int(dict, "event_drop_count",
+				metrics.event_drop_count) ||
+	    pyosdp_dict_add_int(dict, "event_ring_hwm", metrics.event_ring_hwm) ||
+	    pyosdp_dict_add_int(dict, "cmd_packed_count",
+				metrics.cmd_packed_count) ||
+	    pyosdp_dict_add_int(dict, "rx_discarded_bytes",
+				metrics.rx_discarded_bytes) ||
+	    pyosdp_dict_add_int(dict, "packets_observed",
+				metrics.packets_observed) ||
+	    pyosdp_dict_add_int(dict, "probe_count", metrics.probe_count) ||
+	    pyosdp_dict_add_int(dict, "recover_count", metrics.recover_count) ||
+	    pyosdp_dict_add_int(dict, "recover_time_ms",
+				metrics.recover_time_ms) ||
+	    pyosdp_dict_add_int(dict, "sc_key_cache_hits",
+				metrics.sc_key_cache_hits) ||
+	    pyosdp_dict_add_int(dict, "sc_key_cache_misses",
+				metrics.sc_key_cache_misses)) {
 		Py_DECREF(dict);
 		Py_RETURN_NONE;
 	}
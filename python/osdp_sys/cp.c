@@ -180,6 +180,15 @@ static PyObject *pyosdp_cp_refresh(pyosdp_cp_t *self, pyosdp_cp_t *args)
 	Py_RETURN_NONE;
 }
 
+#define pyosdp_cp_next_wakeup_doc                                               \
+	"Milliseconds until refresh() has timer-driven work to do\n"            \
+	"\n"                                                                    \
+	"@return int; 0 means call refresh() now\n"
+static PyObject *pyosdp_cp_next_wakeup(pyosdp_cp_t *self, PyObject *args)
+{
+	return Py_BuildValue("i", osdp_cp_next_wakeup(self->ctx));
+}
+
 #define pyosdp_cp_get_pd_id_doc                                                \
 	"Get PD_ID info as reported by the PD\n"                               \
 	"\n"                                                                   \
@@ -609,6 +618,8 @@ static PyGetSetDef pyosdp_cp_tp_getset[] = {
 static PyMethodDef pyosdp_cp_tp_methods[] = {
 	{ "refresh", (PyCFunction)pyosdp_cp_refresh,
 	  METH_NOARGS, pyosdp_cp_refresh_doc },
+	{ "next_wakeup", (PyCFunction)pyosdp_cp_next_wakeup,
+	  METH_NOARGS, pyosdp_cp_next_wakeup_doc },
 	{ "set_event_callback", (PyCFunction)pyosdp_cp_set_event_callback,
 	  METH_VARARGS, pyosdp_cp_set_event_callback_doc },
 	{ "set_command_completion_callback", (PyCFunction)pyosdp_cp_set_command_completion_callback,
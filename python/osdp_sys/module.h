@@ -85,6 +85,8 @@ int pyosdp_dict_get_object(PyObject *dict, const char *key, PyObject **obj);
 int pyosdp_dict_add_bool(PyObject *dict, const char *key, bool val);
 int pyosdp_dict_add_int(PyObject *dict, const char *key, int val);
 int pyosdp_dict_add_str(PyObject *dict, const char *key, const char *val);
+int pyosdp_dict_add_u32_list(PyObject *dict, const char *key,
+			     const uint32_t *vals, int n);
 int pyosdp_dict_add_bytes(PyObject *dict, const char *key, const uint8_t *data,
 			  int len);
 void pyosdp_get_channel(PyObject *channel, struct osdp_channel *ops);
@@ -240,6 +240,15 @@ static PyObject *pyosdp_pd_refresh(pyosdp_pd_t *self, PyObject *args)
 	Py_RETURN_NONE;
 }
 
+#define pyosdp_pd_next_wakeup_doc                                               \
+	"Milliseconds until refresh() has timer-driven work to do\n"            \
+	"\n"                                                                    \
+	"@return int; 0 means call refresh() now\n"
+static PyObject *pyosdp_pd_next_wakeup(pyosdp_pd_t *self, PyObject *args)
+{
+	return Py_BuildValue("i", osdp_pd_next_wakeup(self->ctx));
+}
+
 static int pyosdp_pd_tp_clear(pyosdp_pd_t *self)
 {
 	Py_XDECREF(self->command_cb);
@@ -466,6 +475,8 @@ static PyGetSetDef pyosdp_pd_tp_getset[] = {
 static PyMethodDef pyosdp_pd_tp_methods[] = {
 	{ "refresh", (PyCFunction)pyosdp_pd_refresh,
 	  METH_NOARGS, pyosdp_pd_refresh_doc },
+	{ "next_wakeup", (PyCFunction)pyosdp_pd_next_wakeup,
+	  METH_NOARGS, pyosdp_pd_next_wakeup_doc },
 	{ "set_command_callback", (PyCFunction)pyosdp_pd_set_command_callback,
 	  METH_VARARGS, pyosdp_pd_set_command_callback_doc },
 	{ "set_event_completion_callback", (PyCFunction)pyosdp_pd_set_event_completion_callback,
@@ -68,6 +68,28 @@ int pyosdp_dict_add_str(PyObject *dict, const char *key, const char *val)
 	return ret;
 }
 
+int pyosdp_dict_add_u32_list(PyObject *dict, const char *key,
+			     const uint32_t *vals, int n)
+{
+	int i, ret;
+	PyObject *obj, *val_obj;
+
+	obj = PyList_New(n);
+	if (obj == NULL)
+		return -1;
+	for (i = 0; i < n; i++) {
+		val_obj = PyLong_FromUnsignedLong(vals[i]);
+		if (val_obj == NULL) {
+			Py_DECREF(obj);
+			return -1;
+		}
+		PyList_SET_ITEM(obj, i, val_obj);
+	}
+	ret = PyDict_SetItemString(dict, key, obj);
+	Py_DECREF(obj);
+	return ret;
+}
+
 int pyosdp_dict_add_bytes(PyObject *dict, const char *key, const uint8_t *data,
 			  int len)
 {
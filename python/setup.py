@@ -134,7 +134,10 @@ lib_sources = [
     "src/osdp_pd.c",
     "src/osdp_cp.c",
     "src/osdp_metrics.c",
+    "src/osdp_crc.c",
     "src/crypto/tinyaes_src.c",
+    "src/crypto/tinyaes_hw.c",
+    "src/crypto/tinyaes_ct.c",
     "src/crypto/tinyaes.c",
 ]
 
@@ -145,6 +148,8 @@ lib_includes = [
     "src/osdp_file.h",
     "src/osdp_metrics.h",
     "src/crypto/tinyaes_src.h",
+    "src/crypto/tinyaes_hw.h",
+    "src/crypto/tinyaes_ct.h",
 ]
 
 osdp_sys_sources = [
@@ -7,6 +7,9 @@
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#ifdef OPT_OSDP_CP_POOL
+#include <pthread.h>
+#endif
 
 #include <mbedtls/aes.h>
 #include <mbedtls/platform_util.h>
@@ -20,17 +23,27 @@
 
 #include <osdp.h>
 
-static mbedtls_aes_context aes_ctx;
+#include "../osdp_common.h"
+
+_Static_assert(sizeof(mbedtls_aes_context) <= OSDP_CRYPT_KEY_CTX_SIZE,
+	       "OSDP_CRYPT_KEY_CTX_SIZE too small for mbedtls_aes_context");
 
 #ifndef MBEDTLS_PSA_CRYPTO_C
 static mbedtls_entropy_context entropy_ctx;
 static mbedtls_ctr_drbg_context ctr_drbg_ctx;
+static bool ctr_drbg_seeded;
+#ifdef OPT_OSDP_CP_POOL
+static pthread_mutex_t ctr_drbg_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
 #endif
 
+/*
+ * The DRBG is shared by every OSDP context in the process, and each secure
+ * channel handshake calls this method (possibly from different CP pool
+ * workers). Seed it only once; it lives until the process exits.
+ */
 void osdp_crypt_setup()
 {
-	mbedtls_aes_init(&aes_ctx);
-
 #ifdef MBEDTLS_PSA_CRYPTO_C
 	psa_status_t status = psa_crypto_init();
 	assert(status == PSA_SUCCESS);
@@ -38,55 +51,151 @@ void osdp_crypt_setup()
 	int rc;
 	const char *version = osdp_get_version();
 
-	mbedtls_entropy_init(&entropy_ctx);
-	mbedtls_ctr_drbg_init(&ctr_drbg_ctx);
-	rc = mbedtls_ctr_drbg_seed(&ctr_drbg_ctx,
-				   mbedtls_entropy_func,
-				   &entropy_ctx,
-				   (const unsigned char *)version,
-				   strlen(version));
-	assert(rc == 0);
+#ifdef OPT_OSDP_CP_POOL
+	pthread_mutex_lock(&ctr_drbg_lock);
+#endif
+	if (!ctr_drbg_seeded) {
+		mbedtls_entropy_init(&entropy_ctx);
+		mbedtls_ctr_drbg_init(&ctr_drbg_ctx);
+		rc = mbedtls_ctr_drbg_seed(&ctr_drbg_ctx,
+					   mbedtls_entropy_func,
+					   &entropy_ctx,
+					   (const unsigned char *)version,
+					   strlen(version));
+		assert(rc == 0);
+		ctr_drbg_seeded = true;
+	}
+#ifdef OPT_OSDP_CP_POOL
+	pthread_mutex_unlock(&ctr_drbg_lock);
+#endif
 #endif
 }
 
+/*
+ * One-shot operations use a stack context so that independent OSDP contexts
+ * can run on different threads (see osdp_cp_pool.c).
+ */
 void osdp_encrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
 {
 	int rc;
+	mbedtls_aes_context aes_ctx;
 
+	mbedtls_aes_init(&aes_ctx);
+	rc = mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
+	assert(rc == 0);
 	if (iv != NULL) {
-		rc = mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-		assert(rc == 0);
 		rc = mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_ENCRYPT,
 					   len, iv, data, data);
 		assert(rc == 0);
 	} else {
 		assert(len <= 16);
-		rc = mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-		assert(rc == 0);
 		rc = mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT,
 					   data, data);
 		assert(rc == 0);
 	}
+	mbedtls_aes_free(&aes_ctx);
 }
 
 void osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
 {
 	int rc;
+	mbedtls_aes_context aes_ctx;
 
+	mbedtls_aes_init(&aes_ctx);
+	rc = mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
+	assert(rc == 0);
 	if (iv != NULL) {
-		rc = mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
-		assert(rc == 0);
 		rc = mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_DECRYPT,
 					   len, iv, data, data);
 		assert(rc == 0);
 	} else {
 		assert(len <= 16);
-		rc = mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
-		assert(rc == 0);
 		rc = mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_DECRYPT,
 					   data, data);
 		assert(rc == 0);
 	}
+	mbedtls_aes_free(&aes_ctx);
+}
+
+void osdp_crypt_key_setup(struct osdp_crypt_key *key, const uint8_t *raw_key,
+			  bool decrypt)
+{
+	int rc;
+	mbedtls_aes_context *ctx = (mbedtls_aes_context *)key->ctx.raw;
+
+	mbedtls_aes_init(ctx);
+	if (decrypt) {
+		rc = mbedtls_aes_setkey_dec(ctx, raw_key, 128);
+	} else {
+		rc = mbedtls_aes_setkey_enc(ctx, raw_key, 128);
+	}
+	assert(rc == 0);
+	key->ready = true;
+}
+
+void osdp_crypt_key_encrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	int rc;
+	mbedtls_aes_context *ctx = (mbedtls_aes_context *)key->ctx.raw;
+
+	assert(key->ready);
+	if (iv != NULL) {
+		rc = mbedtls_aes_crypt_cbc(ctx, MBEDTLS_AES_ENCRYPT,
+					   len, iv, data, data);
+	} else {
+		assert(len <= 16);
+		rc = mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_ENCRYPT,
+					   data, data);
+	}
+	assert(rc == 0);
+}
+
+void osdp_crypt_key_decrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	int rc;
+	mbedtls_aes_context *ctx = (mbedtls_aes_context *)key->ctx.raw;
+
+	assert(key->ready);
+	if (iv != NULL) {
+		rc = mbedtls_aes_crypt_cbc(ctx, MBEDTLS_AES_DECRYPT,
+					   len, iv, data, data);
+	} else {
+		assert(len <= 16);
+		rc = mbedtls_aes_crypt_ecb(ctx, MBEDTLS_AES_DECRYPT,
+					   data, data);
+	}
+	assert(rc == 0);
+}
+
+void osdp_crypt_key_cbc_mac(struct osdp_crypt_key *key, uint8_t *iv,
+			    const uint8_t *data, int len)
+{
+	int rc, chunk;
+	uint8_t scratch[128];
+	mbedtls_aes_context *ctx = (mbedtls_aes_context *)key->ctx.raw;
+
+	assert(key->ready);
+	assert(len % 16 == 0);
+
+	/* mbedtls_aes_crypt_cbc() leaves the last ciphertext block in iv */
+	while (len > 0) {
+		chunk = len > (int)sizeof(scratch) ? (int)sizeof(scratch) : len;
+		rc = mbedtls_aes_crypt_cbc(ctx, MBEDTLS_AES_ENCRYPT,
+					   chunk, iv, data, scratch);
+		assert(rc == 0);
+		data += chunk;
+		len -= chunk;
+	}
+}
+
+void osdp_crypt_key_teardown(struct osdp_crypt_key *key)
+{
+	if (key->ready) {
+		mbedtls_aes_free((mbedtls_aes_context *)key->ctx.raw);
+	}
+	mbedtls_platform_zeroize(key, sizeof(struct osdp_crypt_key));
 }
 
 void osdp_fill_random(uint8_t *buf, int len)
@@ -95,7 +204,15 @@ void osdp_fill_random(uint8_t *buf, int len)
 	psa_status_t status = psa_generate_random(buf, len);
 	assert(status == PSA_SUCCESS);
 #else
-	int rc = mbedtls_ctr_drbg_random(&ctr_drbg_ctx, buf, len);
+	int rc;
+
+#ifdef OPT_OSDP_CP_POOL
+	pthread_mutex_lock(&ctr_drbg_lock);
+#endif
+	rc = mbedtls_ctr_drbg_random(&ctr_drbg_ctx, buf, len);
+#ifdef OPT_OSDP_CP_POOL
+	pthread_mutex_unlock(&ctr_drbg_lock);
+#endif
 	assert(rc == 0);
 #endif
 }
@@ -107,9 +224,5 @@ void osdp_fill_zeros(void *buf, int len)
 
 void osdp_crypt_teardown()
 {
-#ifndef MBEDTLS_PSA_CRYPTO_C
-	mbedtls_ctr_drbg_free(&ctr_drbg_ctx);
-	mbedtls_entropy_free(&entropy_ctx);
-#endif
-	mbedtls_aes_free(&aes_ctx);
+	/* Other contexts may still be using the DRBG; see osdp_crypt_setup() */
 }
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <openssl/evp.h>
 #include <openssl/rand.h>
@@ -13,6 +14,8 @@
 
 #include <utils/utils.h>
 
+#include "../osdp_common.h"
+
 void osdp_crypt_setup()
 {
 }
@@ -100,6 +103,112 @@ void osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int data_len)
 	EVP_CIPHER_CTX_free(ctx);
 }
 
+void osdp_crypt_key_setup(struct osdp_crypt_key *key, const uint8_t *raw_key,
+			  bool decrypt)
+{
+	EVP_CIPHER_CTX *ctx;
+
+	ctx = EVP_CIPHER_CTX_new();
+	if (ctx == NULL) {
+		osdp_openssl_fatal();
+	}
+
+	/**
+	 * The key is bound to a CBC context once; single block ECB requests
+	 * are served by re-arming the same context with a zero IV.
+	 */
+	if (!EVP_CipherInit_ex(ctx, EVP_aes_128_cbc(), NULL, raw_key, NULL,
+			       decrypt ? 0 : 1)) {
+		osdp_openssl_fatal();
+	}
+
+	if (!EVP_CIPHER_CTX_set_padding(ctx, 0)) {
+		osdp_openssl_fatal();
+	}
+
+	key->ctx.ptr = ctx;
+	key->ready = true;
+}
+
+static void osdp_crypt_key_run(struct osdp_crypt_key *key, uint8_t *iv,
+			       uint8_t *data, int data_len)
+{
+	int len;
+	EVP_CIPHER_CTX *ctx = key->ctx.ptr;
+	static const uint8_t zero_iv[16];
+
+	if (iv == NULL) {
+		assert(data_len <= 16);
+		iv = (uint8_t *)zero_iv;
+	}
+
+	/* -1 keeps the direction (and key schedule) set at setup time */
+	if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1)) {
+		osdp_openssl_fatal();
+	}
+
+	if (!EVP_CipherUpdate(ctx, data, &len, data, data_len)) {
+		osdp_openssl_fatal();
+	}
+
+	if (!EVP_CipherFinal_ex(ctx, data + len, &len)) {
+		osdp_openssl_fatal();
+	}
+}
+
+void osdp_crypt_key_encrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	assert(key->ready && EVP_CIPHER_CTX_encrypting(key->ctx.ptr));
+	osdp_crypt_key_run(key, iv, data, len);
+}
+
+void osdp_crypt_key_decrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	assert(key->ready && !EVP_CIPHER_CTX_encrypting(key->ctx.ptr));
+	osdp_crypt_key_run(key, iv, data, len);
+}
+
+void osdp_crypt_key_cbc_mac(struct osdp_crypt_key *key, uint8_t *iv,
+			    const uint8_t *data, int data_len)
+{
+	int len = 0, chunk;
+	uint8_t scratch[128];
+	EVP_CIPHER_CTX *ctx = key->ctx.ptr;
+
+	assert(key->ready && EVP_CIPHER_CTX_encrypting(ctx));
+	assert(data_len % 16 == 0);
+
+	if (data_len <= 0) {
+		return;
+	}
+
+	if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1)) {
+		osdp_openssl_fatal();
+	}
+
+	/* The context carries the CBC chain across updates */
+	while (data_len > 0) {
+		chunk = data_len > (int)sizeof(scratch) ?
+			(int)sizeof(scratch) : data_len;
+		if (!EVP_CipherUpdate(ctx, scratch, &len, data, chunk)) {
+			osdp_openssl_fatal();
+		}
+		data += chunk;
+		data_len -= chunk;
+	}
+	memcpy(iv, scratch + len - 16, 16);
+}
+
+void osdp_crypt_key_teardown(struct osdp_crypt_key *key)
+{
+	if (key->ready) {
+		EVP_CIPHER_CTX_free(key->ctx.ptr);
+	}
+	osdp_fill_zeros(key, sizeof(struct osdp_crypt_key));
+}
+
 void osdp_fill_random(uint8_t *buf, int len)
 {
 	if (RAND_bytes(buf, len) != 1) {
@@ -10,7 +10,64 @@
 
 #include <utils/utils.h>
 
+#include "../osdp_common.h"
 #include "tinyaes_src.h"
+#include "tinyaes_hw.h"
+#include "tinyaes_ct.h"
+
+/*
+ * How a key is run: on the CPU's AES instructions (see tinyaes_hw.h), on
+ * the bitsliced constant time code (see tinyaes_ct.h) or, where neither
+ * is built, on TinyAES' table code. The first two take it in that order.
+ */
+enum tinyaes_impl {
+	TINYAES_IMPL_TABLE,
+	TINYAES_IMPL_CT,
+	TINYAES_IMPL_HW,
+};
+
+/*
+ * What an osdp_crypt_key holds with this backend. With AES instructions
+ * a key is set up for one direction and a decrypt key keeps the decrypt
+ * schedule in rk; the other two use the same expanded key both ways.
+ */
+struct tinyaes_key {
+	union {
+		struct AES_ctx aes;
+		uint8_t rk[AES_keyExpSize];
+#ifdef TINYAES_CT
+		struct tinyaes_ct_key ct;
+#endif
+	};
+	uint8_t impl;
+	bool decrypt;
+};
+
+_Static_assert(sizeof(struct tinyaes_key) <= OSDP_CRYPT_KEY_CTX_SIZE,
+	       "OSDP_CRYPT_KEY_CTX_SIZE too small for struct tinyaes_key");
+
+#define TO_TINYAES_KEY(key) ((struct tinyaes_key *)(key)->ctx.raw)
+
+#ifdef UNIT_TESTING
+bool test_tinyaes_ct_disable;
+#endif
+
+static enum tinyaes_impl tinyaes_pick_impl(void)
+{
+	if (tinyaes_hw_name() != NULL) {
+		return TINYAES_IMPL_HW;
+	}
+#ifdef TINYAES_CT
+#ifdef UNIT_TESTING
+	if (test_tinyaes_ct_disable) {
+		return TINYAES_IMPL_TABLE;
+	}
+#endif
+	return TINYAES_IMPL_CT;
+#else
+	return TINYAES_IMPL_TABLE;
+#endif
+}
 
 void osdp_crypt_setup()
 {
@@ -18,33 +75,158 @@ void osdp_crypt_setup()
 
 void osdp_encrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
 {
-	struct AES_ctx aes_ctx;
-
-	if (iv != NULL) {
-		/* encrypt multiple block with AES in CBC mode */
-		AES_init_ctx_iv(&aes_ctx, key, iv);
-		AES_CBC_encrypt_buffer(&aes_ctx, data, len);
-	} else {
-		/* encrypt one block with AES in ECB mode */
-		assert(len <= 16);
-		AES_init_ctx(&aes_ctx, key);
-		AES_ECB_encrypt(&aes_ctx, data);
-	}
+	struct osdp_crypt_key k;
+
+	osdp_crypt_key_setup(&k, key, false);
+	osdp_crypt_key_encrypt(&k, iv, data, len);
+	osdp_crypt_key_teardown(&k);
 }
 
 void osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len)
 {
-	struct AES_ctx aes_ctx;
-
-	if (iv != NULL) {
-		/* decrypt multiple block with AES in CBC mode */
-		AES_init_ctx_iv(&aes_ctx, key, iv);
-		AES_CBC_decrypt_buffer(&aes_ctx, data, len);
-	} else {
-		/* decrypt one block with AES in ECB mode */
-		assert(len <= 16);
-		AES_init_ctx(&aes_ctx, key);
-		AES_ECB_decrypt(&aes_ctx, data);
+	struct osdp_crypt_key k;
+
+	osdp_crypt_key_setup(&k, key, true);
+	osdp_crypt_key_decrypt(&k, iv, data, len);
+	osdp_crypt_key_teardown(&k);
+}
+
+void osdp_crypt_key_setup(struct osdp_crypt_key *key, const uint8_t *raw_key,
+			  bool decrypt)
+{
+	struct tinyaes_key *k = TO_TINYAES_KEY(key);
+
+	k->impl = tinyaes_pick_impl();
+	k->decrypt = decrypt;
+	switch (k->impl) {
+#ifdef TINYAES_HW
+	case TINYAES_IMPL_HW:
+		tinyaes_hw_expand_key(k->rk, raw_key);
+		if (decrypt) {
+			tinyaes_hw_decrypt_schedule(k->rk);
+		}
+		break;
+#endif
+#ifdef TINYAES_CT
+	case TINYAES_IMPL_CT:
+		tinyaes_ct_key_setup(&k->ct, raw_key);
+		break;
+#endif
+	default:
+		AES_init_ctx(&k->aes, raw_key);
+		break;
+	}
+	key->ready = true;
+}
+
+void osdp_crypt_key_encrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	struct tinyaes_key *k = TO_TINYAES_KEY(key);
+
+	assert(key->ready);
+	assert(iv != NULL || len <= 16);
+	switch (k->impl) {
+#ifdef TINYAES_HW
+	case TINYAES_IMPL_HW:
+		assert(!k->decrypt);
+		if (iv != NULL) {
+			tinyaes_hw_cbc_encrypt(k->rk, iv, data, len);
+		} else {
+			tinyaes_hw_ecb_encrypt(k->rk, data);
+		}
+		break;
+#endif
+#ifdef TINYAES_CT
+	case TINYAES_IMPL_CT:
+		if (iv != NULL) {
+			tinyaes_ct_cbc_encrypt(&k->ct, iv, data, len);
+		} else {
+			tinyaes_ct_ecb_encrypt(&k->ct, data);
+		}
+		break;
+#endif
+	default:
+		if (iv != NULL) {
+			AES_ctx_set_iv(&k->aes, iv);
+			AES_CBC_encrypt_buffer(&k->aes, data, len);
+		} else {
+			AES_ECB_encrypt(&k->aes, data);
+		}
+		break;
+	}
+}
+
+void osdp_crypt_key_decrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len)
+{
+	struct tinyaes_key *k = TO_TINYAES_KEY(key);
+
+	assert(key->ready);
+	assert(iv != NULL || len <= 16);
+	switch (k->impl) {
+#ifdef TINYAES_HW
+	case TINYAES_IMPL_HW:
+		assert(k->decrypt);
+		if (iv != NULL) {
+			tinyaes_hw_cbc_decrypt(k->rk, iv, data, len);
+		} else {
+			tinyaes_hw_ecb_decrypt(k->rk, data);
+		}
+		break;
+#endif
+#ifdef TINYAES_CT
+	case TINYAES_IMPL_CT:
+		if (iv != NULL) {
+			tinyaes_ct_cbc_decrypt(&k->ct, iv, data, len);
+		} else {
+			tinyaes_ct_ecb_decrypt(&k->ct, data);
+		}
+		break;
+#endif
+	default:
+		if (iv != NULL) {
+			AES_ctx_set_iv(&k->aes, iv);
+			AES_CBC_decrypt_buffer(&k->aes, data, len);
+		} else {
+			AES_ECB_decrypt(&k->aes, data);
+		}
+		break;
+	}
+}
+
+void osdp_crypt_key_cbc_mac(struct osdp_crypt_key *key, uint8_t *iv,
+			    const uint8_t *data, int len)
+{
+	int i;
+	struct tinyaes_key *k = TO_TINYAES_KEY(key);
+
+	assert(key->ready);
+	assert(len % 16 == 0);
+
+	switch (k->impl) {
+#ifdef TINYAES_HW
+	case TINYAES_IMPL_HW:
+		assert(!k->decrypt);
+		tinyaes_hw_cbc_mac(k->rk, iv, data, len);
+		break;
+#endif
+#ifdef TINYAES_CT
+	case TINYAES_IMPL_CT:
+		tinyaes_ct_cbc_mac(&k->ct, iv, data, len);
+		break;
+#endif
+	default:
+		/* chain in iv directly; no ciphertext buffer is needed */
+		while (len > 0) {
+			for (i = 0; i < 16; i++) {
+				iv[i] ^= data[i];
+			}
+			AES_ECB_encrypt(&k->aes, iv);
+			data += 16;
+			len -= 16;
+		}
+		break;
 	}
 }
 
@@ -66,6 +248,11 @@ void osdp_fill_zeros(void *buf, int len)
 	}
 }
 
+void osdp_crypt_key_teardown(struct osdp_crypt_key *key)
+{
+	osdp_fill_zeros(key, sizeof(struct osdp_crypt_key));
+}
+
 void osdp_crypt_teardown()
 {
 }
@@ -0,0 +1,589 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include "../osdp_common.h"
+#include "tinyaes_ct.h"
+
+#ifdef TINYAES_CT
+
+/*
+ * State layout: q[p] holds bit p of 64 state bytes. Byte n of block b
+ * (n = row + 4 * column, as in FIPS-197) sits at bit 4 * n + b, so each
+ * state byte is a nibble holding that byte of all four blocks and each
+ * 16 bit lane of a plane is one column.
+ */
+
+#define CT_BLOCKS 4
+
+/*
+ * Transpose an 8x8 bit matrix held one row per byte (Hacker's Delight,
+ * 7-3). Turns 8 bytes into their 8 bit planes and back.
+ */
+static inline uint64_t ct_transpose8(uint64_t x)
+{
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+/* Bitslice @n (1..4) consecutive blocks of @in; missing blocks are zero */
+static void ct_load(uint64_t *q, const uint8_t *in, int n)
+{
+	int g, k, p;
+	uint64_t x;
+
+	memset(q, 0, 8 * sizeof(uint64_t));
+	for (g = 0; g < 8; g++) {
+		/* lanes 8g .. 8g + 7: bytes 2g and 2g + 1 of every block */
+		x = 0;
+		for (k = 0; k < 8; k++) {
+			if ((k & 3) < n) {
+				x |= (uint64_t)in[16 * (k & 3) + 2 * g + (k >> 2)]
+				     << (8 * k);
+			}
+		}
+		x = ct_transpose8(x);
+		for (p = 0; p < 8; p++) {
+			q[p] |= ((x >> (8 * p)) & 0xFF) << (8 * g);
+		}
+	}
+}
+
+static void ct_store(uint8_t *out, const uint64_t *q, int n)
+{
+	int g, k, p;
+	uint64_t x;
+
+	for (g = 0; g < 8; g++) {
+		x = 0;
+		for (p = 0; p < 8; p++) {
+			x |= ((q[p] >> (8 * g)) & 0xFF) << (8 * p);
+		}
+		x = ct_transpose8(x);
+		for (k = 0; k < 8; k++) {
+			if ((k & 3) < n) {
+				out[16 * (k & 3) + 2 * g + (k >> 2)] =
+					(uint8_t)(x >> (8 * k));
+			}
+		}
+	}
+}
+
+/*
+ * The S-box as a 113 gate circuit (Boyar and Peralta, "A depth-16 circuit
+ * for the AES S-box", 2011): the GF(2^8) inverse and the affine map, on
+ * all 64 bytes of the planes at once.
+ */
+static void ct_sub_bytes(uint64_t *q)
+{
+	uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+	uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	uint64_t y20, y21;
+	uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+	uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+	uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	/* top linear transformation */
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	/* non-linear section */
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	/* bottom linear transformation */
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+/* The inverse affine map: b = (s <<< 1) ^ (s <<< 3) ^ (s <<< 6) ^ 0x05 */
+static void ct_inv_affine(uint64_t *q)
+{
+	int i;
+	uint64_t s[8];
+
+	memcpy(s, q, sizeof(s));
+	for (i = 0; i < 8; i++) {
+		q[i] = s[(i + 7) & 7] ^ s[(i + 5) & 7] ^ s[(i + 2) & 7];
+	}
+	q[0] = ~q[0];
+	q[2] = ~q[2];
+}
+
+/*
+ * With S(x) = A(1/x), 1/y = A^-1(S(y)) and so the inverse S-box is
+ * A^-1(S(A^-1(x))).
+ */
+static void ct_inv_sub_bytes(uint64_t *q)
+{
+	ct_inv_affine(q);
+	ct_sub_bytes(q);
+	ct_inv_affine(q);
+}
+
+static inline uint64_t ct_ror64(uint64_t x, int n)
+{
+	return (x >> n) | (x << (64 - n));
+}
+
+/* Row r (nibble r of every lane) moves left by r columns (lanes) */
+static void ct_shift_rows(uint64_t *q)
+{
+	int i;
+	uint64_t x;
+
+	for (i = 0; i < 8; i++) {
+		x = q[i];
+		q[i] = (x & 0x000F000F000F000FULL) |
+		       (ct_ror64(x, 16) & 0x00F000F000F000F0ULL) |
+		       (ct_ror64(x, 32) & 0x0F000F000F000F00ULL) |
+		       (ct_ror64(x, 48) & 0xF000F000F000F000ULL);
+	}
+}
+
+static void ct_inv_shift_rows(uint64_t *q)
+{
+	int i;
+	uint64_t x;
+
+	for (i = 0; i < 8; i++) {
+		x = q[i];
+		q[i] = (x & 0x000F000F000F000FULL) |
+		       (ct_ror64(x, 48) & 0x00F000F000F000F0ULL) |
+		       (ct_ror64(x, 32) & 0x0F000F000F000F00ULL) |
+		       (ct_ror64(x, 16) & 0xF000F000F000F000ULL);
+	}
+}
+
+/* Row r + n of the same column (lane), for n = 1, 2 and 3 */
+static inline uint64_t ct_row1(uint64_t x)
+{
+	return ((x >> 4) & 0x0FFF0FFF0FFF0FFFULL) |
+	       ((x << 12) & 0xF000F000F000F000ULL);
+}
+
+static inline uint64_t ct_row2(uint64_t x)
+{
+	return ((x >> 8) & 0x00FF00FF00FF00FFULL) |
+	       ((x << 8) & 0xFF00FF00FF00FF00ULL);
+}
+
+static inline uint64_t ct_row3(uint64_t x)
+{
+	return ((x >> 12) & 0x000F000F000F000FULL) |
+	       ((x << 4) & 0xFFF0FFF0FFF0FFF0ULL);
+}
+
+/* q = q * {02} */
+static inline void ct_xtime(uint64_t *q)
+{
+	uint64_t hi = q[7];
+
+	q[7] = q[6];
+	q[6] = q[5];
+	q[5] = q[4];
+	q[4] = q[3] ^ hi;
+	q[3] = q[2] ^ hi;
+	q[2] = q[1];
+	q[1] = q[0] ^ hi;
+	q[0] = hi;
+}
+
+/* a'[r] = {02} (a[r] ^ a[r+1]) ^ a[r+1] ^ a[r+2] ^ a[r+3] */
+static void ct_mix_columns(uint64_t *q)
+{
+	int i;
+	uint64_t b, s[8];
+
+	for (i = 0; i < 8; i++) {
+		b = ct_row1(q[i]);
+		s[i] = b ^ ct_row2(q[i]) ^ ct_row3(q[i]);
+		q[i] ^= b;
+	}
+	ct_xtime(q);
+	for (i = 0; i < 8; i++) {
+		q[i] ^= s[i];
+	}
+}
+
+/*
+ * InvMixColumns is MixColumns after multiplying each column by
+ * {04}x^2 + {05}: a'[r] = a[r] ^ {04} (a[r] ^ a[r+2]).
+ */
+static void ct_inv_mix_columns(uint64_t *q)
+{
+	int i;
+	uint64_t t[8];
+
+	for (i = 0; i < 8; i++) {
+		t[i] = q[i] ^ ct_row2(q[i]);
+	}
+	ct_xtime(t);
+	ct_xtime(t);
+	for (i = 0; i < 8; i++) {
+		q[i] ^= t[i];
+	}
+	ct_mix_columns(q);
+}
+
+/* Spread the 16 bits of a round key plane to the 4 block lanes of a byte */
+static inline uint64_t ct_spread(uint16_t v)
+{
+	uint64_t x = v;
+
+	x = (x | (x << 24)) & 0x000000FF000000FFULL;
+	x = (x | (x << 12)) & 0x000F000F000F000FULL;
+	x = (x | (x << 6)) & 0x0303030303030303ULL;
+	x = (x | (x << 3)) & 0x1111111111111111ULL;
+	x |= x << 1;
+	x |= x << 2;
+	return x;
+}
+
+static inline void ct_add_round_key(uint64_t *q, const uint16_t *rk)
+{
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		q[i] ^= ct_spread(rk[i]);
+	}
+}
+
+static void ct_encrypt(const struct tinyaes_ct_key *k, uint64_t *q)
+{
+	int r;
+
+	ct_add_round_key(q, k->rk[0]);
+	for (r = 1; r < 10; r++) {
+		ct_sub_bytes(q);
+		ct_shift_rows(q);
+		ct_mix_columns(q);
+		ct_add_round_key(q, k->rk[r]);
+	}
+	ct_sub_bytes(q);
+	ct_shift_rows(q);
+	ct_add_round_key(q, k->rk[10]);
+}
+
+static void ct_decrypt(const struct tinyaes_ct_key *k, uint64_t *q)
+{
+	int r;
+
+	ct_add_round_key(q, k->rk[10]);
+	for (r = 9; r > 0; r--) {
+		ct_inv_shift_rows(q);
+		ct_inv_sub_bytes(q);
+		ct_add_round_key(q, k->rk[r]);
+		ct_inv_mix_columns(q);
+	}
+	ct_inv_shift_rows(q);
+	ct_inv_sub_bytes(q);
+	ct_add_round_key(q, k->rk[0]);
+}
+
+/* --- key schedule --- */
+
+static void ct_sub_word(uint8_t *w)
+{
+	int i, p;
+	uint64_t x = 0, q[8];
+
+	for (i = 0; i < 4; i++) {
+		x |= (uint64_t)w[i] << (8 * i);
+	}
+	x = ct_transpose8(x);
+	for (p = 0; p < 8; p++) {
+		q[p] = (x >> (8 * p)) & 0xFF;
+	}
+	ct_sub_bytes(q);
+	x = 0;
+	for (p = 0; p < 8; p++) {
+		x |= (q[p] & 0xFF) << (8 * p);
+	}
+	x = ct_transpose8(x);
+	for (i = 0; i < 4; i++) {
+		w[i] = (uint8_t)(x >> (8 * i));
+	}
+}
+
+/* The 176 byte FIPS-197 key schedule, as AES_init_ctx() builds it */
+static void ct_expand_key(uint8_t *rk, const uint8_t *key)
+{
+	int i;
+	uint8_t t[4], rcon = 0x01;
+
+	memcpy(rk, key, 16);
+	for (i = 4; i < 44; i++) {
+		memcpy(t, rk + 4 * (i - 1), 4);
+		if (i % 4 == 0) {
+			/* RotWord, SubWord, Rcon */
+			uint8_t t0 = t[0];
+
+			t[0] = t[1];
+			t[1] = t[2];
+			t[2] = t[3];
+			t[3] = t0;
+			ct_sub_word(t);
+			t[0] ^= rcon;
+			rcon = (uint8_t)((rcon << 1) ^ (0x1B & -(rcon >> 7)));
+		}
+		rk[4 * i + 0] = rk[4 * (i - 4) + 0] ^ t[0];
+		rk[4 * i + 1] = rk[4 * (i - 4) + 1] ^ t[1];
+		rk[4 * i + 2] = rk[4 * (i - 4) + 2] ^ t[2];
+		rk[4 * i + 3] = rk[4 * (i - 4) + 3] ^ t[3];
+	}
+}
+
+void tinyaes_ct_key_setup(struct tinyaes_ct_key *k, const uint8_t *key)
+{
+	int r, n, p;
+	uint64_t lo, hi;
+	uint8_t rk[176];
+
+	ct_expand_key(rk, key);
+	for (r = 0; r < 11; r++) {
+		lo = hi = 0;
+		for (n = 0; n < 8; n++) {
+			lo |= (uint64_t)rk[16 * r + n] << (8 * n);
+			hi |= (uint64_t)rk[16 * r + 8 + n] << (8 * n);
+		}
+		lo = ct_transpose8(lo);
+		hi = ct_transpose8(hi);
+		for (p = 0; p < 8; p++) {
+			k->rk[r][p] = (uint16_t)(((lo >> (8 * p)) & 0xFF) |
+						 (((hi >> (8 * p)) & 0xFF) << 8));
+		}
+	}
+	osdp_fill_zeros(rk, sizeof(rk));
+}
+
+/* --- modes --- */
+
+void tinyaes_ct_ecb_encrypt(const struct tinyaes_ct_key *k, uint8_t *buf)
+{
+	uint64_t q[8];
+
+	ct_load(q, buf, 1);
+	ct_encrypt(k, q);
+	ct_store(buf, q, 1);
+}
+
+void tinyaes_ct_ecb_decrypt(const struct tinyaes_ct_key *k, uint8_t *buf)
+{
+	uint64_t q[8];
+
+	ct_load(q, buf, 1);
+	ct_decrypt(k, q);
+	ct_store(buf, q, 1);
+}
+
+void tinyaes_ct_cbc_encrypt(const struct tinyaes_ct_key *k, const uint8_t *iv,
+			    uint8_t *buf, size_t len)
+{
+	int i;
+	uint64_t q[8];
+	const uint8_t *prev = iv;
+
+	for (; len >= 16; len -= 16, buf += 16) {
+		for (i = 0; i < 16; i++) {
+			buf[i] ^= prev[i];
+		}
+		ct_load(q, buf, 1);
+		ct_encrypt(k, q);
+		ct_store(buf, q, 1);
+		prev = buf;
+	}
+}
+
+void tinyaes_ct_cbc_decrypt(const struct tinyaes_ct_key *k, const uint8_t *iv,
+			    uint8_t *buf, size_t len)
+{
+	int i, n;
+	uint64_t q[8];
+	uint8_t prev[16], ct[16 * CT_BLOCKS];
+
+	memcpy(prev, iv, 16);
+	while (len >= 16) {
+		n = (int)(len / 16);
+		n = (n > CT_BLOCKS) ? CT_BLOCKS : n;
+		memcpy(ct, buf, 16 * n);
+		ct_load(q, buf, n);
+		ct_decrypt(k, q);
+		ct_store(buf, q, n);
+		for (i = 0; i < 16; i++) {
+			buf[i] ^= prev[i];
+		}
+		for (i = 16; i < 16 * n; i++) {
+			buf[i] ^= ct[i - 16];
+		}
+		memcpy(prev, ct + 16 * (n - 1), 16);
+		buf += 16 * n;
+		len -= 16 * n;
+	}
+}
+
+void tinyaes_ct_cbc_mac(const struct tinyaes_ct_key *k, uint8_t *iv,
+			const uint8_t *data, size_t len)
+{
+	int i;
+	uint64_t q[8];
+
+	for (; len >= 16; len -= 16, data += 16) {
+		for (i = 0; i < 16; i++) {
+			iv[i] ^= data[i];
+		}
+		ct_load(q, iv, 1);
+		ct_encrypt(k, q);
+		ct_store(iv, q, 1);
+	}
+}
+
+#endif /* TINYAES_CT */
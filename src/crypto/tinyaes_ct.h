@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _OSDP_TINYAES_CT_H_
+#define _OSDP_TINYAES_CT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Bitsliced, constant time AES-128 for the bundled TinyAES backend when
+ * the CPU has no AES instructions (see tinyaes_hw.h). There are no table
+ * lookups and no branches on key or data; the S-box is a boolean circuit
+ * evaluated on eight bit planes at a time.
+ * Each plane is a uint64_t that carries one bit of 64 state bytes, so four
+ * blocks go through the rounds together. CBC decryption uses all four;
+ * CBC encryption and the CBC-MAC are sequential and use one.
+ *
+ * That makes single block work the slow case: a 128 byte CBC encryption
+ * takes about 1.7 times as long as with the table code (6.5us vs 3.9us on
+ * x86-64). This is the price of not leaking key bits through the cache;
+ * it cannot be won back by batching, as each block waits for the one
+ * before it.
+ *
+ * So it is opt-in (OPT_OSDP_TINYAES_CT) for hosted builds that would
+ * rather pay that than run the table code. RTOS and bare metal builds
+ * always keep the table code: 64-bit arithmetic may be expensive there
+ * and there usually is no cache (or other tenant) to leak lookups to.
+ */
+#if defined(OPT_OSDP_TINYAES_CT) && \
+    !defined(__BARE_METAL__) && !defined(__ZEPHYR__)
+#define TINYAES_CT 1
+#endif
+
+#ifdef TINYAES_CT
+
+/* Round keys, bitsliced: bit n of rk[r][p] is bit p of round key byte n */
+struct tinyaes_ct_key {
+	uint16_t rk[11][8];
+};
+
+void tinyaes_ct_key_setup(struct tinyaes_ct_key *k, const uint8_t *key);
+void tinyaes_ct_ecb_encrypt(const struct tinyaes_ct_key *k, uint8_t *buf);
+void tinyaes_ct_ecb_decrypt(const struct tinyaes_ct_key *k, uint8_t *buf);
+void tinyaes_ct_cbc_encrypt(const struct tinyaes_ct_key *k, const uint8_t *iv,
+			    uint8_t *buf, size_t len);
+void tinyaes_ct_cbc_decrypt(const struct tinyaes_ct_key *k, const uint8_t *iv,
+			    uint8_t *buf, size_t len);
+void tinyaes_ct_cbc_mac(const struct tinyaes_ct_key *k, uint8_t *iv,
+			const uint8_t *data, size_t len);
+
+#endif /* TINYAES_CT */
+
+#endif /* _OSDP_TINYAES_CT_H_ */
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "tinyaes_hw.h"
+
+#ifdef TINYAES_HW
+
+#if defined(__x86_64__)
+
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+#define HW_TARGET __attribute__((target("aes,sse2")))
+
+typedef __m128i block_t;
+
+#define block_load(p)      _mm_loadu_si128((const __m128i *)(p))
+#define block_store(p, b)  _mm_storeu_si128((__m128i *)(p), (b))
+#define block_xor(a, b)    _mm_xor_si128((a), (b))
+#define block_imc(b)       _mm_aesimc_si128(b)
+
+HW_TARGET static inline block_t hw_encrypt(const block_t *k, block_t b)
+{
+	int i;
+
+	b = _mm_xor_si128(b, k[0]);
+	for (i = 1; i < 10; i++) {
+		b = _mm_aesenc_si128(b, k[i]);
+	}
+	return _mm_aesenclast_si128(b, k[10]);
+}
+
+HW_TARGET static inline block_t hw_decrypt(const block_t *k, block_t b)
+{
+	int i;
+
+	b = _mm_xor_si128(b, k[0]);
+	for (i = 1; i < 10; i++) {
+		b = _mm_aesdec_si128(b, k[i]);
+	}
+	return _mm_aesdeclast_si128(b, k[10]);
+}
+
+static bool hw_probe(void)
+{
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+	return (ecx & bit_AES) != 0;
+}
+
+/*
+ * One round of the FIPS-197 key expansion; @a t is AESKEYGENASSIST of the
+ * previous round key, whose word 3 is RotWord(SubWord(w[3])) ^ Rcon.
+ */
+HW_TARGET static inline block_t hw_expand_round(block_t k, block_t t)
+{
+	t = _mm_shuffle_epi32(t, 0xff);
+	k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+	k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+	k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+	return _mm_xor_si128(k, t);
+}
+
+/* AESKEYGENASSIST wants Rcon as an immediate, hence the macro */
+#define HW_EXPAND(k, i, rcon) \
+	k[i] = hw_expand_round(k[(i) - 1], \
+			       _mm_aeskeygenassist_si128(k[(i) - 1], rcon))
+
+HW_TARGET void tinyaes_hw_expand_key(uint8_t *rk, const uint8_t *key)
+{
+	int i;
+	block_t k[11];
+
+	k[0] = block_load(key);
+	HW_EXPAND(k, 1, 0x01);
+	HW_EXPAND(k, 2, 0x02);
+	HW_EXPAND(k, 3, 0x04);
+	HW_EXPAND(k, 4, 0x08);
+	HW_EXPAND(k, 5, 0x10);
+	HW_EXPAND(k, 6, 0x20);
+	HW_EXPAND(k, 7, 0x40);
+	HW_EXPAND(k, 8, 0x80);
+	HW_EXPAND(k, 9, 0x1b);
+	HW_EXPAND(k, 10, 0x36);
+	for (i = 0; i < 11; i++) {
+		block_store(rk + 16 * i, k[i]);
+	}
+}
+
+#define HW_NAME "aes-ni"
+
+#elif defined(__aarch64__)
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+
+#if defined(__clang__)
+#define HW_TARGET __attribute__((target("crypto")))
+#else
+#define HW_TARGET __attribute__((target("+crypto")))
+#endif
+
+typedef uint8x16_t block_t;
+
+#define block_load(p)      vld1q_u8(p)
+#define block_store(p, b)  vst1q_u8((p), (b))
+#define block_xor(a, b)    veorq_u8((a), (b))
+#define block_imc(b)       vaesimcq_u8(b)
+
+/*
+ * AESE/AESD add the round key *before* the (inverse) S-box and shift
+ * rows, so the first nine rounds line up with k[0..8], the last one with
+ * k[9] and k[10] is left to a plain XOR.
+ */
+HW_TARGET static inline block_t hw_encrypt(const block_t *k, block_t b)
+{
+	int i;
+
+	for (i = 0; i < 9; i++) {
+		b = vaesmcq_u8(vaeseq_u8(b, k[i]));
+	}
+	return veorq_u8(vaeseq_u8(b, k[9]), k[10]);
+}
+
+HW_TARGET static inline block_t hw_decrypt(const block_t *k, block_t b)
+{
+	int i;
+
+	for (i = 0; i < 9; i++) {
+		b = vaesimcq_u8(vaesdq_u8(b, k[i]));
+	}
+	return veorq_u8(vaesdq_u8(b, k[9]), k[10]);
+}
+
+static bool hw_probe(void)
+{
+	return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+}
+
+/*
+ * SubWord on the AES unit: with the word in all four columns, ShiftRows
+ * is a no-op and AESE against a zero round key is just SubBytes.
+ */
+HW_TARGET static inline uint32_t hw_sub_word(uint32_t w)
+{
+	uint8x16_t b = vreinterpretq_u8_u32(vdupq_n_u32(w));
+
+	b = vaeseq_u8(b, vdupq_n_u8(0));
+	return vgetq_lane_u32(vreinterpretq_u32_u8(b), 0);
+}
+
+HW_TARGET void tinyaes_hw_expand_key(uint8_t *rk, const uint8_t *key)
+{
+	static const uint8_t rcon[10] = {
+		0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+	};
+	int i;
+	uint32_t t, w[44];
+
+	/* little endian words: byte 0 of a word is its low byte */
+	memcpy(w, key, 16);
+	for (i = 4; i < 44; i++) {
+		t = w[i - 1];
+		if (i % 4 == 0) {
+			t = hw_sub_word(t);
+			t = ((t >> 8) | (t << 24)) ^ rcon[i / 4 - 1];
+		}
+		w[i] = w[i - 4] ^ t;
+	}
+	memcpy(rk, w, sizeof(w));
+}
+
+#define HW_NAME "armv8-ce"
+
+#endif
+
+#ifdef UNIT_TESTING
+bool test_tinyaes_hw_disable;
+#endif
+
+const char *tinyaes_hw_name(void)
+{
+	/* probing twice from two threads is harmless; both get the same */
+	static int available = -1;
+
+#ifdef UNIT_TESTING
+	if (test_tinyaes_hw_disable) {
+		return NULL;
+	}
+#endif
+	if (available < 0) {
+		available = hw_probe();
+	}
+	return available ? HW_NAME : NULL;
+}
+
+HW_TARGET static inline void hw_load_keys(const uint8_t *rk, block_t *k)
+{
+	int i;
+
+	for (i = 0; i < 11; i++) {
+		k[i] = block_load(rk + 16 * i);
+	}
+}
+
+/*
+ * The equivalent inverse cipher of FIPS-197 (5.3.5): round keys in
+ * reverse order with InvMixColumns applied to all but the outer two.
+ */
+HW_TARGET void tinyaes_hw_decrypt_schedule(uint8_t *rk)
+{
+	int i;
+	block_t k[11];
+
+	hw_load_keys(rk, k);
+	block_store(rk, k[10]);
+	for (i = 1; i < 10; i++) {
+		block_store(rk + 16 * i, block_imc(k[10 - i]));
+	}
+	block_store(rk + 160, k[0]);
+}
+
+HW_TARGET void tinyaes_hw_ecb_encrypt(const uint8_t *rk, uint8_t *buf)
+{
+	block_t k[11];
+
+	hw_load_keys(rk, k);
+	block_store(buf, hw_encrypt(k, block_load(buf)));
+}
+
+HW_TARGET void tinyaes_hw_ecb_decrypt(const uint8_t *rk, uint8_t *buf)
+{
+	block_t k[11];
+
+	hw_load_keys(rk, k);
+	block_store(buf, hw_decrypt(k, block_load(buf)));
+}
+
+HW_TARGET void tinyaes_hw_cbc_encrypt(const uint8_t *rk, const uint8_t *iv,
+				      uint8_t *buf, size_t len)
+{
+	block_t k[11], c = block_load(iv);
+
+	hw_load_keys(rk, k);
+	for (; len >= 16; len -= 16, buf += 16) {
+		c = hw_encrypt(k, block_xor(c, block_load(buf)));
+		block_store(buf, c);
+	}
+}
+
+HW_TARGET void tinyaes_hw_cbc_decrypt(const uint8_t *rk, const uint8_t *iv,
+				      uint8_t *buf, size_t len)
+{
+	block_t k[11], c, prev = block_load(iv);
+
+	hw_load_keys(rk, k);
+	for (; len >= 16; len -= 16, buf += 16) {
+		c = block_load(buf);
+		block_store(buf, block_xor(hw_decrypt(k, c), prev));
+		prev = c;
+	}
+}
+
+HW_TARGET void tinyaes_hw_cbc_mac(const uint8_t *rk, uint8_t *iv,
+				  const uint8_t *data, size_t len)
+{
+	block_t k[11], c = block_load(iv);
+
+	hw_load_keys(rk, k);
+	for (; len >= 16; len -= 16, data += 16) {
+		c = hw_encrypt(k, block_xor(c, block_load(data)));
+	}
+	block_store(iv, c);
+}
+
+#endif /* TINYAES_HW */
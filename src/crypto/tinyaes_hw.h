@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef _OSDP_TINYAES_HW_H_
+#define _OSDP_TINYAES_HW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * AES-128 on the CPU's AES instructions for the bundled TinyAES backend:
+ * AES-NI on x86-64 and the ARMv8 Crypto Extensions on AArch64 Linux. The
+ * code is built in whenever the compiler can target those on a hosted
+ * build (RTOS and bare metal kernels may not save the vector registers
+ * for us); whether the CPU we run on has them is checked at runtime by
+ * tinyaes_hw_name().
+ *
+ * All functions take the 176 byte key schedule of AES_init_ctx(), as
+ * tinyaes_hw_expand_key() builds it on the AES unit (AESKEYGENASSIST on
+ * x86-64, AESE for SubWord on AArch64); no table lookups there either.
+ * The decrypt functions want it passed through
+ * tinyaes_hw_decrypt_schedule() first.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(__BARE_METAL__) && !defined(__ZEPHYR__) && \
+    (defined(__x86_64__) || (defined(__aarch64__) && defined(__linux__)))
+#define TINYAES_HW 1
+#endif
+
+#ifdef TINYAES_HW
+
+/**
+ * Returns the name of the AES instructions in use ("aes-ni", "armv8-ce")
+ * or NULL if this CPU doesn't have them.
+ */
+const char *tinyaes_hw_name(void);
+
+void tinyaes_hw_expand_key(uint8_t *rk, const uint8_t *key);
+void tinyaes_hw_decrypt_schedule(uint8_t *rk);
+void tinyaes_hw_ecb_encrypt(const uint8_t *rk, uint8_t *buf);
+void tinyaes_hw_ecb_decrypt(const uint8_t *rk, uint8_t *buf);
+void tinyaes_hw_cbc_encrypt(const uint8_t *rk, const uint8_t *iv,
+			    uint8_t *buf, size_t len);
+void tinyaes_hw_cbc_decrypt(const uint8_t *rk, const uint8_t *iv,
+			    uint8_t *buf, size_t len);
+void tinyaes_hw_cbc_mac(const uint8_t *rk, uint8_t *iv,
+			const uint8_t *data, size_t len);
+
+#else
+
+static inline const char *tinyaes_hw_name(void)
+{
+	return NULL;
+}
+
+#endif /* TINYAES_HW */
+
+#endif /* _OSDP_TINYAES_HW_H_ */
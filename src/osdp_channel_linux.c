@@ -0,0 +1,470 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Reference osdp_channel implementations for Linux.
+ *
+ * Every channel is a non-blocking fd registered edge-triggered for both
+ * directions in a shared epoll set. osdp_channel_loop_wait() turns
+ * readiness into one batched read() per readable fd and a write() of any
+ * TX backlog per writable fd; the channel's recv()/send() methods then
+ * work out of those buffers and only touch the fd when the kernel said it
+ * has something for us. A loop can hold any number of channels, so one
+ * thread can service every bus it owns.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "osdp_common.h"
+
+#if defined(OPT_OSDP_STATIC) || defined(OPT_OSDP_RX_ZERO_COPY)
+#error "Linux channels need dynamic memory and the byte-stream recv() API"
+#endif
+
+struct channel_linux {
+	struct osdp_channel_loop *loop;
+	int fd;
+	bool is_tty;
+	bool readable;  /* no EAGAIN seen since the last EPOLLIN edge */
+	bool failed;    /* EOF, hangup or hard I/O error */
+
+	uint8_t rx_buf[OSDP_CHANNEL_RX_BUF_SIZE];
+	int rx_off;
+	int rx_len;
+
+	uint8_t tx_buf[OSDP_CHANNEL_TX_BUF_SIZE];
+	int tx_off;
+	int tx_len;
+};
+
+struct osdp_channel_loop {
+	int epfd;
+	int num_chan;
+};
+
+static int channel_set_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL);
+
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/* one read() into whatever space is left at the end of rx_buf */
+static int channel_fill(struct channel_linux *c)
+{
+	ssize_t n;
+	int space;
+
+	if (c->rx_len == 0) {
+		c->rx_off = 0;
+	} else if (c->rx_off + c->rx_len == OSDP_CHANNEL_RX_BUF_SIZE) {
+		memmove(c->rx_buf, c->rx_buf + c->rx_off, c->rx_len);
+		c->rx_off = 0;
+	}
+	space = OSDP_CHANNEL_RX_BUF_SIZE - c->rx_off - c->rx_len;
+	if (space == 0) {
+		return 0;
+	}
+
+	do {
+		n = read(c->fd, c->rx_buf + c->rx_off + c->rx_len, space);
+	} while (n < 0 && errno == EINTR);
+
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			c->readable = false;
+			return 0;
+		}
+		c->failed = true;
+		return -1;
+	}
+	if (n == 0) {
+		/* a non-blocking tty reports "no data" this way; a socket EOF */
+		c->readable = false;
+		if (!c->is_tty) {
+			c->failed = true;
+			return -1;
+		}
+		return 0;
+	}
+	/* a short read on a stream fd means the kernel queue is drained */
+	if (n < space) {
+		c->readable = false;
+	}
+	c->rx_len += (int)n;
+	return (int)n;
+}
+
+static int channel_drain_tx(struct channel_linux *c)
+{
+	ssize_t n;
+
+	while (c->tx_len > 0) {
+		n = write(c->fd, c->tx_buf + c->tx_off, c->tx_len);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				return 0;
+			}
+			c->failed = true;
+			return -1;
+		}
+		c->tx_off += (int)n;
+		c->tx_len -= (int)n;
+	}
+	c->tx_off = 0;
+	return 0;
+}
+
+static int channel_recv(void *data, uint8_t *buf, int len)
+{
+	struct channel_linux *c = data;
+
+	if (c->rx_len == 0 && c->readable) {
+		channel_fill(c);
+	}
+	if (c->rx_len == 0) {
+		return c->failed ? -1 : 0;
+	}
+	if (len > c->rx_len) {
+		len = c->rx_len;
+	}
+	memcpy(buf, c->rx_buf + c->rx_off, len);
+	c->rx_off += len;
+	c->rx_len -= len;
+	return len;
+}
+
+static int channel_send(void *data, uint8_t *buf, int len)
+{
+	ssize_t n = 0;
+	struct channel_linux *c = data;
+
+	if (c->failed || channel_drain_tx(c) < 0) {
+		return -1;
+	}
+
+	if (c->tx_len == 0) {
+		do {
+			n = write(c->fd, buf, len);
+		} while (n < 0 && errno == EINTR);
+		if (n < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				c->failed = true;
+				return -1;
+			}
+			n = 0;
+		}
+		if (n == len) {
+			return len;
+		}
+	}
+
+	/* the rest goes out from the loop on the next EPOLLOUT edge */
+	if (c->tx_off + c->tx_len + (len - n) > OSDP_CHANNEL_TX_BUF_SIZE) {
+		memmove(c->tx_buf, c->tx_buf + c->tx_off, c->tx_len);
+		c->tx_off = 0;
+	}
+	if (c->tx_len + (len - n) > OSDP_CHANNEL_TX_BUF_SIZE) {
+		return (n == 0) ? 0 : -1;
+	}
+	memcpy(c->tx_buf + c->tx_off + c->tx_len, buf + n, len - n);
+	c->tx_len += (int)(len - n);
+	return len;
+}
+
+static void channel_flush(void *data)
+{
+	struct channel_linux *c = data;
+
+	if (c->is_tty) {
+		tcflush(c->fd, TCIOFLUSH);
+	} else {
+		while (c->readable && channel_fill(c) > 0) {
+			c->rx_len = 0;
+		}
+	}
+	c->rx_off = c->rx_len = 0;
+	c->tx_off = c->tx_len = 0;
+}
+
+static void channel_close(void *data)
+{
+	struct channel_linux *c = data;
+
+	epoll_ctl(c->loop->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+	c->loop->num_chan--;
+	close(c->fd);
+	free(c);
+}
+
+osdp_channel_loop_t *osdp_channel_loop_create(void)
+{
+	struct osdp_channel_loop *loop;
+
+	loop = calloc(1, sizeof(struct osdp_channel_loop));
+	if (loop == NULL) {
+		LOG_PRINT("Failed to allocate channel loop");
+		return NULL;
+	}
+	loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epfd < 0) {
+		LOG_PRINT("epoll_create1 failed; errno: %d", errno);
+		free(loop);
+		return NULL;
+	}
+	return (osdp_channel_loop_t *)loop;
+}
+
+void osdp_channel_loop_destroy(osdp_channel_loop_t *l)
+{
+	struct osdp_channel_loop *loop = l;
+
+	if (loop == NULL) {
+		return;
+	}
+	if (loop->num_chan) {
+		LOG_PRINT("Channel loop destroyed with %d channels open",
+			  loop->num_chan);
+	}
+	close(loop->epfd);
+	free(loop);
+}
+
+int osdp_channel_loop_fd(osdp_channel_loop_t *l)
+{
+	struct osdp_channel_loop *loop = l;
+
+	return loop->epfd;
+}
+
+int osdp_channel_loop_wait(osdp_channel_loop_t *l, int timeout_ms)
+{
+	int i, n, ready = 0;
+	struct channel_linux *c;
+	struct osdp_channel_loop *loop = l;
+	struct epoll_event ev[OSDP_CHANNEL_LOOP_MAX_EVENTS];
+
+	do {
+		n = epoll_wait(loop->epfd, ev, OSDP_CHANNEL_LOOP_MAX_EVENTS,
+			       timeout_ms);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) {
+		return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+		c = ev[i].data.ptr;
+		if (ev[i].events & EPOLLOUT) {
+			channel_drain_tx(c);
+		}
+		if (ev[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+			c->readable = true;
+			channel_fill(c);
+		}
+		if (c->rx_len > 0 || c->failed) {
+			ready++;
+		}
+	}
+	return ready;
+}
+
+int osdp_channel_open_fd(osdp_channel_loop_t *l, struct osdp_channel *channel,
+			 int fd)
+{
+	struct channel_linux *c;
+	struct osdp_channel_loop *loop = l;
+	struct epoll_event ev = {
+		.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+	};
+
+	if (loop == NULL || channel == NULL || fd < 0) {
+		return -1;
+	}
+	if (channel_set_nonblock(fd)) {
+		LOG_PRINT("Failed to make fd:%d non-blocking", fd);
+		return -1;
+	}
+	c = calloc(1, sizeof(struct channel_linux));
+	if (c == NULL) {
+		LOG_PRINT("Failed to allocate channel");
+		return -1;
+	}
+	c->loop = loop;
+	c->fd = fd;
+	c->is_tty = isatty(fd);
+	c->readable = true;
+
+	ev.data.ptr = c;
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		LOG_PRINT("Failed to add fd:%d to channel loop; errno: %d",
+			  fd, errno);
+		free(c);
+		return -1;
+	}
+	loop->num_chan++;
+
+	channel->data = c;
+	channel->recv = channel_recv;
+	channel->send = channel_send;
+	channel->flush = channel_flush;
+	channel->close = channel_close;
+	return 0;
+}
+
+static speed_t channel_baud_to_speed(int baud_rate)
+{
+	switch (baud_rate) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	default:     return B0;
+	}
+}
+
+int osdp_channel_open_serial(osdp_channel_loop_t *loop,
+			     struct osdp_channel *channel,
+			     const char *device, int baud_rate)
+{
+	int fd;
+	struct termios tio;
+	speed_t speed = channel_baud_to_speed(baud_rate);
+
+	if (speed == B0) {
+		LOG_PRINT("Unsupported baud rate %d", baud_rate);
+		return -1;
+	}
+	fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (fd < 0) {
+		LOG_PRINT("Failed to open %s; errno: %d", device, errno);
+		return -1;
+	}
+	if (tcgetattr(fd, &tio) < 0) {
+		LOG_PRINT("%s is not a tty", device);
+		close(fd);
+		return -1;
+	}
+	/* raw 8N1; reads never wait (VMIN = VTIME = 0) */
+	cfmakeraw(&tio);
+	tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+	tio.c_cflag |= CS8 | CLOCAL | CREAD;
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+	cfsetispeed(&tio, speed);
+	cfsetospeed(&tio, speed);
+	if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+		LOG_PRINT("Failed to configure %s; errno: %d", device, errno);
+		close(fd);
+		return -1;
+	}
+	tcflush(fd, TCIOFLUSH);
+
+	if (osdp_channel_open_fd(loop, channel, fd)) {
+		close(fd);
+		return -1;
+	}
+	return 0;
+}
+
+int osdp_channel_open_tcp(osdp_channel_loop_t *loop,
+			  struct osdp_channel *channel,
+			  const char *host, int port)
+{
+	int fd = -1, one = 1;
+	char service[8];
+	struct addrinfo *res, *ai;
+	struct addrinfo hints = {
+		.ai_family = AF_UNSPEC,
+		.ai_socktype = SOCK_STREAM,
+	};
+
+	snprintf(service, sizeof(service), "%d", port);
+	if (getaddrinfo(host, service, &hints, &res) != 0) {
+		LOG_PRINT("Failed to resolve %s:%d", host, port);
+		return -1;
+	}
+	for (ai = res; ai != NULL; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+			    ai->ai_protocol);
+		if (fd < 0) {
+			continue;
+		}
+		if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+			break;
+		}
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	if (fd < 0) {
+		LOG_PRINT("Failed to connect to %s:%d", host, port);
+		return -1;
+	}
+
+	/* OSDP packets are small and latency bound; don't let Nagle sit on them */
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	if (osdp_channel_open_fd(loop, channel, fd)) {
+		close(fd);
+		return -1;
+	}
+	return 0;
+}
+
+int osdp_channel_open_unix(osdp_channel_loop_t *loop,
+			   struct osdp_channel *channel, const char *path)
+{
+	int fd;
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		LOG_PRINT("Socket path too long: %s", path);
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		LOG_PRINT("Failed to connect to %s; errno: %d", path, errno);
+		close(fd);
+		return -1;
+	}
+
+	if (osdp_channel_open_fd(loop, channel, fd)) {
+		close(fd);
+		return -1;
+	}
+	return 0;
+}
+
+int osdp_channel_get_fd(const struct osdp_channel *channel)
+{
+	const struct channel_linux *c = channel->data;
+
+	return c->fd;
+}
@@ -14,8 +14,6 @@
 
 #include "osdp_common.h"
 
-#include <utils/crc16.h>
-
 #ifdef OPT_OSDP_LOG_MINIMAL
 #define OSDP_MIN_LOG_BUF_LEN 160
 
@@ -128,13 +126,18 @@ int osdp_log_cb_emit(bool is_cp, int pd_address, int log_level,
 
 #endif /* OPT_OSDP_LOG_MINIMAL */
 
-uint16_t osdp_compute_crc16(const uint8_t *buf, size_t len)
-{
-	return crc16_itu_t(0x1D0F, buf, len);
-}
+#ifdef OPT_OSDP_VIRTUAL_BUS
+/* When set, time comes from a virtual bus; see osdp_vbus_create() */
+const tick_t *osdp_virtual_clock;
+#endif
 
 __weak tick_t osdp_millis_now(void)
 {
+#ifdef OPT_OSDP_VIRTUAL_BUS
+	if (osdp_virtual_clock) {
+		return *osdp_virtual_clock;
+	}
+#endif
 	return millis_now();
 }
 
@@ -143,6 +146,24 @@ tick_t osdp_millis_since(tick_t last)
 	return osdp_millis_now() - last;
 }
 
+/**
+ * Free running cycle counter used for coarse profiling of hot paths. Returns
+ * 0 on targets without a known counter; platforms can override this.
+ */
+__weak uint64_t osdp_cycles_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+	uint64_t val;
+
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(val));
+	return val;
+#else
+	return 0;
+#endif
+}
+
 const char *osdp_cmd_name(int cmd_id)
 {
 	const char *name;
@@ -227,6 +248,29 @@ const char *osdp_reply_name(int reply_id)
 	return name;
 }
 
+/*
+ * RX ring buffer. One slot is always left unused so that head == tail means
+ * empty. Bulk operations copy at most two contiguous segments (before and
+ * after the wrap point) instead of moving one byte at a time.
+ */
+
+size_t osdp_rb_len(struct osdp_rb *p)
+{
+	if (p->head >= p->tail)
+		return p->head - p->tail;
+	return sizeof(p->buffer) - p->tail + p->head;
+}
+
+static inline size_t rb_min(size_t a, size_t b)
+{
+	return a < b ? a : b;
+}
+
+static inline size_t osdp_rb_space(struct osdp_rb *p)
+{
+	return sizeof(p->buffer) - 1 - osdp_rb_len(p);
+}
+
 int osdp_rb_push(struct osdp_rb *p, uint8_t data)
 {
 	size_t next;
@@ -243,17 +287,22 @@ int osdp_rb_push(struct osdp_rb *p, uint8_t data)
 	return 0;
 }
 
-int osdp_rb_push_buf(struct osdp_rb *p, uint8_t *buf, int len)
+int osdp_rb_push_buf(struct osdp_rb *p, const uint8_t *buf, int len)
 {
-	int i;
+	size_t count, first;
 
-	for (i = 0; i < len; i++) {
-		if (osdp_rb_push(p, buf[i])) {
-			break;
-		}
-	}
+	if (len <= 0)
+		return 0;
+
+	count = rb_min((size_t)len, osdp_rb_space(p));
+	first = rb_min(count, sizeof(p->buffer) - p->head);
+	memcpy(p->buffer + p->head, buf, first);
+	memcpy(p->buffer, buf + first, count - first);
+	p->head += count;
+	if (p->head >= sizeof(p->buffer))
+		p->head -= sizeof(p->buffer);
 
-	return i;
+	return (int)count;
 }
 
 int osdp_rb_pop(struct osdp_rb *p, uint8_t *data)
@@ -272,17 +321,99 @@ int osdp_rb_pop(struct osdp_rb *p, uint8_t *data)
 	return 0;
 }
 
+int osdp_rb_peek_buf(struct osdp_rb *p, uint8_t *buf, int max_len)
+{
+	size_t count, first;
+
+	if (max_len <= 0)
+		return 0;
+
+	count = rb_min((size_t)max_len, osdp_rb_len(p));
+	first = rb_min(count, sizeof(p->buffer) - p->tail);
+	memcpy(buf, p->buffer + p->tail, first);
+	memcpy(buf + first, p->buffer, count - first);
+
+	return (int)count;
+}
+
+int osdp_rb_skip(struct osdp_rb *p, int len)
+{
+	size_t count;
+
+	if (len <= 0)
+		return 0;
+
+	count = rb_min((size_t)len, osdp_rb_len(p));
+	p->tail += count;
+	if (p->tail >= sizeof(p->buffer))
+		p->tail -= sizeof(p->buffer);
+
+	return (int)count;
+}
+
 int osdp_rb_pop_buf(struct osdp_rb *p, uint8_t *buf, int max_len)
 {
-	int i;
+	return osdp_rb_skip(p, osdp_rb_peek_buf(p, buf, max_len));
+}
 
-	for (i = 0; i < max_len; i++) {
-		if (osdp_rb_pop(p, buf + i)) {
-			break;
-		}
+int osdp_rb_peek(struct osdp_rb *p, size_t offset, uint8_t *data)
+{
+	if (offset >= osdp_rb_len(p))
+		return -1;
+
+	offset += p->tail;
+	if (offset >= sizeof(p->buffer))
+		offset -= sizeof(p->buffer);
+	*data = p->buffer[offset];
+	return 0;
+}
+
+int osdp_rb_scan(struct osdp_rb *p, uint8_t byte)
+{
+	const uint8_t *hit;
+	size_t len = osdp_rb_len(p);
+	size_t first = rb_min(len, sizeof(p->buffer) - p->tail);
+
+	hit = memchr(p->buffer + p->tail, byte, first);
+	if (hit)
+		return (int)(hit - (p->buffer + p->tail));
+
+	hit = memchr(p->buffer, byte, len - first);
+	if (hit)
+		return (int)(first + (size_t)(hit - p->buffer));
+
+	return -1;
+}
+
+static void rb_reverse(uint8_t *buf, size_t len)
+{
+	uint8_t t;
+	size_t i;
+
+	for (i = 0; i < len / 2; i++) {
+		t = buf[i];
+		buf[i] = buf[len - 1 - i];
+		buf[len - 1 - i] = t;
 	}
+}
+
+void osdp_rb_compact(struct osdp_rb *p)
+{
+	size_t len = osdp_rb_len(p);
 
-	return i;
+	if (p->tail == 0)
+		return;
+
+	if (p->head >= p->tail) {
+		memmove(p->buffer, p->buffer + p->tail, len);
+	} else {
+		/* wrapped; rotate the whole buffer left by tail */
+		rb_reverse(p->buffer, p->tail);
+		rb_reverse(p->buffer + p->tail, sizeof(p->buffer) - p->tail);
+		rb_reverse(p->buffer, sizeof(p->buffer));
+	}
+	p->tail = 0;
+	p->head = len;
 }
 
 void osdp_rb_reset(struct osdp_rb *p)
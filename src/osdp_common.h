@@ -33,6 +33,10 @@
 #define NULL ((void *)0)
 #endif
 
+#if defined(OPT_OSDP_RX_ZERO_COPY) && defined(OPT_OSDP_RX_ARENA)
+#error "OPT_OSDP_RX_ZERO_COPY and OPT_OSDP_RX_ARENA are mutually exclusive"
+#endif
+
 #define OSDP_CTX_MAGIC 0xDEADBEEF
 
 #define ARG_UNUSED(x) (void)(x)
@@ -289,6 +293,7 @@ static inline __noreturn void die()
 #define PD_FLAG_PKT_BROADCAST  BIT(13) /* this packet was addressed to 0x7F */
 #define PD_FLAG_CP_USE_CRC     BIT(14) /* CP uses CRC-16 instead of checksum */
 #define PD_FLAG_ONLINE         BIT(15) /* PD mode: CP link is active */
+#define PD_FLAG_NOTIF_ONLINE   BIT(16) /* CP mode: app last heard PD online */
 
 /* PD Init flags */
 #define PD_FLAG_ENFORCE_SECURE  BIT(24) /* See: OSDP_FLAG_ENFORCE_SECURE */
@@ -386,6 +391,32 @@ struct osdp_slab {
 	uint8_t *blob;
 };
 
+/**
+ * Inline storage for a keyed AES-128 context prepared by the crypto backend,
+ * so that the key schedule is computed once per session instead of once per
+ * block. A PD holds five of these (four session keys and the cached SCBK),
+ * so the size follows the backend: OpenSSL keeps a pointer to its EVP
+ * context, TinyAES a 176 byte key schedule and mbedtls a whole
+ * mbedtls_aes_context (288 bytes on 64-bit targets). Each backend asserts
+ * that its context fits.
+ */
+#if defined(OPT_OSDP_USE_OPENSSL)
+#define OSDP_CRYPT_KEY_CTX_SIZE        8
+#elif defined(OPT_OSDP_USE_MBEDTLS)
+#define OSDP_CRYPT_KEY_CTX_SIZE        288
+#else
+#define OSDP_CRYPT_KEY_CTX_SIZE        200
+#endif
+
+struct osdp_crypt_key {
+	bool ready;
+	union {
+		void *ptr;
+		uint64_t align;
+		uint8_t raw[OSDP_CRYPT_KEY_CTX_SIZE];
+	} ctx;
+};
+
 struct osdp_secure_channel {
 	uint8_t scbk[16];
 	uint8_t s_enc[16];
@@ -398,6 +429,17 @@ struct osdp_secure_channel {
 	uint8_t pd_client_uid[8];
 	uint8_t cp_cryptogram[16];
 	uint8_t pd_cryptogram[16];
+	struct osdp_crypt_key k_enc;    /* s_enc; encrypt direction */
+	struct osdp_crypt_key k_dec;    /* s_enc; decrypt direction */
+	struct osdp_crypt_key k_mac1;   /* s_mac1 */
+	struct osdp_crypt_key k_mac2;   /* s_mac2 */
+	bool keys_ready;                /* s_*, k_* set up for this cp_random */
+};
+
+/* Expanded key schedule that outlives SC sessions; see sc_cached_key() */
+struct osdp_sc_cached_key {
+	uint8_t raw[16];                /* key the schedule was expanded from */
+	struct osdp_crypt_key key;
 };
 
 struct osdp_rb {
@@ -435,8 +477,32 @@ struct osdp_pd {
 	tick_t sc_tstamp;      /* Last received secure reply time in ticks */
 	tick_t phy_tstamp;     /* Time in ticks since command was sent */
 	tick_t resp_expected;  /* Time in ticks when the response is expected */
+	bool phy_rx_seen;      /* Reply bytes seen since the last command (CP) */
 	uint32_t request;      /* Event loop requests */
 
+	/* CP poll scheduler state; see cp_poll_sched_update() */
+	struct {
+		uint32_t interval_ms;  /* current CMD_POLL interval */
+		uint32_t rtt_ms;       /* smoothed command/reply exchange time */
+		uint16_t latency_ms;   /* OSDP_CP_POLL_LATENCY target */
+		uint8_t priority;      /* OSDP_CP_POLL_PRIORITY class */
+		uint8_t idle_polls;    /* consecutive polls answered by ACK */
+	} poll;
+
+	/* CP reconnect backoff while offline; see cp_offline_wait() */
+	struct {
+		uint32_t wait_ms;      /* current backoff step; 0 once online */
+		uint32_t rng;          /* xorshift32 state for the jitter */
+		tick_t since;          /* when the PD was lost */
+	} backoff;
+
+	/* CP: commands packed behind active_cmd; see cp_pack_commands() */
+	struct {
+		uint8_t max;           /* records per packet; <= 1 is off */
+		uint8_t n;             /* entries in cmds[] */
+		const struct osdp_cmd *cmds[OSDP_CP_CMD_PACK_MAX];
+	} pack;
+
 	uint16_t peer_rx_size; /* Receive buffer size of the peer PD/CP */
 
 	/* Raw bytes received from the serial line for this PD */
@@ -449,7 +515,10 @@ struct osdp_pd {
 	uint8_t *packet_buf;
 	unsigned long packet_len;
 	unsigned long packet_buf_len;
-	uint32_t packet_scan_skip;
+	uint16_t rx_skip;      /* bytes of a skipped packet still to drop */
+#ifdef OPT_OSDP_RX_ARENA
+	unsigned long packet_claim; /* rx_rb bytes held by the current packet */
+#endif
 	/* A finalized packet is parked in packet_buf awaiting channel-send.
 	 * Set by the build step (fresh reply, prebuilt status reply, or
 	 * EAGAIN retry promotion); cleared after the send completes. While
@@ -478,10 +547,16 @@ struct osdp_pd {
 		queue_t cmd_queue;
 		queue_t event_queue;
 	};
+	/* CP: commands submitted from any thread; see cp_cmd_enqueue() */
+	void *cmd_inbox;
+	uint32_t cmd_gate;     /* CP_CMD_GATE_* published by the refresh thread */
+	bool batch_sel;        /* CP: picked by the batch being submitted */
+	int batch_next;        /* CP: next ctx->batch entry to send; -1 if none */
 	const struct osdp_cmd *active_cmd;      /* in-flight cmd (app-owned mode) */
 	const struct osdp_event *active_event;  /* in-flight event (app-owned mode) */
 
 	struct osdp_secure_channel sc;   /* Secure Channel session context */
+	struct osdp_sc_cached_key scbk_key; /* SCBK or SCBK-D last used by sc */
 	struct osdp_file *file;          /* File transfer context */
 	struct osdp_metrics metrics;     /* link/protocol health counters */
 
@@ -503,6 +578,7 @@ struct osdp {
 	struct osdp_pd *_current_pd; /* current operational pd's pointer */
 	struct osdp_pd *pd;    /* base of PD list (must be at lest one) */
 	struct osdp_channel channel; /* OSDP channel */
+	int poll_policy;       /* enum osdp_cp_poll_policy (CP mode only) */
 	uint8_t tx_buf[OSDP_PACKET_BUF_SIZE];
 	uint8_t *rx_buf; /* RX landing buffer: aliased to tx_buf in CP; distinct in PD */
 
@@ -512,6 +588,31 @@ struct osdp {
 	void *command_completion_callback_arg;
 	cp_command_completion_callback_t command_completion_callback;
 
+	/* osdp_cp_submit_commands() batch; at most one in flight */
+	struct {
+		void *cmds;        /* claimed (CAS from NULL) by the submitter */
+		int n;
+		uint32_t ready;    /* submitted, not yet started by refresh */
+		bool active;
+		int remaining;     /* PD x command entries not yet completed */
+		int status;        /* aggregated enum osdp_completion_status */
+	} batch;
+
+	/* CP: osdp_cp_get_time_to_secure(); see cp_secure_time_update() */
+	struct {
+		tick_t since;      /* when the bus stopped being all secure */
+		int ms;            /* time it took to get back; -1 until then */
+	} secure;
+
+	/* CP event ring; replaces event_callback when set (SPSC) */
+	struct {
+		struct osdp_cp_event *buf;
+		uint32_t mask;     /* size - 1; size is a power of two */
+		int policy;        /* enum osdp_cp_event_overflow */
+		uint32_t head;     /* next slot to fill; refresh thread only */
+		uint32_t tail;     /* next slot to drain; osdp_cp_poll_events() */
+	} event_ring;
+
 #ifndef OPT_OSDP_LOG_MINIMAL
 	logger_t logger;      /* logger context (from utils/logger.h) */
 #endif
@@ -519,6 +620,9 @@ struct osdp {
 
 void osdp_keyset_complete(struct osdp_pd *pd);
 
+/* --- from osdp_cp.c --- */
+bool osdp_cp_awaiting_reply(const osdp_t *ctx);
+
 /* --- from osdp_phy.c --- */
 int osdp_phy_packet_init(struct osdp_pd *p, uint8_t *buf, int max_len);
 int osdp_phy_check_packet(struct osdp_pd *pd);
@@ -534,16 +638,48 @@ void osdp_phy_release_packet(struct osdp_pd *pd);
 
 /* --- from osdp_common.c --- */
 __weak tick_t osdp_millis_now(void);
+#ifdef OPT_OSDP_VIRTUAL_BUS
+extern const tick_t *osdp_virtual_clock;
+#endif
 tick_t osdp_millis_since(tick_t last);
+
+/* ms left until osdp_millis_since(start) exceeds period; 0 if it already has */
+static inline uint32_t osdp_millis_until(tick_t start, uint32_t period)
+{
+	tick_t elapsed = osdp_millis_since(start);
+
+	return (elapsed > period) ? 0 : (uint32_t)(period - elapsed) + 1;
+}
+__weak uint64_t osdp_cycles_now(void);
+
+/* --- from osdp_crc.c --- */
 uint16_t osdp_compute_crc16(const uint8_t *buf, size_t len);
+uint16_t osdp_crc16_bitwise(uint16_t crc, const uint8_t *buf, size_t len);
+#if OSDP_CRC16_ENGINE >= 1
+uint16_t osdp_crc16_table(uint16_t crc, const uint8_t *buf, size_t len);
+#endif
+#if OSDP_CRC16_ENGINE >= 2
+uint16_t osdp_crc16_slice8(uint16_t crc, const uint8_t *buf, size_t len);
+#endif
+#if OSDP_CRC16_ENGINE >= 2 && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+bool osdp_crc16_clmul_supported(void);
+uint16_t osdp_crc16_clmul(uint16_t crc, const uint8_t *buf, size_t len);
+#endif
 
 const char *osdp_cmd_name(int cmd_id);
 const char *osdp_reply_name(int reply_id);
 
+size_t osdp_rb_len(struct osdp_rb *p);
 int osdp_rb_push(struct osdp_rb *p, uint8_t data);
-int osdp_rb_push_buf(struct osdp_rb *p, uint8_t *buf, int len);
+int osdp_rb_push_buf(struct osdp_rb *p, const uint8_t *buf, int len);
 int osdp_rb_pop(struct osdp_rb *p, uint8_t *data);
 int osdp_rb_pop_buf(struct osdp_rb *p, uint8_t *buf, int max_len);
+int osdp_rb_peek(struct osdp_rb *p, size_t offset, uint8_t *data);
+int osdp_rb_peek_buf(struct osdp_rb *p, uint8_t *buf, int max_len);
+int osdp_rb_skip(struct osdp_rb *p, int len);
+int osdp_rb_scan(struct osdp_rb *p, uint8_t byte);
+void osdp_rb_compact(struct osdp_rb *p);
 void osdp_rb_reset(struct osdp_rb *p);
 
 void osdp_crypt_setup();
@@ -552,6 +688,15 @@ void osdp_decrypt(uint8_t *key, uint8_t *iv, uint8_t *data, int len);
 void osdp_fill_random(uint8_t *buf, int len);
 void osdp_fill_zeros(void *buf, int len);
 void osdp_crypt_teardown();
+void osdp_crypt_key_setup(struct osdp_crypt_key *key, const uint8_t *raw_key,
+			  bool decrypt);
+void osdp_crypt_key_encrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len);
+void osdp_crypt_key_decrypt(struct osdp_crypt_key *key, uint8_t *iv,
+			    uint8_t *data, int len);
+void osdp_crypt_key_cbc_mac(struct osdp_crypt_key *key, uint8_t *iv,
+			    const uint8_t *data, int len);
+void osdp_crypt_key_teardown(struct osdp_crypt_key *key);
 
 /* --- from osdp_sc.c --- */
 void osdp_compute_scbk(struct osdp_pd *pd, uint8_t *master_key, uint8_t *scbk);
@@ -565,8 +710,97 @@ int osdp_decrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int len);
 int osdp_encrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int len);
 int osdp_compute_mac(struct osdp_pd *pd, int is_cmd,
 		     const uint8_t *data, int len);
+int osdp_sc_seal(struct osdp_pd *pd, uint8_t *buf, int hdr_len, int data_len);
+int osdp_sc_open(struct osdp_pd *pd, uint8_t *buf, int hdr_len, int data_len,
+		 const uint8_t *mac);
 void osdp_sc_setup(struct osdp_pd *pd);
 void osdp_sc_teardown(struct osdp_pd *pd);
+void osdp_sc_release_keys(struct osdp_pd *pd);
+void osdp_sc_release_cached_key(struct osdp_sc_cached_key *ck);
+
+/*
+ * --- Atomics ---
+ *
+ * Just enough to let application threads hand commands to the refresh
+ * thread (see cp_cmd_enqueue()). Core code can't assume <stdatomic.h> (MSVC
+ * C, some bare-metal toolchains) so these map to compiler builtins.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+static inline uint32_t osdp_atomic_load_u32(const uint32_t *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void osdp_atomic_store_u32(uint32_t *p, uint32_t val)
+{
+	__atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+static inline void *osdp_atomic_load_ptr(void *const *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void *osdp_atomic_xchg_ptr(void **p, void *val)
+{
+	return __atomic_exchange_n(p, val, __ATOMIC_ACQ_REL);
+}
+
+/* returns the value seen at *p; the swap happened iff that is `expected` */
+static inline void *osdp_atomic_cas_ptr(void **p, void *expected, void *val)
+{
+	__atomic_compare_exchange_n(p, &expected, val, false,
+				    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	return expected;
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+
+/*
+ * Loads must not write through their const pointer, so they are plain
+ * volatile reads (atomic when aligned) followed by an acquire barrier. x86
+ * and x64 only need the compiler barrier; ARM needs a dmb ish.
+ */
+#if defined(_M_ARM) || defined(_M_ARM64)
+#define osdp_atomic_acquire_barrier()  __dmb(0xB)
+#else
+#define osdp_atomic_acquire_barrier()  _ReadWriteBarrier()
+#endif
+
+static inline uint32_t osdp_atomic_load_u32(const uint32_t *p)
+{
+	uint32_t val = *(const volatile uint32_t *)p;
+
+	osdp_atomic_acquire_barrier();
+	return val;
+}
+
+static inline void osdp_atomic_store_u32(uint32_t *p, uint32_t val)
+{
+	_InterlockedExchange((volatile long *)p, (long)val);
+}
+
+static inline void *osdp_atomic_load_ptr(void *const *p)
+{
+	void *val = *(void *const volatile *)p;
+
+	osdp_atomic_acquire_barrier();
+	return val;
+}
+
+static inline void *osdp_atomic_xchg_ptr(void **p, void *val)
+{
+	return _InterlockedExchangePointer((void *volatile *)p, val);
+}
+
+static inline void *osdp_atomic_cas_ptr(void **p, void *expected, void *val)
+{
+	return _InterlockedCompareExchangePointer((void *volatile *)p,
+						  val, expected);
+}
+#else
+#error "No atomic builtins for this compiler"
+#endif
 
 /* --- Little-endian readers --- */
 
@@ -734,6 +968,8 @@ static inline void sc_deactivate(struct osdp_pd *pd)
 	if (sc_is_active(pd)) {
 		osdp_sc_teardown(pd);
 	}
+	/* a handshake that never completed may have keyed them already */
+	osdp_sc_release_keys(pd);
 	CLEAR_FLAG(pd, PD_FLAG_SC_ACTIVE);
 	/* Cached retransmit reply is no longer meaningful without SC. */
 	pd->last_tx_len = 0;
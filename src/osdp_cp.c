@@ -5,6 +5,7 @@
  */
 
 #include <stdlib.h>
+#include <limits.h>
 
 #include "osdp_common.h"
 #include "osdp_file.h"
@@ -43,6 +44,12 @@
 #define REPLY_BUSY_DATA_LEN            0
 #define REPLY_MFGREP_LEN               3   /* variable length command */
 
+/* pd->cmd_gate: what cp_submit_command() may know about the PD */
+#define CP_CMD_GATE_ONLINE             BIT(0)
+#define CP_CMD_GATE_DISABLED           BIT(1)
+#define CP_CMD_GATE_SC_ACTIVE          BIT(2)
+#define CP_CMD_GATE_ENFORCE_SECURE     BIT(3)
+
 enum osdp_cp_error_e {
 	OSDP_CP_ERR_NONE = 0,
 	OSDP_CP_ERR_GENERIC = -1,
@@ -55,12 +62,60 @@ enum osdp_cp_error_e {
 	OSDP_CP_ERR_APP = -8, /* Application layer error */
 };
 
+/*
+ * Event ring: osdp_cp_refresh() is the only producer and advances head;
+ * osdp_cp_poll_events() is the only consumer and advances tail. Both are
+ * free-running, so head - tail is the occupancy even across wrap-around.
+ */
+static inline uint32_t cp_event_ring_used(struct osdp *ctx)
+{
+	return ctx->event_ring.head -
+	       osdp_atomic_load_u32(&ctx->event_ring.tail);
+}
+
+static bool cp_event_ring_throttled(struct osdp_pd *pd)
+{
+	struct osdp *ctx = pd_to_osdp(pd);
+
+	return ctx->event_ring.buf &&
+	       ctx->event_ring.policy == OSDP_CP_EVENT_THROTTLE &&
+	       cp_event_ring_used(ctx) > ctx->event_ring.mask;
+}
+
+static void cp_event_ring_push(struct osdp_pd *pd,
+			       const struct osdp_event *event)
+{
+	struct osdp *ctx = pd_to_osdp(pd);
+	uint32_t head = ctx->event_ring.head;
+	uint32_t used = cp_event_ring_used(ctx);
+	struct osdp_cp_event *slot;
+
+	if (used > ctx->event_ring.mask) {
+		osdp_metrics_report(pd, OSDP_METRIC_EVENT_DROP);
+		LOG_WRN("Event ring full; dropped event %d", event->type);
+		return;
+	}
+	slot = &ctx->event_ring.buf[head & ctx->event_ring.mask];
+	slot->pd = pd->idx;
+	memcpy(&slot->event, event, sizeof(struct osdp_event));
+	osdp_atomic_store_u32(&ctx->event_ring.head, head + 1);
+	osdp_metrics_ring_level(pd, used + 1);
+	osdp_metrics_report(pd, OSDP_METRIC_EVENT);
+}
+
+static inline bool cp_event_sink_ready(struct osdp *ctx)
+{
+	return ctx->event_ring.buf || ctx->event_callback;
+}
+
 static void cp_dispatch_event(struct osdp_pd *pd,
 			      const struct osdp_event *event)
 {
 	struct osdp *ctx = pd_to_osdp(pd);
 
-	if (ctx->event_callback) {
+	if (ctx->event_ring.buf) {
+		cp_event_ring_push(pd, event);
+	} else if (ctx->event_callback) {
 		ctx->event_callback(ctx->event_callback_arg, pd->idx,
 				    (struct osdp_event *)event);
 		osdp_metrics_report(pd, OSDP_METRIC_EVENT);
@@ -70,6 +125,9 @@ static void cp_dispatch_event(struct osdp_pd *pd,
 static int cp_cmd_queue_init(struct osdp_pd *pd)
 {
 	queue_init(&pd->cmd_queue);
+	pd->cmd_inbox = NULL;
+	pd->cmd_gate = 0;
+	pd->batch_next = -1;
 	return 0;
 }
 
@@ -79,34 +137,297 @@ static inline void cp_cmd_free(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 	ARG_UNUSED(cmd);
 }
 
+/*
+ * Commands may be submitted from any thread while another one is inside
+ * osdp_cp_refresh(). Producers push onto pd->cmd_inbox, an intrusive
+ * lock-free stack linked through cmd->_node.next, with a single CAS; they
+ * never touch pd->cmd_queue. The refresh thread detaches the whole stack
+ * with one exchange (cp_cmd_inbox_drain()) and appends it, reversed back to
+ * submission order, to the private cmd_queue. Since the consumer only ever
+ * takes the entire list, a push-only stack has no ABA problem.
+ */
 static int cp_cmd_enqueue(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 {
-	queue_enqueue(&pd->cmd_queue, (queue_node_t *)&cmd->_node);
+	queue_node_t *node = (queue_node_t *)&cmd->_node;
+	void *head, *seen = osdp_atomic_load_ptr(&pd->cmd_inbox);
+
+	do {
+		head = seen;
+		node->next = head;
+		seen = osdp_atomic_cas_ptr(&pd->cmd_inbox, head, node);
+	} while (seen != head);
 	return 0;
 }
 
+static void cp_cmd_inbox_drain(struct osdp_pd *pd)
+{
+	queue_node_t *node, *next, *fifo = NULL;
+
+	if (osdp_atomic_load_ptr(&pd->cmd_inbox) == NULL) {
+		return;
+	}
+	node = osdp_atomic_xchg_ptr(&pd->cmd_inbox, NULL);
+	while (node) {
+		next = node->next;
+		node->next = fifo;
+		fifo = node;
+		node = next;
+	}
+	while (fifo) {
+		next = fifo->next;
+		queue_enqueue(&pd->cmd_queue, fifo);
+		fifo = next;
+	}
+}
+
 static int cp_cmd_dequeue(struct osdp_pd *pd, const struct osdp_cmd **cmd)
 {
 	queue_node_t *node;
 
+	cp_cmd_inbox_drain(pd);
 	if (queue_dequeue(&pd->cmd_queue, &node))
 		return -1;
 	*cmd = CONTAINER_OF(node, struct osdp_cmd, _node);
 	return 0;
 }
 
+static bool cp_batch_entry_ready(struct osdp_pd *pd);
+
+static bool cp_cmd_pending(struct osdp_pd *pd)
+{
+	queue_node_t *node;
+
+	return osdp_atomic_load_ptr(&pd->cmd_inbox) != NULL ||
+	       queue_peek_first(&pd->cmd_queue, &node) == 0 ||
+	       cp_batch_entry_ready(pd);
+}
+
+/*
+ * Snapshot the state checked at submission for producers on other threads.
+ * A pending enable/disable request wins over pd->state so that submissions
+ * stop as soon as osdp_cp_disable_pd() returns.
+ */
+static void cp_cmd_gate_publish(struct osdp_pd *pd)
+{
+	uint32_t gate = 0;
+
+	if (test_request(pd, CP_REQ_DISABLE)) {
+		gate |= CP_CMD_GATE_DISABLED;
+	} else if (test_request(pd, CP_REQ_ENABLE)) {
+		/* not online again until it has been through INIT */
+	} else if (pd->state == OSDP_CP_STATE_ONLINE) {
+		gate |= CP_CMD_GATE_ONLINE;
+	} else if (pd->state == OSDP_CP_STATE_DISABLED) {
+		gate |= CP_CMD_GATE_DISABLED;
+	}
+	if (sc_is_active(pd)) {
+		gate |= CP_CMD_GATE_SC_ACTIVE;
+	}
+	if (is_enforce_secure(pd)) {
+		gate |= CP_CMD_GATE_ENFORCE_SECURE;
+	}
+	if (gate != pd->cmd_gate) {
+		osdp_atomic_store_u32(&pd->cmd_gate, gate);
+	}
+}
+
+/*
+ * osdp_cp_submit_commands() batch. The submitter claims ctx->batch by
+ * swapping its cmds array into the empty slot, marks the PDs it picked and
+ * sets batch.ready. The refresh thread then starts the batch (one cursor per
+ * picked PD), sends the entries in place of the PDs' next polls and reports
+ * a single aggregated completion once every entry has been accounted for.
+ */
+static bool cp_cmd_is_batched(struct osdp *ctx, const struct osdp_cmd *cmd)
+{
+	const struct osdp_cmd *cmds = ctx->batch.cmds;
+
+	return ctx->batch.active && cmd >= cmds && cmd < cmds + ctx->batch.n;
+}
+
+static void cp_batch_finish(struct osdp *ctx)
+{
+	const struct osdp_cmd *cmds = ctx->batch.cmds;
+
+	ctx->batch.active = false;
+	/* the slot is free again before the app hears about it */
+	osdp_atomic_xchg_ptr(&ctx->batch.cmds, NULL);
+	if (ctx->command_completion_callback) {
+		ctx->command_completion_callback(
+			ctx->command_completion_callback_arg, OSDP_CP_BATCH_PD,
+			cmds, ctx->batch.status);
+	}
+}
+
+static void cp_batch_account(struct osdp *ctx, int count,
+			     enum osdp_completion_status status)
+{
+	if (status != OSDP_COMPLETION_OK &&
+	    ctx->batch.status == OSDP_COMPLETION_OK) {
+		ctx->batch.status = status;
+	}
+	ctx->batch.remaining -= count;
+	if (ctx->batch.remaining == 0) {
+		cp_batch_finish(ctx);
+	}
+}
+
+static void cp_batch_start(struct osdp *ctx)
+{
+	int i;
+	struct osdp_pd *pd;
+
+	if (!osdp_atomic_load_u32(&ctx->batch.ready)) {
+		return;
+	}
+	osdp_atomic_store_u32(&ctx->batch.ready, 0);
+	ctx->batch.active = true;
+	ctx->batch.remaining = 0;
+	ctx->batch.status = OSDP_COMPLETION_OK;
+	for (i = 0; i < NUM_PD(ctx); i++) {
+		pd = osdp_to_pd(ctx, i);
+		if (!pd->batch_sel) {
+			continue;
+		}
+		pd->batch_sel = false;
+		if (pd->state != OSDP_CP_STATE_ONLINE) {
+			/* went away after osdp_cp_submit_commands() checked */
+			ctx->batch.status = OSDP_COMPLETION_FAILED;
+			continue;
+		}
+		pd->batch_next = 0;
+		ctx->batch.remaining += ctx->batch.n;
+	}
+	if (ctx->batch.remaining == 0) {
+		cp_batch_finish(ctx);
+	}
+}
+
+/*
+ * Entry i goes out to every PD of the batch before entry i + 1 goes to any
+ * of them; a PD that is ahead keeps polling until the others catch up.
+ */
+static bool cp_batch_entry_ready(struct osdp_pd *pd)
+{
+	int i;
+	struct osdp *ctx = pd_to_osdp(pd);
+	struct osdp_pd *other;
+
+	if (pd->batch_next < 0) {
+		return false;
+	}
+	for (i = 0; i < NUM_PD(ctx); i++) {
+		other = osdp_to_pd(ctx, i);
+		if (other->batch_next >= 0 &&
+		    other->batch_next < pd->batch_next) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Drop this PD's unsent batch entries; returns how many there were */
+static int cp_batch_abandon(struct osdp_pd *pd,
+			    enum osdp_completion_status status)
+{
+	struct osdp *ctx = pd_to_osdp(pd);
+	int count;
+
+	if (pd->batch_next < 0) {
+		return 0;
+	}
+	count = ctx->batch.n - pd->batch_next;
+	pd->batch_next = -1;
+	cp_batch_account(ctx, count, status);
+	return count;
+}
+
 static inline void cp_complete_cmd(struct osdp_pd *pd,
 				   const struct osdp_cmd *cmd,
 				   enum osdp_completion_status status)
 {
 	struct osdp *ctx = pd_to_osdp(pd);
 
-	if (!cmd || !ctx->command_completion_callback)
+	if (!cmd)
+		return;
+	if (cp_cmd_is_batched(ctx, cmd)) {
+		cp_batch_account(ctx, 1, status);
+		return;
+	}
+	if (!ctx->command_completion_callback)
 		return;
 	ctx->command_completion_callback(ctx->command_completion_callback_arg,
 					 pd->idx, cmd, status);
 }
 
+/*
+ * Command packing. osdp_OUT, osdp_LED and osdp_BUZ carry a list of fixed
+ * size records which the PD applies in order. When enabled for a PD (see
+ * osdp_cp_set_command_packing()), the commands of the same kind queued right
+ * behind the one being started ride along as extra records of its packet
+ * instead of each costing a request/reply turn of their own.
+ */
+#define CP_PACK_OVERHEAD  32 /* header, SCB, MAC, CRC and SC block padding */
+
+static int cp_pack_record_len(int cmd_id)
+{
+	switch (cmd_id) {
+	case CMD_OUT: return CMD_OUT_LEN - 1;
+	case CMD_LED: return CMD_LED_LEN - 1;
+	case CMD_BUZ: return CMD_BUZ_LEN - 1;
+	default: return 0;
+	}
+}
+
+static void cp_pack_commands(struct osdp_pd *pd, int cmd_id)
+{
+	queue_node_t *node;
+	const struct osdp_cmd *next, *cmd = pd->active_cmd;
+	int rec_len = cp_pack_record_len(cmd_id);
+	int room = get_tx_buf_size(pd) - CP_PACK_OVERHEAD - 1 - rec_len;
+
+	if (!cmd || rec_len == 0 || cmd->flags || pd->pack.max <= 1) {
+		return;
+	}
+	while (pd->pack.n + 1 < pd->pack.max && room >= rec_len) {
+		if (queue_peek_first(&pd->cmd_queue, &node)) {
+			break;
+		}
+		next = CONTAINER_OF(node, struct osdp_cmd, _node);
+		if (next->id != cmd->id || next->flags) {
+			break;
+		}
+		queue_dequeue(&pd->cmd_queue, &node);
+		pd->pack.cmds[pd->pack.n++] = next;
+		cp_cmd_free(pd, next);
+		room -= rec_len;
+	}
+	if (pd->pack.n) {
+		osdp_metrics_add(pd, OSDP_METRIC_CMD_PACKED, pd->pack.n);
+	}
+}
+
+/* Record i of the active packet: active_cmd first, then the packed ones */
+static inline const struct osdp_cmd *cp_pack_record(struct osdp_pd *pd,
+						    const struct osdp_cmd *cmd,
+						    int i)
+{
+	return i == 0 ? cmd : pd->pack.cmds[i - 1];
+}
+
+static void cp_complete_active_cmd(struct osdp_pd *pd,
+				   enum osdp_completion_status status)
+{
+	int i;
+
+	cp_complete_cmd(pd, pd->active_cmd, status);
+	for (i = 0; i < pd->pack.n; i++) {
+		cp_complete_cmd(pd, pd->pack.cmds[i], status);
+	}
+	pd->active_cmd = NULL;
+	pd->pack.n = 0;
+}
+
 static const char *cp_get_cap_name(int cap)
 {
 	if (cap <= OSDP_PD_CAP_UNUSED || cap >= OSDP_PD_CAP_SENTINEL) {
@@ -141,13 +462,91 @@ static inline void assert_buf_len(int need, int have)
 	(void)have;
 }
 
+/*
+ * Encode the data block (everything after the command byte) of an app
+ * command of the kinds that can be packed or compiled into a template.
+ * Returns the length written or -1 if it doesn't fit or is invalid.
+ */
+static int cp_encode_cmd_data(int cmd_id, const struct osdp_cmd *cmd,
+			      uint8_t *buf, int max_len)
+{
+	int len = 0;
+
+	switch (cmd_id) {
+	case CMD_OUT:
+		if (max_len < CMD_OUT_LEN - 1) {
+			return -1;
+		}
+		buf[len++] = cmd->output.output_no;
+		buf[len++] = cmd->output.control_code;
+		bwrite_u16_le(cmd->output.timer_count, buf, &len);
+		break;
+	case CMD_LED:
+		if (max_len < CMD_LED_LEN - 1) {
+			return -1;
+		}
+		buf[len++] = cmd->led.reader;
+		buf[len++] = cmd->led.led_number;
+
+		buf[len++] = cmd->led.temporary.control_code;
+		buf[len++] = cmd->led.temporary.on_count;
+		buf[len++] = cmd->led.temporary.off_count;
+		buf[len++] = cmd->led.temporary.on_color;
+		buf[len++] = cmd->led.temporary.off_color;
+		bwrite_u16_le(cmd->led.temporary.timer_count, buf, &len);
+
+		buf[len++] = cmd->led.permanent.control_code;
+		buf[len++] = cmd->led.permanent.on_count;
+		buf[len++] = cmd->led.permanent.off_count;
+		buf[len++] = cmd->led.permanent.on_color;
+		buf[len++] = cmd->led.permanent.off_color;
+		break;
+	case CMD_BUZ:
+		if (max_len < CMD_BUZ_LEN - 1) {
+			return -1;
+		}
+		buf[len++] = cmd->buzzer.reader;
+		buf[len++] = cmd->buzzer.control_code;
+		buf[len++] = cmd->buzzer.on_count;
+		buf[len++] = cmd->buzzer.off_count;
+		buf[len++] = cmd->buzzer.rep_count;
+		break;
+	case CMD_TEXT:
+		if (cmd->text.length > OSDP_CMD_TEXT_MAX_LEN ||
+		    max_len < CMD_TEXT_LEN - 1 + cmd->text.length) {
+			return -1;
+		}
+		buf[len++] = cmd->text.reader;
+		buf[len++] = cmd->text.control_code;
+		buf[len++] = cmd->text.temp_time;
+		buf[len++] = cmd->text.offset_row;
+		buf[len++] = cmd->text.offset_col;
+		buf[len++] = cmd->text.length;
+		memcpy(buf + len, cmd->text.data, cmd->text.length);
+		len += cmd->text.length;
+		break;
+	case CMD_MFG:
+		if (cmd->mfg.length > OSDP_CMD_MFG_MAX_DATALEN ||
+		    max_len < CMD_MFG_LEN - 1 + cmd->mfg.length) {
+			return -1;
+		}
+		bwrite_u24_le(cmd->mfg.vendor_code, buf, &len);
+		memcpy(buf + len, cmd->mfg.data, cmd->mfg.length);
+		len += cmd->mfg.length;
+		break;
+	default:
+		return -1;
+	}
+	return len;
+}
+
 static void fill_local_keyset_cmd(struct osdp_pd *pd, struct osdp_cmd *cmd);
 
 static int cp_build_command(struct osdp_pd *pd, const struct osdp_cmd *active_cmd,
 			    uint8_t *buf, int max_len)
 {
 	const struct osdp_cmd *cmd = active_cmd;
-	int ret, len = 0;
+	int i, ret, len = 0;
 	int data_off = osdp_phy_packet_get_data_offset(pd, buf);
 	uint8_t *smb = osdp_phy_packet_get_smb(pd, buf);
 
@@ -189,63 +588,34 @@ static int cp_build_command(struct osdp_pd *pd, const struct osdp_cmd *active_cm
 		buf[len++] = 0x00;
 		break;
 	case CMD_OUT:
-		assert_buf_len(CMD_OUT_LEN, max_len);
-		if (!cmd) {
-			return OSDP_CP_ERR_GENERIC;
-		}
-		buf[len++] = pd->cmd_id;
-		buf[len++] = cmd->output.output_no;
-		buf[len++] = cmd->output.control_code;
-		bwrite_u16_le(cmd->output.timer_count, buf, &len);
-		break;
 	case CMD_LED:
-		assert_buf_len(CMD_LED_LEN, max_len);
+	case CMD_BUZ:
+	case CMD_TEXT:
+	case CMD_MFG:
 		if (!cmd) {
 			return OSDP_CP_ERR_GENERIC;
 		}
 		buf[len++] = pd->cmd_id;
-		buf[len++] = cmd->led.reader;
-		buf[len++] = cmd->led.led_number;
-
-		buf[len++] = cmd->led.temporary.control_code;
-		buf[len++] = cmd->led.temporary.on_count;
-		buf[len++] = cmd->led.temporary.off_count;
-		buf[len++] = cmd->led.temporary.on_color;
-		buf[len++] = cmd->led.temporary.off_color;
-		bwrite_u16_le(cmd->led.temporary.timer_count, buf, &len);
+		if (cmd->flags & OSDP_CMD_FLAG_TEMPLATE) {
+			const struct osdp_cmd_template *tmpl;
 
-		buf[len++] = cmd->led.permanent.control_code;
-		buf[len++] = cmd->led.permanent.on_count;
-		buf[len++] = cmd->led.permanent.off_count;
-		buf[len++] = cmd->led.permanent.on_color;
-		buf[len++] = cmd->led.permanent.off_color;
-		break;
-	case CMD_BUZ:
-		assert_buf_len(CMD_BUZ_LEN, max_len);
-		if (!cmd) {
-			return OSDP_CP_ERR_GENERIC;
+			tmpl = CONTAINER_OF(cmd, struct osdp_cmd_template, cmd);
+			assert_buf_len(1 + tmpl->len, max_len);
+			memcpy(buf + len, tmpl->data, tmpl->len);
+			len += tmpl->len;
+			break;
 		}
-		buf[len++] = pd->cmd_id;
-		buf[len++] = cmd->buzzer.reader;
-		buf[len++] = cmd->buzzer.control_code;
-		buf[len++] = cmd->buzzer.on_count;
-		buf[len++] = cmd->buzzer.off_count;
-		buf[len++] = cmd->buzzer.rep_count;
-		break;
-	case CMD_TEXT:
-		if (!cmd) {
-			return OSDP_CP_ERR_GENERIC;
+		for (i = 0; i <= pd->pack.n; i++) {
+			cmd = cp_pack_record(pd, active_cmd, i);
+			ret = cp_encode_cmd_data(pd->cmd_id, cmd, buf + len,
+						 max_len - len);
+			if (ret < 0) {
+				LOG_ERR("Invalid %s command data",
+					osdp_cmd_name(pd->cmd_id));
+				return OSDP_CP_ERR_GENERIC;
+			}
+			len += ret;
 		}
-		assert_buf_len(CMD_TEXT_LEN + cmd->text.length, max_len);
-		buf[len++] = pd->cmd_id;
-		buf[len++] = cmd->text.reader;
-		buf[len++] = cmd->text.control_code;
-		buf[len++] = cmd->text.temp_time;
-		buf[len++] = cmd->text.offset_row;
-		buf[len++] = cmd->text.offset_col;
-		buf[len++] = cmd->text.length;
-		memcpy(buf + len, cmd->text.data, cmd->text.length);
-		len += cmd->text.length;
 		break;
 	case CMD_COMSET:
 		assert_buf_len(CMD_COMSET_LEN, max_len);
@@ -256,20 +626,6 @@ static int cp_build_command(struct osdp_pd *pd, const struct osdp_cmd *active_cm
 		buf[len++] = cmd->comset.address;
 		bwrite_u32_le(cmd->comset.baud_rate, buf, &len);
 		break;
-	case CMD_MFG:
-		if (!cmd) {
-			return OSDP_CP_ERR_GENERIC;
-		}
-		assert_buf_len(CMD_MFG_LEN + cmd->mfg.length, max_len);
-		if (cmd->mfg.length > OSDP_CMD_MFG_MAX_DATALEN) {
-			LOG_ERR("Invalid MFG data length (%d)", cmd->mfg.length);
-			return OSDP_CP_ERR_GENERIC;
-		}
-		buf[len++] = pd->cmd_id;
-		bwrite_u24_le(cmd->mfg.vendor_code, buf, &len);
-		memcpy(buf + len, cmd->mfg.data, cmd->mfg.length);
-		len += cmd->mfg.length;
-		break;
 	case CMD_ACURXSIZE:
 		buf[len++] = pd->cmd_id;
 		bwrite_u16_le(OSDP_PACKET_BUF_SIZE, buf, &len);
@@ -595,7 +951,10 @@ static int cp_decode_response(struct osdp_pd *pd, uint8_t *buf, int len)
 		memcpy(pd->sc.pd_random, buf + pos + 8, 8);
 		memcpy(pd->sc.pd_cryptogram, buf + pos + 16, 16);
 		pos += 32;
-		osdp_compute_session_keys(pd);
+		if (!pd->sc.keys_ready) {
+			/* not done while the bus was busy; see cp_sc_prepare() */
+			osdp_compute_session_keys(pd);
+		}
 		if (osdp_verify_pd_cryptogram(pd) != 0) {
 			LOG_ERR("Failed to verify PD cryptogram");
 			osdp_metrics_report(pd, OSDP_METRIC_SC_FAILURE);
@@ -719,10 +1078,16 @@ static int cp_process_reply(struct osdp_pd *pd)
 	return cp_decode_response(pd, buf, len);
 }
 
+/* Staggered by PD index so a bus that lost SC at once doesn't rekey at once */
+static inline uint32_t cp_sc_retry_ms(struct osdp_pd *pd)
+{
+	return OSDP_PD_SC_RETRY_MS + pd->idx * OSDP_PD_SC_RETRY_STAGGER_MS;
+}
+
 static inline bool cp_sc_should_retry(struct osdp_pd *pd)
 {
 	return (sc_is_capable(pd) && !sc_is_active(pd) &&
-		osdp_millis_since(pd->sc_tstamp) > OSDP_PD_SC_RETRY_MS);
+		osdp_millis_since(pd->sc_tstamp) > cp_sc_retry_ms(pd));
 }
 
 static int cp_translate_cmd(struct osdp_pd *pd, const struct osdp_cmd *cmd)
@@ -793,7 +1158,11 @@ static inline bool cp_phy_kick(struct osdp_pd *pd)
 
 static void cp_phy_state_done(struct osdp_pd *pd)
 {
+	uint32_t rtt = osdp_millis_since(pd->phy_tstamp);
+
 	/* called when we have a valid response from the PD */
+	osdp_metrics_sample(pd, OSDP_METRIC_HIST_RTT, rtt);
+	osdp_metrics_add(pd, OSDP_METRIC_BUS_BUSY_MS, rtt);
 	if (sc_is_active(pd)) {
 		pd->sc_tstamp = osdp_millis_now();
 	}
@@ -865,12 +1234,14 @@ static int cp_phy_state_update(struct osdp_pd *pd)
 		osdp_phy_state_reset(pd, false);
 		pd->reply_id = REPLY_INVALID;
 		pd->phy_state = OSDP_CP_PHY_STATE_REPLY_WAIT;
+		pd->phy_rx_seen = false;
 		pd->phy_tstamp = osdp_millis_now();
 		pd->resp_expected = pd->phy_tstamp + OSDP_RESP_TOUT_MS + cp_calculate_transmit_time(pd);
 		break;
 	case OSDP_CP_PHY_STATE_REPLY_WAIT:
 		rc = cp_process_reply(pd);
-		if (IS_ENABLED(OPT_OSDP_RX_ZERO_COPY)) {
+		if (IS_ENABLED(OPT_OSDP_RX_ZERO_COPY) ||
+		    IS_ENABLED(OPT_OSDP_RX_ARENA)) {
 			osdp_phy_release_packet(pd);
 		}
 		if (rc == OSDP_CP_ERR_NONE || rc == OSDP_CP_ERR_APP) {
@@ -894,6 +1265,10 @@ static int cp_phy_state_update(struct osdp_pd *pd)
 			return OSDP_CP_ERR_DEFER;
 		}
 		if (osdp_millis_now() > pd->resp_expected) {
+			if (pd->state == OSDP_CP_STATE_PROBE) {
+				/* one shot; the offline backoff paces probes */
+				goto error;
+			}
 			if (pd->phy_retry_count < OSDP_CMD_MAX_RETRIES) {
 				pd->phy_retry_count += 1;
 				LOG_DBG("No response in %dms post-transmit; probing (%d)",
@@ -916,49 +1291,148 @@ error:
 	return OSDP_CP_ERR_GENERIC;
 }
 
-static const char *state_get_name(enum osdp_cp_state_e state)
+static const char *state_get_name(enum osdp_cp_state_e state)
+{
+	switch (state) {
+	case OSDP_CP_STATE_INIT:      return "ID-Request";
+	case OSDP_CP_STATE_CAPDET:    return "Cap-Detect";
+	case OSDP_CP_STATE_SC_CHLNG:  return "SC-Chlng";
+	case OSDP_CP_STATE_SC_SCRYPT: return "SC-Scrypt";
+	case OSDP_CP_STATE_SET_SCBK:  return "SC-SetSCBK";
+	case OSDP_CP_STATE_ONLINE:    return "Online";
+	case OSDP_CP_STATE_PROBE:     return "Probe";
+	case OSDP_CP_STATE_OFFLINE:   return "Offline";
+	case OSDP_CP_STATE_DISABLED:  return "Disabled";
+	default:
+		BUG();
+	}
+}
+
+/* time one round over every PD on this bus costs, from measured RTTs */
+static uint32_t cp_poll_bus_round_ms(struct osdp_pd *pd)
+{
+	int i;
+	uint32_t sum = 0;
+	struct osdp *ctx = pd_to_osdp(pd);
+
+	for (i = 0; i < ctx->_num_pd; i++) {
+		sum += osdp_to_pd(ctx, i)->poll.rtt_ms;
+	}
+	return sum;
+}
+
+_Static_assert(OSDP_PD_POLL_PRIORITY_MAX < 16,
+	       "OSDP_PD_POLL_PRIORITY_MAX shifts the poll interval too far");
+
+static uint32_t cp_poll_interval(struct osdp_pd *pd)
+{
+	uint32_t ms = OSDP_PD_POLL_TIMEOUT_MS, round_ms;
+
+	switch (pd_to_osdp(pd)->poll_policy) {
+	case OSDP_CP_POLL_ACTIVITY:
+		if (pd->poll.idle_polls < 16) {
+			ms <<= pd->poll.idle_polls;
+		}
+		if (pd->poll.idle_polls >= 16 || ms > OSDP_PD_POLL_IDLE_MAX_MS) {
+			ms = OSDP_PD_POLL_IDLE_MAX_MS;
+		}
+		break;
+	case OSDP_CP_POLL_PRIORITY:
+		ms <<= (pd->poll.priority < OSDP_PD_POLL_PRIORITY_MAX) ?
+		       pd->poll.priority : OSDP_PD_POLL_PRIORITY_MAX;
+		break;
+	case OSDP_CP_POLL_LATENCY:
+		if (pd->poll.latency_ms == 0) {
+			break;
+		}
+		round_ms = cp_poll_bus_round_ms(pd);
+		ms = (pd->poll.latency_ms > round_ms) ?
+		     pd->poll.latency_ms - round_ms : 0;
+		break;
+	default:
+		break;
+	}
+	/* a target the bus can't meet must not turn into back-to-back polls */
+	return (ms > OSDP_PD_POLL_MIN_MS) ? ms : OSDP_PD_POLL_MIN_MS;
+}
+
+/*
+ * Called once per completed exchange with an online PD. Feeds the
+ * smoothed RTT (1/8 EWMA, like TCP's SRTT) and the idle-poll streak the
+ * policies above work from. A poll answered with anything but a bare ACK,
+ * or any other command, counts as activity.
+ */
+static void cp_poll_sched_update(struct osdp_pd *pd)
+{
+	uint32_t rtt = osdp_millis_since(pd->phy_tstamp);
+
+	if (pd->poll.rtt_ms == 0) {
+		pd->poll.rtt_ms = rtt;
+	} else {
+		pd->poll.rtt_ms = (pd->poll.rtt_ms * 7 + rtt) / 8;
+	}
+
+	if (pd->cmd_id == CMD_POLL && pd->reply_id == REPLY_ACK) {
+		osdp_metrics_report(pd, OSDP_METRIC_POLL_IDLE);
+		if (pd->poll.idle_polls < UINT8_MAX) {
+			pd->poll.idle_polls++;
+		}
+	} else {
+		pd->poll.idle_polls = 0;
+	}
+	pd->poll.interval_ms = cp_poll_interval(pd);
+}
+
+static int cp_start_cmd(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 {
-	switch (state) {
-	case OSDP_CP_STATE_INIT:      return "ID-Request";
-	case OSDP_CP_STATE_CAPDET:    return "Cap-Detect";
-	case OSDP_CP_STATE_SC_CHLNG:  return "SC-Chlng";
-	case OSDP_CP_STATE_SC_SCRYPT: return "SC-Scrypt";
-	case OSDP_CP_STATE_SET_SCBK:  return "SC-SetSCBK";
-	case OSDP_CP_STATE_ONLINE:    return "Online";
-	case OSDP_CP_STATE_OFFLINE:   return "Offline";
-	case OSDP_CP_STATE_DISABLED:  return "Disabled";
-	default:
-		BUG();
+	int ret;
+
+	ret = cp_translate_cmd(pd, cmd);
+	if (cmd->flags & OSDP_CMD_FLAG_BROADCAST) {
+		SET_FLAG(pd, PD_FLAG_PKT_BROADCAST);
+	}
+	if (ret < 0) {
+		cp_complete_cmd(pd, cmd, OSDP_COMPLETION_FAILED);
+		pd->active_cmd = NULL;
+	} else {
+		pd->active_cmd = cmd;
 	}
+	return ret;
 }
 
 static int cp_get_online_command(struct osdp_pd *pd)
 {
+	struct osdp *ctx = pd_to_osdp(pd);
 	const struct osdp_cmd *cmd;
 	int ret;
 
 	if (cp_cmd_dequeue(pd, &cmd) == 0) {
-		ret = cp_translate_cmd(pd, cmd);
-		if (cmd->flags & OSDP_CMD_FLAG_BROADCAST) {
-			SET_FLAG(pd, PD_FLAG_PKT_BROADCAST);
-		}
-		if (ret < 0) {
-			cp_complete_cmd(pd, cmd, OSDP_COMPLETION_FAILED);
-			pd->active_cmd = NULL;
-		} else {
-			pd->active_cmd = cmd;
-		}
+		ret = cp_start_cmd(pd, cmd);
 		cp_cmd_free(pd, cmd);
+		if (ret > 0) {
+			cp_pack_commands(pd, ret);
+		}
 		return ret;
 	}
 
+	/* batch entries take the slot of this PD's next poll */
+	if (cp_batch_entry_ready(pd)) {
+		cmd = (const struct osdp_cmd *)ctx->batch.cmds + pd->batch_next;
+		if (++pd->batch_next == ctx->batch.n) {
+			pd->batch_next = -1;
+		}
+		return cp_start_cmd(pd, cmd);
+	}
+
 	ret = osdp_file_tx_get_command(pd);
 	if (ret != 0) {
 		return ret;
 	}
 
-	if (osdp_millis_since(pd->tstamp) > OSDP_PD_POLL_TIMEOUT_MS) {
+	if (osdp_millis_since(pd->tstamp) > pd->poll.interval_ms &&
+	    !cp_event_ring_throttled(pd)) {
 		pd->tstamp = osdp_millis_now();
+		osdp_metrics_report(pd, OSDP_METRIC_POLL);
 		return CMD_POLL;
 	}
 
@@ -970,15 +1444,60 @@ static void notify_pd_status(struct osdp_pd *pd, bool is_online)
 	struct osdp *ctx = pd_to_osdp(pd);
 	struct osdp_event evt;
 
-	if (!ctx->event_callback || !is_notifications_enabled(pd)) {
+	/*
+	 * Only actual online <-> offline transitions are reported; a PD that
+	 * answers probes but keeps failing the handshake stays quiet.
+	 */
+	if (is_online == ISSET_FLAG(pd, PD_FLAG_NOTIF_ONLINE)) {
+		return;
+	}
+	SET_FLAG_V(pd, PD_FLAG_NOTIF_ONLINE, is_online)
+
+	if (!cp_event_sink_ready(ctx) || !is_notifications_enabled(pd)) {
 		return;
 	}
 
 	evt.type = OSDP_EVENT_NOTIFICATION;
 	evt.notif.type = OSDP_NOTIFICATION_PD_STATUS;
 	evt.notif.arg0 = is_online;
-	ctx->event_callback(ctx->event_callback_arg, pd->idx, &evt);
-	osdp_metrics_report(pd, OSDP_METRIC_EVENT);
+	cp_dispatch_event(pd, &evt);
+}
+
+/*
+ * The clock for osdp_cp_get_time_to_secure() starts at setup or when a PD
+ * loses SC on an all secure bus, and stops when the last PD that should
+ * be secure (has a SCBK, is not disabled and, once we know, can do SC)
+ * comes up with its own SCBK.
+ */
+static void cp_secure_time_update(struct osdp_pd *pd)
+{
+	int i;
+	struct osdp *ctx = pd_to_osdp(pd);
+	struct osdp_pd *p;
+
+	if (!sc_is_active(pd)) {
+		if (ctx->secure.ms >= 0) {
+			ctx->secure.ms = -1;
+			ctx->secure.since = osdp_millis_now();
+		}
+		return;
+	}
+	if (ctx->secure.ms >= 0) {
+		return;
+	}
+	for (i = 0; i < ctx->_num_pd; i++) {
+		p = osdp_to_pd(ctx, i);
+		if (ISSET_FLAG(p, PD_FLAG_SC_DISABLED) ||
+		    p->state == OSDP_CP_STATE_DISABLED ||
+		    (p->state == OSDP_CP_STATE_ONLINE && !sc_is_capable(p))) {
+			continue;
+		}
+		if (!sc_is_active(p) || sc_use_scbkd(p)) {
+			return;
+		}
+	}
+	ctx->secure.ms = (int)osdp_millis_since(ctx->secure.since);
+	LOG_INF("All PDs secure in %dms", ctx->secure.ms);
 }
 
 static void notify_sc_status(struct osdp_pd *pd)
@@ -986,7 +1505,9 @@ static void notify_sc_status(struct osdp_pd *pd)
 	struct osdp *ctx = pd_to_osdp(pd);
 	struct osdp_event evt;
 
-	if (!ctx->event_callback || !is_notifications_enabled(pd)) {
+	cp_secure_time_update(pd);
+
+	if (!cp_event_sink_ready(ctx) || !is_notifications_enabled(pd)) {
 		return;
 	}
 
@@ -994,8 +1515,7 @@ static void notify_sc_status(struct osdp_pd *pd)
 	evt.notif.type = OSDP_NOTIFICATION_SC_STATUS;
 	evt.notif.arg0 = sc_is_active(pd);
 	evt.notif.arg1 = sc_use_scbkd(pd);
-	ctx->event_callback(ctx->event_callback_arg, pd->idx, &evt);
-	osdp_metrics_report(pd, OSDP_METRIC_EVENT);
+	cp_dispatch_event(pd, &evt);
 }
 
 void osdp_file_tx_notify_done(struct osdp_pd *pd, int file_id,
@@ -1004,7 +1524,7 @@ void osdp_file_tx_notify_done(struct osdp_pd *pd, int file_id,
 	struct osdp *ctx = pd_to_osdp(pd);
 	struct osdp_event evt;
 
-	if (!ctx->event_callback || !is_notifications_enabled(pd)) {
+	if (!cp_event_sink_ready(ctx) || !is_notifications_enabled(pd)) {
 		return;
 	}
 
@@ -1012,8 +1532,20 @@ void osdp_file_tx_notify_done(struct osdp_pd *pd, int file_id,
 	evt.notif.type = OSDP_NOTIFICATION_FILE_TX_DONE;
 	evt.notif.arg0 = file_id;
 	evt.notif.arg1 = outcome;
-	ctx->event_callback(ctx->event_callback_arg, pd->idx, &evt);
-	osdp_metrics_report(pd, OSDP_METRIC_EVENT);
+	cp_dispatch_event(pd, &evt);
+}
+
+/*
+ * Session keys are derived from SCBK or SCBK-D depending on this flag, so
+ * any that cp_sc_prepare() already computed are stale once it flips.
+ */
+static void cp_sc_use_scbkd(struct osdp_pd *pd, bool use)
+{
+	if (sc_use_scbkd(pd) == use) {
+		return;
+	}
+	SET_FLAG_V(pd, PD_FLAG_SC_USE_SCBKD, use)
+	osdp_sc_release_keys(pd);
 }
 
 static void cp_keyset_complete(struct osdp_pd *pd)
@@ -1027,7 +1559,7 @@ static void cp_keyset_complete(struct osdp_pd *pd)
 			memcpy(pd->sc.scbk, cmd->keyset.data, 16);
 		}
 	} else {
-		CLEAR_FLAG(pd, PD_FLAG_SC_USE_SCBKD);
+		cp_sc_use_scbkd(pd, false);
 	}
 	sc_deactivate(pd);
 	notify_sc_status(pd);
@@ -1103,6 +1635,7 @@ static inline int state_get_cmd(struct osdp_pd *pd)
 	case OSDP_CP_STATE_SC_SCRYPT: return CMD_SCRYPT;
 	case OSDP_CP_STATE_SET_SCBK:  return CMD_KEYSET;
 	case OSDP_CP_STATE_ONLINE:    return cp_get_online_command(pd);
+	case OSDP_CP_STATE_PROBE:     return CMD_POLL;
 	default: return -1;
 	}
 }
@@ -1118,6 +1651,7 @@ static inline bool state_check_reply(struct osdp_pd *pd)
 	case OSDP_CP_STATE_SC_SCRYPT: return pd->reply_id == REPLY_RMAC_I;
 	case OSDP_CP_STATE_SET_SCBK:  return pd->reply_id == REPLY_ACK;
 	case OSDP_CP_STATE_ONLINE:    return cp_check_online_response(pd);
+	case OSDP_CP_STATE_PROBE:     return pd->reply_id != REPLY_INVALID;
 	default: return false;
 	}
 }
@@ -1131,7 +1665,7 @@ static enum osdp_cp_state_e get_next_ok_state(struct osdp_pd *pd)
 		return OSDP_CP_STATE_CAPDET;
 	case OSDP_CP_STATE_CAPDET:
 		if (sc_is_capable(pd)) {
-			CLEAR_FLAG(pd, PD_FLAG_SC_USE_SCBKD);
+			cp_sc_use_scbkd(pd, false);
 			return OSDP_CP_STATE_SC_CHLNG;
 		}
 		if (is_enforce_secure(pd)) {
@@ -1157,13 +1691,16 @@ static enum osdp_cp_state_e get_next_ok_state(struct osdp_pd *pd)
 	case OSDP_CP_STATE_ONLINE:
 		if (cp_sc_should_retry(pd)) {
 			LOG_INF("Attempting to restart SC after %d seconds",
-				OSDP_PD_SC_RETRY_MS/1000);
+				cp_sc_retry_ms(pd) / 1000);
 			return OSDP_CP_STATE_SC_CHLNG;
 		}
 		return OSDP_CP_STATE_ONLINE;
+	case OSDP_CP_STATE_PROBE:
+		/* someone is there; redo the full handshake */
+		return OSDP_CP_STATE_INIT;
 	case OSDP_CP_STATE_OFFLINE:
 		if (osdp_millis_since(pd->tstamp) > pd->wait_ms) {
-			return OSDP_CP_STATE_INIT;
+			return OSDP_CP_STATE_PROBE;
 		}
 		return OSDP_CP_STATE_OFFLINE;
 	case OSDP_CP_STATE_DISABLED:
@@ -1188,11 +1725,11 @@ static enum osdp_cp_state_e get_next_err_state(struct osdp_pd *pd)
 			return OSDP_CP_STATE_OFFLINE;
 		}
 		if (!sc_use_scbkd(pd)) {
-			SET_FLAG(pd, PD_FLAG_SC_USE_SCBKD);
+			cp_sc_use_scbkd(pd, true);
 			LOG_WRN("SC Failed. Retry with SCBK-D");
 			return OSDP_CP_STATE_SC_CHLNG;
 		}
-		CLEAR_FLAG(pd, PD_FLAG_SC_USE_SCBKD);
+		cp_sc_use_scbkd(pd, false);
 		/**
 		 * SC setup failed; Update sc_tstamp so the next retry happens
 		 * after OSDP_PD_SC_RETRY_MS.
@@ -1217,6 +1754,8 @@ static enum osdp_cp_state_e get_next_err_state(struct osdp_pd *pd)
 		return OSDP_CP_STATE_ONLINE;
 	case OSDP_CP_STATE_ONLINE:
 		return OSDP_CP_STATE_OFFLINE;
+	case OSDP_CP_STATE_PROBE:
+		return OSDP_CP_STATE_OFFLINE;
 	case OSDP_CP_STATE_OFFLINE:
 		return OSDP_CP_STATE_OFFLINE;
 	case OSDP_CP_STATE_DISABLED:
@@ -1230,6 +1769,38 @@ static inline enum osdp_cp_state_e get_next_state(struct osdp_pd *pd, int err)
 	return (err == 0) ? get_next_ok_state(pd) : get_next_err_state(pd);
 }
 
+/*
+ * How long to stay offline before the next probe. The first probe after
+ * losing a PD goes out OSDP_ONLINE_RETRY_WAIT_MIN_MS later and every failed
+ * attempt to bring it back doubles that, up to OSDP_ONLINE_RETRY_WAIT_MAX_MS.
+ * Up to OSDP_ONLINE_RETRY_JITTER_PCT percent is added at random so that
+ * PDs lost together (say, to a power blip) are not all probed in lockstep
+ * when they come back.
+ */
+static uint32_t cp_offline_wait(struct osdp_pd *pd)
+{
+	uint32_t x, ms = pd->backoff.wait_ms;
+
+	if (ms == 0) {
+		ms = OSDP_ONLINE_RETRY_WAIT_MIN_MS;
+		pd->backoff.since = osdp_millis_now();
+	} else if (ms < OSDP_ONLINE_RETRY_WAIT_MAX_MS / 2) {
+		ms *= 2;
+	} else {
+		ms = OSDP_ONLINE_RETRY_WAIT_MAX_MS;
+	}
+	pd->backoff.wait_ms = ms;
+
+	x = pd->backoff.rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pd->backoff.rng = x;
+	ms += x % (ms / 100 * OSDP_ONLINE_RETRY_JITTER_PCT + 1);
+	return (ms < OSDP_ONLINE_RETRY_WAIT_MAX_MS) ?
+		ms : OSDP_ONLINE_RETRY_WAIT_MAX_MS;
+}
+
 static void cp_state_change(struct osdp_pd *pd, enum osdp_cp_state_e next)
 {
 	enum osdp_cp_state_e cur = pd->state;
@@ -1239,17 +1810,35 @@ static void cp_state_change(struct osdp_pd *pd, enum osdp_cp_state_e next)
 		osdp_phy_state_reset(pd, true);
 		break;
 	case OSDP_CP_STATE_ONLINE:
+		pd->poll.idle_polls = 0;
+		pd->poll.interval_ms = cp_poll_interval(pd);
+		if (pd->backoff.wait_ms) {
+			osdp_metrics_report(pd, OSDP_METRIC_RECOVER);
+			osdp_metrics_add(pd, OSDP_METRIC_RECOVER_MS,
+					 osdp_millis_since(pd->backoff.since));
+			pd->backoff.wait_ms = 0;
+		}
 		LOG_INF("Online; %s SC", sc_is_active(pd) ? "With" : "Without");
 		notify_pd_status(pd, true);
 		break;
+	case OSDP_CP_STATE_PROBE:
+		osdp_phy_state_reset(pd, true);
+		osdp_metrics_report(pd, OSDP_METRIC_PROBE);
+		break;
 	case OSDP_CP_STATE_OFFLINE:
 		pd->tstamp = osdp_millis_now();
-		pd->wait_ms = OSDP_ONLINE_RETRY_WAIT_MAX_MS;
+		pd->wait_ms = cp_offline_wait(pd);
+		if (cur == OSDP_CP_STATE_PROBE) {
+			LOG_DBG("No reply to probe; next one in %ums",
+				pd->wait_ms);
+			break;
+		}
 		sc_deactivate(pd);
 		notify_sc_status(pd);
-		LOG_ERR("Going offline for %d seconds; Was in '%s' state",
-			pd->wait_ms / 1000, state_get_name(cur));
+		LOG_ERR("Going offline for %ums; Was in '%s' state",
+			pd->wait_ms, state_get_name(cur));
 		osdp_file_tx_abort(pd);
+		cp_batch_abandon(pd, OSDP_COMPLETION_FAILED);
 		notify_pd_status(pd, false);
 		break;
 	case OSDP_CP_STATE_SC_CHLNG:
@@ -1257,9 +1846,11 @@ static void cp_state_change(struct osdp_pd *pd, enum osdp_cp_state_e next)
 		osdp_sc_setup(pd);
 		break;
 	case OSDP_CP_STATE_DISABLED:
+		pd->backoff.wait_ms = 0;
 		sc_deactivate(pd);
 		notify_sc_status(pd);
 		osdp_file_tx_abort(pd);
+		cp_batch_abandon(pd, OSDP_COMPLETION_FAILED);
 		notify_pd_status(pd, false);
 		osdp_phy_state_reset(pd, true);
 		LOG_INF("PD disabled; going offline until re-enabled");
@@ -1279,11 +1870,11 @@ static void cp_state_change(struct osdp_pd *pd, enum osdp_cp_state_e next)
 
 static void notify_command_status(struct osdp_pd *pd, int status)
 {
-	int app_cmd;
+	int i, app_cmd;
 	struct osdp_event evt;
 	struct osdp *ctx = pd_to_osdp(pd);
 
-	if (!ctx->event_callback || !is_notifications_enabled(pd)) {
+	if (!cp_event_sink_ready(ctx) || !is_notifications_enabled(pd)) {
 		return;
 	}
 
@@ -1318,8 +1909,10 @@ static void notify_command_status(struct osdp_pd *pd, int status)
 	evt.notif.arg0 = app_cmd;
 	evt.notif.arg1 = status ? 0 : -1;
 
-	ctx->event_callback(ctx->event_callback_arg, pd->idx, &evt);
-	osdp_metrics_report(pd, OSDP_METRIC_EVENT);
+	/* one per command, packed ones included */
+	for (i = 0; i <= pd->pack.n; i++) {
+		cp_dispatch_event(pd, &evt);
+	}
 }
 
 static int state_update(struct osdp_pd *pd)
@@ -1348,10 +1941,12 @@ static int state_update(struct osdp_pd *pd)
 		__fallthrough;
 	case OSDP_CP_PHY_STATE_DONE:
 		status = state_check_reply(pd);
+		if (status && pd->state == OSDP_CP_STATE_ONLINE) {
+			cp_poll_sched_update(pd);
+		}
 		notify_command_status(pd, status);
-		cp_complete_cmd(pd, pd->active_cmd,
-				status ? OSDP_COMPLETION_OK : OSDP_COMPLETION_FAILED);
-		pd->active_cmd = NULL;
+		cp_complete_active_cmd(pd, status ? OSDP_COMPLETION_OK :
+						    OSDP_COMPLETION_FAILED);
 		if (!status) {
 			/* CMD_MFG NAK is a soft failure; keep PD online. */
 			if (pd->cmd_id == CMD_MFG &&
@@ -1394,18 +1989,77 @@ static int state_update(struct osdp_pd *pd)
 	return OSDP_CP_ERR_DEFER;
 }
 
+static uint32_t cp_pd_next_wakeup(struct osdp_pd *pd)
+{
+	int file_ms;
+	uint32_t ms, sc_ms;
+	tick_t now;
+
+	if (pd->request) {
+		return 0;
+	}
+
+	switch (pd->phy_state) {
+	case OSDP_CP_PHY_STATE_IDLE:
+		break;
+	case OSDP_CP_PHY_STATE_WAIT:
+		return osdp_millis_until(pd->phy_tstamp, pd->wait_ms);
+	case OSDP_CP_PHY_STATE_REPLY_WAIT:
+		now = osdp_millis_now();
+		return (now > pd->resp_expected) ? 0 :
+			(uint32_t)(pd->resp_expected - now) + 1;
+	default:
+		return 0;
+	}
+
+	switch (pd->state) {
+	case OSDP_CP_STATE_ONLINE:
+		break;
+	case OSDP_CP_STATE_OFFLINE:
+		return osdp_millis_until(pd->tstamp, pd->wait_ms);
+	case OSDP_CP_STATE_DISABLED:
+		return OSDP_WAKEUP_MAX_MS;
+	default:
+		/* handshake in progress; next command is due now */
+		return 0;
+	}
+
+	if (cp_cmd_pending(pd)) {
+		return 0;
+	}
+
+	ms = osdp_millis_until(pd->tstamp, pd->poll.interval_ms);
+	if (ms == 0 && cp_event_ring_throttled(pd)) {
+		/* no telling when the app drains the ring; check back later */
+		ms = pd->poll.interval_ms;
+	}
+	if (sc_is_capable(pd) && !sc_is_active(pd)) {
+		sc_ms = osdp_millis_until(pd->sc_tstamp, cp_sc_retry_ms(pd));
+		ms = (sc_ms < ms) ? sc_ms : ms;
+	}
+	file_ms = osdp_file_tx_next_wakeup(pd);
+	if (file_ms >= 0 && (uint32_t)file_ms < ms) {
+		ms = file_ms;
+	}
+	return ms;
+}
+
 static int cp_submit_command(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 {
 	const uint32_t all_flags = (
-		OSDP_CMD_FLAG_BROADCAST
+		OSDP_CMD_FLAG_BROADCAST |
+		OSDP_CMD_FLAG_TEMPLATE
 	);
 
-	if (pd->state == OSDP_CP_STATE_DISABLED) {
+	/* may run on any thread; only cmd_gate reflects the live PD state */
+	uint32_t gate = osdp_atomic_load_u32(&pd->cmd_gate);
+
+	if (gate & CP_CMD_GATE_DISABLED) {
 		LOG_ERR("PD is disabled");
 		return -1;
 	}
 
-	if (pd->state != OSDP_CP_STATE_ONLINE) {
+	if (!(gate & CP_CMD_GATE_ONLINE)) {
 		LOG_ERR("PD is not online");
 		return -1;
 	}
@@ -1415,13 +2069,19 @@ static int cp_submit_command(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 		return -1;
 	}
 
+	if ((cmd->flags & OSDP_CMD_FLAG_TEMPLATE) &&
+	    CONTAINER_OF(cmd, struct osdp_cmd_template, cmd)->len == 0) {
+		LOG_ERR("Command template was not compiled");
+		return -1;
+	}
+
 	if (cmd->flags & OSDP_CMD_FLAG_BROADCAST) {
 		if (NUM_PD(pd->osdp_ctx) != 1) {
 			LOG_ERR("Command broadcast is allowed only in single"
 				" PD environments");
 			return -1;
 		}
-		if (is_enforce_secure(pd)) {
+		if (gate & CP_CMD_GATE_ENFORCE_SECURE) {
 			LOG_ERR("Cannot send command in broadcast mode"
 				" due to ENFORCE_SECURE");
 			return -1;
@@ -1432,7 +2092,7 @@ static int cp_submit_command(struct osdp_pd *pd, const struct osdp_cmd *cmd)
 		return osdp_file_tx_command(pd, cmd->file_tx.id,
 					    cmd->file_tx.flags);
 	} else if (cmd->id == OSDP_CMD_KEYSET &&
-		   (cmd->keyset.type != 1 || !sc_is_active(pd))) {
+		   (cmd->keyset.type != 1 || !(gate & CP_CMD_GATE_SC_ACTIVE))) {
 		LOG_ERR("Invalid keyset request");
 		return -1;
 	}
@@ -1539,6 +2199,13 @@ static int cp_add_pd(struct osdp *ctx, int num_pd, const osdp_pd_info_t *info_li
 		pd->address = info->address;
 		pd->flags = 0;
 		pd->seq_number = -1;
+		pd->poll.interval_ms = OSDP_PD_POLL_TIMEOUT_MS;
+		/* any nonzero seed will do; vary it so PDs don't jitter alike */
+		pd->backoff.rng = 0x9e3779b9 ^ ((uint32_t)info->address << 16) ^
+				  (uint32_t)osdp_millis_now();
+		if (pd->backoff.rng == 0) {
+			pd->backoff.rng = 1;
+		}
 		cp_collect_init_flags(pd, info->flags);
 		SET_FLAG(pd, PD_FLAG_SC_DISABLED);
 		/* Default to CRC-16 until we know PD capabilities */
@@ -1566,6 +2233,11 @@ static int cp_add_pd(struct osdp *ctx, int num_pd, const osdp_pd_info_t *info_li
 		}
 	}
 	SET_CURRENT_PD(ctx, 0);
+	if (ctx->secure.ms >= 0) {
+		/* the new PDs aren't secure yet */
+		ctx->secure.ms = -1;
+		ctx->secure.since = osdp_millis_now();
+	}
 
 #ifndef OPT_OSDP_STATIC
 	if (old_num_pd) {
@@ -1605,6 +2277,8 @@ osdp_t *osdp_cp_setup(const struct osdp_channel *channel, int num_pd,
 	logger_get_default(&ctx->logger);
 #endif
 	memcpy(&ctx->channel, channel, sizeof(ctx->channel));
+	ctx->secure.ms = -1;
+	ctx->secure.since = osdp_millis_now();
 
 	if (num_pd && cp_add_pd(ctx, num_pd, info)) {
 		LOG_PRINT("Failed to add PDs");
@@ -1653,11 +2327,13 @@ void osdp_cp_teardown(osdp_t *ctx)
 			cp_complete_cmd(pd, cmd, OSDP_COMPLETION_ABORTED);
 			cp_cmd_free(pd, cmd);
 		}
-		cp_complete_cmd(pd, pd->active_cmd, OSDP_COMPLETION_ABORTED);
-		pd->active_cmd = NULL;
+		cp_batch_abandon(pd, OSDP_COMPLETION_ABORTED);
+		cp_complete_active_cmd(pd, OSDP_COMPLETION_ABORTED);
 		if (is_capture_enabled(pd)) {
 			osdp_packet_capture_finish(pd);
 		}
+		osdp_sc_release_keys(pd);
+		osdp_sc_release_cached_key(&pd->scbk_key);
 		osdp_fill_zeros(&pd->sc, sizeof(struct osdp_secure_channel));
 
 #ifndef OPT_OSDP_STATIC
@@ -1681,6 +2357,27 @@ void osdp_cp_teardown(osdp_t *ctx)
 #endif
 }
 
+/*
+ * Derive the session keys of a PD that is about to get (or just got) a
+ * CMD_CHLNG. They depend only on the SCBK and our cp_random, so we can do
+ * it while the bus is busy with someone's exchange rather than in the
+ * middle of the bus turn that handles the REPLY_CCRYPT. One PD per call
+ * keeps osdp_cp_refresh() short.
+ */
+static void cp_sc_prepare(struct osdp *ctx)
+{
+	int i;
+	struct osdp_pd *pd;
+
+	for (i = 0; i < ctx->_num_pd; i++) {
+		pd = osdp_to_pd(ctx, i);
+		if (pd->state == OSDP_CP_STATE_SC_CHLNG && !pd->sc.keys_ready) {
+			osdp_compute_session_keys(pd);
+			return;
+		}
+	}
+}
+
 void osdp_cp_refresh(osdp_t *ctx)
 {
 	input_check(ctx);
@@ -1694,10 +2391,12 @@ void osdp_cp_refresh(osdp_t *ctx)
 	if (cp_ctx->_current_pd == NULL) {
 		SET_CURRENT_PD(cp_ctx, 0);
 	}
+	cp_batch_start(cp_ctx);
 	while (refresh_count < cp_ctx->_num_pd) {
 		pd = cp_ctx->_current_pd;
 
 		state_update(pd);
+		cp_cmd_gate_publish(pd);
 
 		/*
 		 * On a shared multi-drop bus the CP must complete one PD's
@@ -1705,6 +2404,7 @@ void osdp_cp_refresh(osdp_t *ctx)
 		 * is occupied with a send/reply/retry cycle.
 		 */
 		if (cp_phy_bus_is_busy(pd)) {
+			cp_sc_prepare(cp_ctx);
 			break;
 		}
 
@@ -1741,6 +2441,90 @@ int osdp_cp_send_command(osdp_t *ctx, int pd_idx, const struct osdp_cmd *cmd)
 	return cp_submit_command(pd, cmd);
 }
 
+int osdp_cp_set_event_ring(osdp_t *ctx, struct osdp_cp_event *buf, int size,
+			   enum osdp_cp_event_overflow policy)
+{
+	input_check(ctx);
+	struct osdp *cp_ctx = TO_OSDP(ctx);
+
+	if (buf && (size <= 0 || (size & (size - 1)))) {
+		LOG_PRINT("Event ring size must be a power of two");
+		return -1;
+	}
+	if (policy != OSDP_CP_EVENT_DROP && policy != OSDP_CP_EVENT_THROTTLE) {
+		LOG_PRINT("Invalid event ring overflow policy %d", policy);
+		return -1;
+	}
+	cp_ctx->event_ring.buf = buf;
+	cp_ctx->event_ring.mask = buf ? (uint32_t)size - 1 : 0;
+	cp_ctx->event_ring.policy = policy;
+	cp_ctx->event_ring.head = 0;
+	cp_ctx->event_ring.tail = 0;
+	return 0;
+}
+
+int osdp_cp_poll_events(osdp_t *ctx, struct osdp_cp_event *events, int n)
+{
+	input_check(ctx);
+	struct osdp *cp_ctx = TO_OSDP(ctx);
+	uint32_t i, count, tail = cp_ctx->event_ring.tail;
+
+	if (cp_ctx->event_ring.buf == NULL || n < 0) {
+		return -1;
+	}
+	count = osdp_atomic_load_u32(&cp_ctx->event_ring.head) - tail;
+	if (count > (uint32_t)n) {
+		count = (uint32_t)n;
+	}
+	for (i = 0; i < count; i++) {
+		memcpy(&events[i], &cp_ctx->event_ring.buf[(tail + i) &
+						cp_ctx->event_ring.mask],
+		       sizeof(struct osdp_cp_event));
+	}
+	osdp_atomic_store_u32(&cp_ctx->event_ring.tail, tail + count);
+	return (int)count;
+}
+
+int osdp_cp_next_wakeup(const osdp_t *ctx)
+{
+	input_check(ctx);
+	int i;
+	uint32_t pd_ms, ms = OSDP_WAKEUP_MAX_MS;
+	struct osdp *cp_ctx = TO_OSDP(ctx);
+	struct osdp_pd *pd = cp_ctx->_current_pd;
+
+	if (osdp_atomic_load_u32(&cp_ctx->batch.ready)) {
+		return 0;
+	}
+
+	/* osdp_cp_refresh() won't look past a PD that holds the bus */
+	if (pd && cp_phy_bus_is_busy(pd)) {
+		pd_ms = cp_pd_next_wakeup(pd);
+		return (int)((pd_ms < ms) ? pd_ms : ms);
+	}
+
+	for (i = 0; i < cp_ctx->_num_pd && ms > 0; i++) {
+		pd_ms = cp_pd_next_wakeup(osdp_to_pd(ctx, i));
+		ms = (pd_ms < ms) ? pd_ms : ms;
+	}
+	return (int)ms;
+}
+
+/* Some PD holds the bus and its reply may arrive on the channel any time */
+bool osdp_cp_awaiting_reply(const osdp_t *ctx)
+{
+	struct osdp_pd *pd = TO_OSDP(ctx)->_current_pd;
+
+	return pd && pd->phy_state == OSDP_CP_PHY_STATE_REPLY_WAIT;
+}
+
+int osdp_cp_get_time_to_secure(const osdp_t *ctx)
+{
+	input_check(ctx);
+
+	return TO_OSDP(ctx)->secure.ms;
+}
+
 int osdp_cp_submit_command(osdp_t *ctx, int pd_idx, const struct osdp_cmd *cmd)
 {
 	input_check(ctx, pd_idx);
@@ -1749,6 +2533,108 @@ int osdp_cp_submit_command(osdp_t *ctx, int pd_idx, const struct osdp_cmd *cmd)
 	return cp_submit_command(pd, cmd);
 }
 
+int osdp_cp_submit_commands(osdp_t *ctx, const uint8_t *pd_mask,
+			    const struct osdp_cmd *cmds, int n)
+{
+	input_check(ctx);
+	struct osdp *cp_ctx = TO_OSDP(ctx);
+	struct osdp_pd *pd;
+	int i, selected = 0;
+
+	if (pd_mask == NULL || cmds == NULL || n <= 0) {
+		LOG_PRINT("Invalid command batch");
+		return -1;
+	}
+
+	/* the PD independent part of cp_submit_command(), once per command */
+	for (i = 0; i < n; i++) {
+		if (cmds[i].flags != 0 ||
+		    cmds[i].id == OSDP_CMD_FILE_TX ||
+		    cmds[i].id == OSDP_CMD_KEYSET) {
+			LOG_PRINT("Command %d at %d can't be batched",
+				  cmds[i].id, i);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < NUM_PD(cp_ctx); i++) {
+		if (!(pd_mask[i / 8] & (1 << (i % 8)))) {
+			continue;
+		}
+		pd = osdp_to_pd(cp_ctx, i);
+		if (!(osdp_atomic_load_u32(&pd->cmd_gate) & CP_CMD_GATE_ONLINE)) {
+			LOG_ERR("PD is not online");
+			return -1;
+		}
+		selected++;
+	}
+	if (selected == 0) {
+		LOG_PRINT("No PD selected for command batch");
+		return -1;
+	}
+	/* batch.remaining counts every (PD, entry) pair */
+	if (n > INT_MAX / selected) {
+		LOG_PRINT("Command batch too large");
+		return -1;
+	}
+
+	if (osdp_atomic_cas_ptr(&cp_ctx->batch.cmds, NULL,
+				(void *)cmds) != NULL) {
+		LOG_PRINT("Another command batch is in progress");
+		return -1;
+	}
+	cp_ctx->batch.n = n;
+	for (i = 0; i < NUM_PD(cp_ctx); i++) {
+		if (pd_mask[i / 8] & (1 << (i % 8))) {
+			osdp_to_pd(cp_ctx, i)->batch_sel = true;
+		}
+	}
+	osdp_atomic_store_u32(&cp_ctx->batch.ready, 1);
+	return 0;
+}
+
+int osdp_cp_compile_command(osdp_t *ctx, const struct osdp_cmd *cmd,
+			    struct osdp_cmd_template *tmpl)
+{
+	input_check(ctx);
+	int cmd_id, len;
+	uint32_t flags;
+
+	if (cmd == NULL || tmpl == NULL) {
+		LOG_PRINT("Invalid command to compile");
+		return -1;
+	}
+	flags = cmd->flags;
+	if (cmd == &tmpl->cmd) {
+		flags &= ~OSDP_CMD_FLAG_TEMPLATE; /* compiling again in place */
+	}
+	if (flags != 0) {
+		LOG_PRINT("Invalid command to compile");
+		return -1;
+	}
+	switch (cmd->id) {
+	case OSDP_CMD_OUTPUT: cmd_id = CMD_OUT;  break;
+	case OSDP_CMD_LED:    cmd_id = CMD_LED;  break;
+	case OSDP_CMD_BUZZER: cmd_id = CMD_BUZ;  break;
+	case OSDP_CMD_TEXT:   cmd_id = CMD_TEXT; break;
+	case OSDP_CMD_MFG:    cmd_id = CMD_MFG;  break;
+	default:
+		LOG_PRINT("Command %d can't be compiled", cmd->id);
+		return -1;
+	}
+	len = cp_encode_cmd_data(cmd_id, cmd, tmpl->data, sizeof(tmpl->data));
+	if (len <= 0) {
+		LOG_PRINT("Invalid command to compile");
+		return -1;
+	}
+	if (cmd != &tmpl->cmd) {
+		memcpy(&tmpl->cmd, cmd, sizeof(tmpl->cmd));
+	}
+	tmpl->cmd.flags = OSDP_CMD_FLAG_TEMPLATE;
+	tmpl->len = len;
+	return 0;
+}
+
 int osdp_cp_flush_commands(osdp_t *ctx, int pd_idx)
 {
 	input_check(ctx, pd_idx);
@@ -1761,7 +2647,7 @@ int osdp_cp_flush_commands(osdp_t *ctx, int pd_idx)
 		cp_cmd_free(pd, cmd);
 		count++;
 	}
-	return count;
+	return count + cp_batch_abandon(pd, OSDP_COMPLETION_FLUSHED);
 }
 
 int osdp_cp_get_pd_id(const osdp_t *ctx, int pd_idx, struct osdp_pd_id *id)
@@ -1844,6 +2730,7 @@ int osdp_cp_disable_pd(osdp_t *ctx, int pd_idx)
 	}
 
 	make_request(pd, CP_REQ_DISABLE);
+	cp_cmd_gate_publish(pd);
 	return 0;
 }
 
@@ -1863,6 +2750,7 @@ int osdp_cp_enable_pd(osdp_t *ctx, int pd_idx)
 	}
 
 	make_request(pd, CP_REQ_ENABLE);
+	cp_cmd_gate_publish(pd);
 	return 0;
 }
 
@@ -1874,6 +2762,65 @@ bool osdp_cp_is_pd_enabled(const osdp_t *ctx, int pd_idx)
 	return pd->state != OSDP_CP_STATE_DISABLED;
 }
 
+int osdp_cp_set_poll_policy(osdp_t *ctx, enum osdp_cp_poll_policy policy)
+{
+	input_check(ctx);
+	int i;
+	struct osdp *cp_ctx = TO_OSDP(ctx);
+
+	if (policy < OSDP_CP_POLL_FIXED || policy > OSDP_CP_POLL_LATENCY) {
+		LOG_PRINT("Invalid poll policy %d", policy);
+		return -1;
+	}
+	cp_ctx->poll_policy = policy;
+	for (i = 0; i < cp_ctx->_num_pd; i++) {
+		osdp_to_pd(ctx, i)->poll.interval_ms =
+			cp_poll_interval(osdp_to_pd(ctx, i));
+	}
+	return 0;
+}
+
+int osdp_cp_set_poll_priority(osdp_t *ctx, int pd_idx, int priority)
+{
+	input_check(ctx, pd_idx);
+	struct osdp_pd *pd = osdp_to_pd(ctx, pd_idx);
+
+	if (priority < 0 || priority > OSDP_PD_POLL_PRIORITY_MAX) {
+		LOG_ERR("Invalid poll priority %d", priority);
+		return -1;
+	}
+	pd->poll.priority = priority;
+	pd->poll.interval_ms = cp_poll_interval(pd);
+	return 0;
+}
+
+int osdp_cp_set_poll_latency(osdp_t *ctx, int pd_idx, int latency_ms)
+{
+	input_check(ctx, pd_idx);
+	struct osdp_pd *pd = osdp_to_pd(ctx, pd_idx);
+
+	if (latency_ms < 0 || latency_ms > UINT16_MAX) {
+		LOG_ERR("Invalid poll latency target %d", latency_ms);
+		return -1;
+	}
+	pd->poll.latency_ms = latency_ms;
+	pd->poll.interval_ms = cp_poll_interval(pd);
+	return 0;
+}
+
+int osdp_cp_set_command_packing(osdp_t *ctx, int pd_idx, int max_records)
+{
+	input_check(ctx, pd_idx);
+	struct osdp_pd *pd = osdp_to_pd(ctx, pd_idx);
+
+	if (max_records < 0 || max_records > OSDP_CP_CMD_PACK_MAX) {
+		LOG_ERR("Invalid command packing limit %d", max_records);
+		return -1;
+	}
+	pd->pack.max = max_records;
+	return 0;
+}
+
 #ifdef UNIT_TESTING
 
 /**
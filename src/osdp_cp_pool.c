@@ -0,0 +1,480 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Multi-bus CP runtime.
+ *
+ * Each bus is an ordinary CP context (one channel, many PDs). Buses are
+ * statically spread over a set of worker threads which call
+ * osdp_cp_refresh() on them and then sleep until the earliest
+ * osdp_cp_next_wakeup() of their buses, or until a command submission wakes
+ * them. Channels can't signal receive data, so a bus that is waiting for a
+ * reply is polled every OSDP_CP_POOL_TICK_MS instead.
+ *
+ * Command submission is lock-free in the CP core; a per-bus mutex is only
+ * taken to serialise refresh against file transfer requests and against the
+ * application's use of osdp_cp_pool_get_ctx(). Bus contexts don't share any
+ * state among themselves; the only process wide state they touch is the
+ * crypto backend's random number generator, which is seeded once and locked
+ * by the backend.
+ *
+ * Event and completion callbacks of every bus context point at trampolines
+ * that copy the payload into one bounded queue. The application drains it
+ * with osdp_cp_pool_dispatch(), so its callbacks run on a single thread and
+ * need no locking of their own.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "osdp_common.h"
+
+#if defined(OPT_OSDP_STATIC) || defined(OPT_OSDP_LOG_MINIMAL)
+#error "CP pool needs dynamic memory and the reentrant logger"
+#endif
+
+enum cp_pool_entry_type {
+	CP_POOL_ENTRY_EVENT,
+	CP_POOL_ENTRY_COMPLETION,
+};
+
+struct cp_pool_entry {
+	enum cp_pool_entry_type type;
+	int bus;
+	int pd;
+	enum osdp_completion_status status;
+	union {
+		struct osdp_event event;
+		struct osdp_cmd cmd;
+	};
+};
+
+struct cp_pool_bus {
+	struct osdp_cp_pool *pool;
+	int idx;
+	osdp_t *ctx;
+	pthread_mutex_t lock;
+};
+
+struct cp_pool_worker {
+	struct osdp_cp_pool *pool;
+	int idx;
+	pthread_t thread;
+	bool started;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool kick;
+};
+
+struct osdp_cp_pool {
+	int num_bus;
+	struct cp_pool_bus *bus;
+	int num_workers;
+	struct cp_pool_worker *worker;
+	atomic_bool stop;
+
+	/* merged event/completion queue */
+	pthread_mutex_t q_lock;
+	pthread_cond_t q_cond;
+	struct cp_pool_entry *q;
+	size_t q_head;
+	size_t q_count;
+	bool q_overflow;
+
+	cp_pool_event_callback_t event_cb;
+	void *event_cb_arg;
+	cp_pool_command_completion_callback_t completion_cb;
+	void *completion_cb_arg;
+};
+
+#define TO_POOL(p) ((struct osdp_cp_pool *)(p))
+
+static void cp_pool_enqueue(struct osdp_cp_pool *pool,
+			    const struct cp_pool_entry *entry)
+{
+	size_t tail;
+
+	pthread_mutex_lock(&pool->q_lock);
+	if (pool->q_count == OSDP_CP_POOL_QUEUE_SIZE) {
+		if (!pool->q_overflow) {
+			LOG_PRINT("CP pool queue full; dropping bus:%d pd:%d %s",
+				  entry->bus, entry->pd,
+				  entry->type == CP_POOL_ENTRY_EVENT ?
+				  "event" : "completion");
+		}
+		pool->q_overflow = true;
+		pthread_mutex_unlock(&pool->q_lock);
+		return;
+	}
+	pool->q_overflow = false;
+	tail = (pool->q_head + pool->q_count) % OSDP_CP_POOL_QUEUE_SIZE;
+	memcpy(&pool->q[tail], entry, sizeof(*entry));
+	pool->q_count++;
+	pthread_cond_signal(&pool->q_cond);
+	pthread_mutex_unlock(&pool->q_lock);
+}
+
+static int cp_pool_event_trampoline(void *arg, int pd, struct osdp_event *ev)
+{
+	struct cp_pool_bus *bus = arg;
+	struct cp_pool_entry entry;
+
+	entry.type = CP_POOL_ENTRY_EVENT;
+	entry.bus = bus->idx;
+	entry.pd = pd;
+	entry.status = OSDP_COMPLETION_OK;
+	memcpy(&entry.event, ev, sizeof(*ev));
+	cp_pool_enqueue(bus->pool, &entry);
+	return 0;
+}
+
+static void cp_pool_completion_trampoline(void *arg, int pd,
+					  const struct osdp_cmd *cmd,
+					  enum osdp_completion_status status)
+{
+	struct cp_pool_bus *bus = arg;
+	struct cp_pool_entry entry;
+
+	entry.type = CP_POOL_ENTRY_COMPLETION;
+	entry.bus = bus->idx;
+	entry.pd = pd;
+	entry.status = status;
+	memcpy(&entry.cmd, cmd, sizeof(*cmd));
+	cp_pool_enqueue(bus->pool, &entry);
+}
+
+static void cp_pool_deadline(struct timespec *ts, int timeout_ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+	ts->tv_sec += timeout_ms / 1000;
+	ts->tv_nsec += (timeout_ms % 1000) * 1000000L;
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec += 1;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+/* wake the worker that owns @bus so that it refreshes it right away */
+static void cp_pool_kick(struct osdp_cp_pool *pool, int bus)
+{
+	struct cp_pool_worker *w = &pool->worker[bus % pool->num_workers];
+
+	pthread_mutex_lock(&w->lock);
+	w->kick = true;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+}
+
+static void cp_pool_worker_sleep(struct cp_pool_worker *w, int timeout_ms)
+{
+	struct timespec ts;
+
+	pthread_mutex_lock(&w->lock);
+	if (!w->kick && timeout_ms > 0 && !atomic_load(&w->pool->stop)) {
+		cp_pool_deadline(&ts, timeout_ms);
+		pthread_cond_timedwait(&w->cond, &w->lock, &ts);
+	}
+	w->kick = false;
+	pthread_mutex_unlock(&w->lock);
+}
+
+static void *cp_pool_worker_fn(void *arg)
+{
+	int i, ms, bus_ms;
+	struct cp_pool_worker *w = arg;
+	struct osdp_cp_pool *pool = w->pool;
+	struct cp_pool_bus *bus;
+
+	while (!atomic_load(&pool->stop)) {
+		ms = OSDP_WAKEUP_MAX_MS;
+		for (i = w->idx; i < pool->num_bus; i += pool->num_workers) {
+			bus = &pool->bus[i];
+			pthread_mutex_lock(&bus->lock);
+			osdp_cp_refresh(bus->ctx);
+			bus_ms = osdp_cp_next_wakeup(bus->ctx);
+			if (osdp_cp_awaiting_reply(bus->ctx) &&
+			    bus_ms > OSDP_CP_POOL_TICK_MS) {
+				bus_ms = OSDP_CP_POOL_TICK_MS;
+			}
+			pthread_mutex_unlock(&bus->lock);
+			ms = (bus_ms < ms) ? bus_ms : ms;
+		}
+		cp_pool_worker_sleep(w, ms);
+	}
+
+	return NULL;
+}
+
+static void cp_pool_stop_workers(struct osdp_cp_pool *pool)
+{
+	int i;
+
+	atomic_store(&pool->stop, true);
+	for (i = 0; i < pool->num_workers; i++) {
+		cp_pool_kick(pool, i);
+	}
+	for (i = 0; i < pool->num_workers; i++) {
+		if (pool->worker[i].started) {
+			pthread_join(pool->worker[i].thread, NULL);
+			pool->worker[i].started = false;
+		}
+	}
+}
+
+static int cp_pool_num_workers(int num_workers, int num_bus)
+{
+	long ncpu;
+
+	if (num_workers <= 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		num_workers = ncpu > 0 ? (int)ncpu : 1;
+	}
+	return num_workers > num_bus ? num_bus : num_workers;
+}
+
+osdp_cp_pool_t *osdp_cp_pool_setup(int num_bus,
+				   const struct osdp_cp_bus_info *bus,
+				   int num_workers)
+{
+	int i, n;
+	struct osdp_cp_pool *pool;
+
+	if (num_bus <= 0 || !bus) {
+		LOG_PRINT("num_bus must be > 0 and bus cannot be NULL");
+		return NULL;
+	}
+
+	pool = calloc(1, sizeof(struct osdp_cp_pool));
+	if (pool == NULL) {
+		LOG_PRINT("Failed to allocate CP pool");
+		return NULL;
+	}
+	atomic_init(&pool->stop, false);
+	pthread_mutex_init(&pool->q_lock, NULL);
+	pthread_cond_init(&pool->q_cond, NULL);
+
+	pool->q = calloc(OSDP_CP_POOL_QUEUE_SIZE, sizeof(struct cp_pool_entry));
+	pool->bus = calloc(num_bus, sizeof(struct cp_pool_bus));
+	n = cp_pool_num_workers(num_workers, num_bus);
+	pool->worker = calloc(n, sizeof(struct cp_pool_worker));
+	if (!pool->q || !pool->bus || !pool->worker) {
+		LOG_PRINT("Failed to allocate CP pool");
+		goto error;
+	}
+	for (i = 0; i < n; i++) {
+		pthread_mutex_init(&pool->worker[i].lock, NULL);
+		pthread_cond_init(&pool->worker[i].cond, NULL);
+		pool->num_workers = i + 1;
+	}
+
+	for (i = 0; i < num_bus; i++) {
+		if (!bus[i].channel) {
+			LOG_PRINT("Bus-%d has no channel", i);
+			goto error;
+		}
+		pool->bus[i].pool = pool;
+		pool->bus[i].idx = i;
+		pthread_mutex_init(&pool->bus[i].lock, NULL);
+		pool->num_bus = i + 1;
+		pool->bus[i].ctx = osdp_cp_setup(bus[i].channel, bus[i].num_pd,
+						 bus[i].info);
+		if (pool->bus[i].ctx == NULL) {
+			LOG_PRINT("Failed to setup bus-%d", i);
+			goto error;
+		}
+		osdp_cp_set_event_callback(pool->bus[i].ctx,
+					   cp_pool_event_trampoline,
+					   &pool->bus[i]);
+		osdp_cp_set_command_completion_callback(pool->bus[i].ctx,
+					   cp_pool_completion_trampoline,
+					   &pool->bus[i]);
+	}
+
+	for (i = 0; i < pool->num_workers; i++) {
+		pool->worker[i].pool = pool;
+		pool->worker[i].idx = i;
+		if (pthread_create(&pool->worker[i].thread, NULL,
+				   cp_pool_worker_fn, &pool->worker[i])) {
+			LOG_PRINT("Failed to start CP pool worker-%d", i);
+			goto error;
+		}
+		pool->worker[i].started = true;
+	}
+
+	LOG_PRINT("CP pool setup complete; Buses:%d Workers:%d",
+		  pool->num_bus, pool->num_workers);
+	return (osdp_cp_pool_t *)pool;
+error:
+	osdp_cp_pool_teardown((osdp_cp_pool_t *)pool);
+	return NULL;
+}
+
+void osdp_cp_pool_teardown(osdp_cp_pool_t *p)
+{
+	int i;
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	if (pool == NULL) {
+		return;
+	}
+
+	if (pool->worker) {
+		cp_pool_stop_workers(pool);
+	}
+	for (i = 0; pool->bus && i < pool->num_bus; i++) {
+		if (pool->bus[i].ctx) {
+			osdp_cp_teardown(pool->bus[i].ctx);
+		}
+		pthread_mutex_destroy(&pool->bus[i].lock);
+	}
+	for (i = 0; i < pool->num_workers; i++) {
+		pthread_cond_destroy(&pool->worker[i].cond);
+		pthread_mutex_destroy(&pool->worker[i].lock);
+	}
+	if (pool->q) {
+		osdp_cp_pool_dispatch(p, 0);
+	}
+
+	pthread_cond_destroy(&pool->q_cond);
+	pthread_mutex_destroy(&pool->q_lock);
+	safe_free(pool->worker);
+	safe_free(pool->bus);
+	safe_free(pool->q);
+	safe_free(pool);
+}
+
+void osdp_cp_pool_set_event_callback(osdp_cp_pool_t *p,
+				     cp_pool_event_callback_t cb, void *arg)
+{
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	pthread_mutex_lock(&pool->q_lock);
+	pool->event_cb = cb;
+	pool->event_cb_arg = arg;
+	pthread_mutex_unlock(&pool->q_lock);
+}
+
+void osdp_cp_pool_set_command_completion_callback(osdp_cp_pool_t *p,
+				cp_pool_command_completion_callback_t cb,
+				void *arg)
+{
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	pthread_mutex_lock(&pool->q_lock);
+	pool->completion_cb = cb;
+	pool->completion_cb_arg = arg;
+	pthread_mutex_unlock(&pool->q_lock);
+}
+
+int osdp_cp_pool_submit_command(osdp_cp_pool_t *p, int bus, int pd,
+				const struct osdp_cmd *cmd)
+{
+	int ret;
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	if (bus < 0 || bus >= pool->num_bus) {
+		LOG_PRINT("Invalid bus number %d", bus);
+		return -1;
+	}
+
+	/* only file transfers touch state owned by the refresh thread */
+	if (cmd->id != OSDP_CMD_FILE_TX) {
+		ret = osdp_cp_submit_command(pool->bus[bus].ctx, pd, cmd);
+	} else {
+		pthread_mutex_lock(&pool->bus[bus].lock);
+		ret = osdp_cp_submit_command(pool->bus[bus].ctx, pd, cmd);
+		pthread_mutex_unlock(&pool->bus[bus].lock);
+	}
+	if (ret == 0) {
+		cp_pool_kick(pool, bus);
+	}
+	return ret;
+}
+
+static void cp_pool_wait(struct osdp_cp_pool *pool, int timeout_ms)
+{
+	struct timespec ts;
+
+	if (timeout_ms < 0) {
+		while (pool->q_count == 0) {
+			pthread_cond_wait(&pool->q_cond, &pool->q_lock);
+		}
+		return;
+	}
+
+	cp_pool_deadline(&ts, timeout_ms);
+	while (pool->q_count == 0) {
+		if (pthread_cond_timedwait(&pool->q_cond, &pool->q_lock, &ts)) {
+			break;
+		}
+	}
+}
+
+int osdp_cp_pool_dispatch(osdp_cp_pool_t *p, int timeout_ms)
+{
+	int count = 0;
+	struct cp_pool_entry entry;
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	pthread_mutex_lock(&pool->q_lock);
+	if (pool->q_count == 0 && timeout_ms != 0) {
+		cp_pool_wait(pool, timeout_ms);
+	}
+
+	/* bounded, so that a chatty bus cannot keep the caller here forever */
+	while (pool->q_count && count < OSDP_CP_POOL_QUEUE_SIZE) {
+		memcpy(&entry, &pool->q[pool->q_head], sizeof(entry));
+		pool->q_head = (pool->q_head + 1) % OSDP_CP_POOL_QUEUE_SIZE;
+		pool->q_count--;
+		pthread_mutex_unlock(&pool->q_lock);
+
+		if (entry.type == CP_POOL_ENTRY_EVENT && pool->event_cb) {
+			pool->event_cb(pool->event_cb_arg, entry.bus, entry.pd,
+				       &entry.event);
+		} else if (entry.type == CP_POOL_ENTRY_COMPLETION &&
+			   pool->completion_cb) {
+			pool->completion_cb(pool->completion_cb_arg, entry.bus,
+					    entry.pd, &entry.cmd, entry.status);
+		}
+		count++;
+
+		pthread_mutex_lock(&pool->q_lock);
+	}
+	pthread_mutex_unlock(&pool->q_lock);
+
+	return count;
+}
+
+osdp_t *osdp_cp_pool_get_ctx(osdp_cp_pool_t *p, int bus)
+{
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	if (bus < 0 || bus >= pool->num_bus) {
+		return NULL;
+	}
+	pthread_mutex_lock(&pool->bus[bus].lock);
+	return pool->bus[bus].ctx;
+}
+
+void osdp_cp_pool_put_ctx(osdp_cp_pool_t *p, int bus)
+{
+	struct osdp_cp_pool *pool = TO_POOL(p);
+
+	assert(pool);
+	if (bus < 0 || bus >= pool->num_bus) {
+		return;
+	}
+	pthread_mutex_unlock(&pool->bus[bus].lock);
+	/* the application may have changed what the next refresh should do */
+	cp_pool_kick(pool, bus);
+}
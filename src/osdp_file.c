@@ -440,6 +440,29 @@ int osdp_file_tx_get_command(struct osdp_pd *pd)
 	return CMD_FILETRANSFER;
 }
 
+/**
+ * @brief Time until osdp_file_tx_get_command() wants the bus again.
+ *
+ * @param pd PD context
+ * @retval -1 - no transfer in progress
+ * @retval >=0 - milliseconds to wait (0: now)
+ */
+int osdp_file_tx_next_wakeup(struct osdp_pd *pd)
+{
+	struct osdp_file *f = TO_FILE(pd);
+
+	if (!osdp_file_tx_is_active(pd)) {
+		return -1;
+	}
+
+	if (f->errors > OSDP_FILE_ERROR_RETRY_MAX || f->cancel_req ||
+	    !f->wait_time_ms) {
+		return 0;
+	}
+
+	return (int)osdp_millis_until(f->tstamp, f->wait_time_ms);
+}
+
 /**
  * Entry point based on command OSDP_CMD_FILE to kick off a new file transfer.
  */
@@ -71,6 +71,7 @@ int osdp_file_cmd_stat_build(struct osdp_pd *pd, uint8_t *buf, int max_len);
 int osdp_file_tx_command(struct osdp_pd *pd, int file_id, uint32_t flags);
 int osdp_file_tx_get_command(struct osdp_pd *pd);
 void osdp_file_tx_abort(struct osdp_pd *pd);
+int osdp_file_tx_next_wakeup(struct osdp_pd *pd);
 
 /* Implemented in osdp_cp.c; called by osdp_file.c only on CP-mode PDs. */
 void osdp_file_tx_notify_done(struct osdp_pd *pd, int file_id,
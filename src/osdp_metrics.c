@@ -9,45 +9,154 @@
 #include "osdp_common.h"
 #include "osdp_metrics.h"
 
-static inline void sat_inc(uint32_t *c)
+static inline void sat_add(uint32_t *c, uint64_t v)
 {
-	if (*c != UINT32_MAX) {
-		(*c)++;
+	if (v >= (uint64_t)(UINT32_MAX - *c)) {
+		*c = UINT32_MAX;
+	} else {
+		*c += (uint32_t)v;
 	}
 }
 
-void osdp_metrics_report(struct osdp_pd *pd, enum osdp_metric_event ev)
+void osdp_metrics_add(struct osdp_pd *pd, enum osdp_metric_event ev,
+		      uint64_t value)
 {
 	struct osdp_metrics *m = &pd->metrics;
 
 	switch (ev) {
 	case OSDP_METRIC_PACKET_SENT:
-		sat_inc(&m->packets_sent);
+		sat_add(&m->packets_sent, value);
 		break;
 	case OSDP_METRIC_PACKET_RECEIVED:
-		sat_inc(&m->packets_received);
+		sat_add(&m->packets_received, value);
 		break;
 	case OSDP_METRIC_PACKET_CHECK_ERROR:
-		sat_inc(&m->packet_check_errors);
+		sat_add(&m->packet_check_errors, value);
 		break;
 	case OSDP_METRIC_NAK:
-		sat_inc(&m->nak_count);
+		sat_add(&m->nak_count, value);
 		break;
 	case OSDP_METRIC_SC_HANDSHAKE:
-		sat_inc(&m->sc_handshake_count);
+		sat_add(&m->sc_handshake_count, value);
 		break;
 	case OSDP_METRIC_SC_FAILURE:
-		sat_inc(&m->sc_failure_count);
+		sat_add(&m->sc_failure_count, value);
 		break;
 	case OSDP_METRIC_COMMAND:
-		sat_inc(&m->command_count);
+		sat_add(&m->command_count, value);
 		break;
 	case OSDP_METRIC_EVENT:
-		sat_inc(&m->event_count);
+		sat_add(&m->event_count, value);
+		break;
+	case OSDP_METRIC_SC_SEAL:
+		sat_add(&m->sc_sealed_count, value);
+		break;
+	case OSDP_METRIC_SC_SEAL_CYCLES:
+		sat_add(&m->sc_seal_cycles, value);
+		break;
+	case OSDP_METRIC_SC_OPEN:
+		sat_add(&m->sc_opened_count, value);
+		break;
+	case OSDP_METRIC_SC_OPEN_CYCLES:
+		sat_add(&m->sc_open_cycles, value);
+		break;
+	case OSDP_METRIC_POLL:
+		sat_add(&m->poll_count, value);
+		break;
+	case OSDP_METRIC_POLL_IDLE:
+		sat_add(&m->poll_idle_count, value);
+		break;
+	case OSDP_METRIC_TX_BYTES:
+		sat_add(&m->tx_bytes, value);
+		break;
+	case OSDP_METRIC_RX_BYTES:
+		sat_add(&m->rx_bytes, value);
+		break;
+	case OSDP_METRIC_WIRE_TIME_US:
+		sat_add(&m->wire_time_us, value);
+		break;
+	case OSDP_METRIC_BUS_BUSY_MS:
+		sat_add(&m->bus_busy_ms, value);
+		break;
+	case OSDP_METRIC_EVENT_DROP:
+		sat_add(&m->event_drop_count, value);
+		break;
+	case OSDP_METRIC_CMD_PACKED:
+		sat_add(&m->cmd_packed_count, value);
+		break;
+	case OSDP_METRIC_RX_DISCARD:
+		sat_add(&m->rx_discarded_bytes, value);
+		break;
+	case OSDP_METRIC_PACKET_OBSERVED:
+		sat_add(&m->packets_observed, value);
+		break;
+	case OSDP_METRIC_PROBE:
+		sat_add(&m->probe_count, value);
+		break;
+	case OSDP_METRIC_RECOVER:
+		sat_add(&m->recover_count, value);
+		break;
+	case OSDP_METRIC_RECOVER_MS:
+		sat_add(&m->recover_time_ms, value);
+		break;
+	case OSDP_METRIC_SC_KEY_CACHE_HIT:
+		sat_add(&m->sc_key_cache_hits, value);
+		break;
+	case OSDP_METRIC_SC_KEY_CACHE_MISS:
+		sat_add(&m->sc_key_cache_misses, value);
+		break;
+	}
+}
+
+void osdp_metrics_wire(struct osdp_pd *pd, enum osdp_metric_event ev,
+		       int len)
+{
+	if (len <= 0) {
+		return;
+	}
+	osdp_metrics_add(pd, ev, len);
+	if (pd->baud_rate) {
+		/* 8N1: a start bit, 8 data bits and a stop bit per byte */
+		osdp_metrics_add(pd, OSDP_METRIC_WIRE_TIME_US,
+				 (uint64_t)len * 10 * 1000000 / pd->baud_rate);
+	}
+}
+
+void osdp_metrics_sample(struct osdp_pd *pd, enum osdp_metric_hist hist,
+			 uint32_t ms)
+{
+	int b = 0;
+	uint32_t *h;
+
+	switch (hist) {
+	case OSDP_METRIC_HIST_TURNAROUND:
+		h = pd->metrics.turnaround_hist;
+		break;
+	case OSDP_METRIC_HIST_RTT:
+		h = pd->metrics.rtt_hist;
 		break;
+	default:
+		return;
+	}
+	while (ms && b < OSDP_METRICS_HIST_BUCKETS - 1) {
+		ms >>= 1;
+		b++;
+	}
+	sat_add(&h[b], 1);
+}
+
+void osdp_metrics_ring_level(struct osdp_pd *pd, uint32_t level)
+{
+	if (level > pd->metrics.event_ring_hwm) {
+		pd->metrics.event_ring_hwm = level;
 	}
 }
 
+void osdp_metrics_report(struct osdp_pd *pd, enum osdp_metric_event ev)
+{
+	osdp_metrics_add(pd, ev, 1);
+}
+
 /* --- Exported Methods --- */
 
 int osdp_get_metrics(osdp_t *ctx, int pd_idx, struct osdp_metrics *out)
@@ -66,5 +175,9 @@ int osdp_get_metrics(osdp_t *ctx, int pd_idx, struct osdp_metrics *out)
 
 	*out = pd->metrics;
 	memset(&pd->metrics, 0, sizeof(pd->metrics));
+	if (is_cp_mode(pd)) {
+		out->poll_interval_ms = pd->poll.interval_ms;
+		out->poll_rtt_ms = pd->poll.rtt_ms;
+	}
 	return 0;
 }
@@ -26,6 +26,33 @@ enum osdp_metric_event {
 	OSDP_METRIC_SC_FAILURE,
 	OSDP_METRIC_COMMAND,
 	OSDP_METRIC_EVENT,
+	OSDP_METRIC_SC_SEAL,
+	OSDP_METRIC_SC_SEAL_CYCLES,
+	OSDP_METRIC_SC_OPEN,
+	OSDP_METRIC_SC_OPEN_CYCLES,
+	OSDP_METRIC_POLL,
+	OSDP_METRIC_POLL_IDLE,
+	OSDP_METRIC_TX_BYTES,
+	OSDP_METRIC_RX_BYTES,
+	OSDP_METRIC_WIRE_TIME_US,
+	OSDP_METRIC_BUS_BUSY_MS,
+	OSDP_METRIC_EVENT_DROP,
+	OSDP_METRIC_CMD_PACKED,
+	OSDP_METRIC_RX_DISCARD,
+	OSDP_METRIC_PACKET_OBSERVED,
+	OSDP_METRIC_PROBE,
+	OSDP_METRIC_RECOVER,
+	OSDP_METRIC_RECOVER_MS,
+	OSDP_METRIC_SC_KEY_CACHE_HIT,
+	OSDP_METRIC_SC_KEY_CACHE_MISS,
+};
+
+/**
+ * Latency histograms in `struct osdp_metrics`; see osdp_metrics_sample().
+ */
+enum osdp_metric_hist {
+	OSDP_METRIC_HIST_TURNAROUND,
+	OSDP_METRIC_HIST_RTT,
 };
 
 /**
@@ -35,4 +62,30 @@ enum osdp_metric_event {
  */
 void osdp_metrics_report(struct osdp_pd *pd, enum osdp_metric_event ev);
 
+/**
+ * Same as osdp_metrics_report() but adds an arbitrary amount to the
+ * counter (saturating). Used for accumulators such as cycle counts.
+ */
+void osdp_metrics_add(struct osdp_pd *pd, enum osdp_metric_event ev,
+		      uint64_t value);
+
+/**
+ * Account @a len bytes that crossed the channel in either direction:
+ * bumps the byte counter named by @a ev and the estimated wire time.
+ */
+void osdp_metrics_wire(struct osdp_pd *pd, enum osdp_metric_event ev,
+		       int len);
+
+/**
+ * Record one latency sample (in ms) in a log2-bucketed histogram.
+ */
+void osdp_metrics_sample(struct osdp_pd *pd, enum osdp_metric_hist hist,
+			 uint32_t ms);
+
+/**
+ * Note the CP event ring occupancy after queuing an event from this PD;
+ * keeps the high-water mark.
+ */
+void osdp_metrics_ring_level(struct osdp_pd *pd, uint32_t level);
+
 #endif /* _OSDP_METRICS_H_ */
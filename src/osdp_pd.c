@@ -1209,7 +1209,8 @@ static void osdp_pd_update(struct osdp_pd *pd)
 	if (!pd->reply_prebuilt) {
 		ret = pd_receive_and_process_command(pd);
 
-		if (IS_ENABLED(OPT_OSDP_RX_ZERO_COPY)) {
+		if (IS_ENABLED(OPT_OSDP_RX_ZERO_COPY) ||
+		    IS_ENABLED(OPT_OSDP_RX_ARENA)) {
 			osdp_phy_release_packet(pd);
 		}
 
@@ -1484,6 +1485,8 @@ void osdp_pd_teardown(osdp_t *ctx)
 		osdp_packet_capture_finish(pd);
 	}
 
+	osdp_sc_release_keys(pd);
+	osdp_sc_release_cached_key(&pd->scbk_key);
 	osdp_fill_zeros(&pd->sc, sizeof(struct osdp_secure_channel));
 
 	if (pd_ctx->channel.close) {
@@ -1515,6 +1518,39 @@ void osdp_pd_refresh(osdp_t *ctx)
 	osdp_pd_update(pd);
 }
 
+int osdp_pd_next_wakeup(const osdp_t *ctx)
+{
+	input_check(ctx);
+	uint32_t t, ms = OSDP_WAKEUP_MAX_MS;
+	struct osdp_pd *pd = GET_CURRENT_PD(ctx);
+
+	if (pd->reply_prebuilt) {
+		return 0;
+	}
+
+	if (sc_is_active(pd)) {
+		t = osdp_millis_until(pd->sc_tstamp, OSDP_PD_SC_TIMEOUT_MS);
+		ms = (t < ms) ? t : ms;
+	}
+
+	if (is_pd_online(pd)) {
+		t = osdp_millis_until(pd->tstamp, OSDP_PD_ONLINE_TOUT_MS);
+		ms = (t < ms) ? t : ms;
+	}
+
+	/* a half-received command is dropped after OSDP_RESP_TOUT_MS */
+#ifdef OPT_OSDP_RX_ZERO_COPY
+	if (pd->packet_buf_len) {
+#else
+	if (pd->packet_buf_len || (pd->rx_rb && osdp_rb_len(pd->rx_rb))) {
+#endif
+		t = osdp_millis_until(pd->tstamp, OSDP_RESP_TOUT_MS);
+		ms = (t < ms) ? t : ms;
+	}
+
+	return (int)ms;
+}
+
 void osdp_pd_set_capabilities(osdp_t *ctx, const struct osdp_pd_cap *cap)
 {
 	input_check(ctx);
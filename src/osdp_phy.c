@@ -40,6 +40,7 @@ static inline bool packet_has_mark(struct osdp_pd *pd)
  */
 static int osdp_channel_send(struct osdp_pd *pd, uint8_t *buf, int len)
 {
+	int ret;
 	struct osdp_channel *channel = &pd_to_osdp(pd)->channel;
 
 	/* flush rx to remove any invalid data. */
@@ -47,7 +48,11 @@ static int osdp_channel_send(struct osdp_pd *pd, uint8_t *buf, int len)
 		channel->flush(channel->data);
 	}
 
-	return channel->send(channel->data, buf, len);
+	ret = channel->send(channel->data, buf, len);
+	if (ret == len) {
+		osdp_metrics_wire(pd, OSDP_METRIC_TX_BYTES, len);
+	}
+	return ret;
 }
 
 #ifdef OPT_OSDP_RX_ZERO_COPY
@@ -91,12 +96,69 @@ void osdp_phy_release_packet(struct osdp_pd *pd)
 	pd->packet_len = 0;
 	CLEAR_FLAG(pd, PD_FLAG_PKT_HAS_MARK);
 	pd->packet_buf = NULL;
+#elif defined(OPT_OSDP_RX_ARENA)
+	if (pd->packet_claim) {
+		/* packet_buf may already have been repointed at a reply */
+		if (pd->packet_buf == pd->rx_rb->buffer + pd->rx_rb->tail) {
+			pd->packet_buf = pd_to_osdp(pd)->rx_buf;
+			pd->packet_buf_len = 0;
+		}
+		osdp_rb_skip(pd->rx_rb, (int)pd->packet_claim);
+		pd->packet_claim = 0;
+		pd->packet_len = 0;
+		CLEAR_FLAG(pd, PD_FLAG_PKT_HAS_MARK);
+	}
 #else /* OPT_OSDP_RX_ZERO_COPY */
 	ARG_UNUSED(pd);
 #endif /* OPT_OSDP_RX_ZERO_COPY */
 }
 
-#ifndef OPT_OSDP_RX_ZERO_COPY
+#ifdef OPT_OSDP_RX_ARENA
+/*
+ * In arena mode rx_rb is used as a linear buffer: the channel writes into it
+ * directly and packets are validated and decoded where they landed. Unread
+ * bytes are moved to the front before each read so that a packet is always
+ * contiguous; between packets this is usually a no-op or a few bytes.
+ */
+static int osdp_channel_receive(struct osdp_pd *pd)
+{
+	int recv, space, total_recv = 0;
+	struct osdp_rb *rb = pd->rx_rb;
+	struct osdp_channel *channel = &pd_to_osdp(pd)->channel;
+
+	if (pd->packet_claim) {
+		LOG_WRN("Previous packet not released! Forcing release");
+		osdp_phy_release_packet(pd);
+	}
+
+	osdp_rb_compact(rb);
+
+#ifdef UNIT_TESTING
+	if (!channel->recv) {
+		return 0;
+	}
+#endif
+
+	/* When the arena is full, leave the rest in the channel for now */
+	space = (int)(sizeof(rb->buffer) - 1 - rb->head);
+	while (space > 0) {
+		recv = channel->recv(channel->data, rb->buffer + rb->head, space);
+		if (recv <= 0) {
+			break;
+		}
+		rb->head += recv;
+		total_recv += recv;
+		if (recv < space) {
+			break;
+		}
+		space -= recv;
+	}
+
+	return total_recv;
+}
+#endif /* OPT_OSDP_RX_ARENA */
+
+#if !defined(OPT_OSDP_RX_ZERO_COPY) && !defined(OPT_OSDP_RX_ARENA)
 static int osdp_channel_receive(struct osdp_pd *pd)
 {
 	uint8_t buf[64];
@@ -259,7 +321,7 @@ int osdp_phy_finalize_packet(struct osdp_pd *pd, uint8_t *buf,
 	uint16_t crc16;
 	struct osdp_packet_header *pkt;
 	uint8_t *data;
-	int data_len, checksum_len;
+	int data_len = -1, checksum_len;
 
 	/* Do a sanity check only; we expect header to be pre-filled */
 	if ((unsigned long)len <= sizeof(struct osdp_packet_header)) {
@@ -319,7 +381,6 @@ int osdp_phy_finalize_packet(struct osdp_pd *pd, uint8_t *buf,
 			 * Note: if cmd/reply has no data, we must set type to
 			 * SCS_15/SCS_16 and send them.
 			 */
-			data = pkt->data + pkt->data[0] + 1;
 			data_len = len - (sizeof(struct osdp_packet_header) +
 					  pkt->data[0] + 1);
 			len -= data_len;
@@ -332,7 +393,7 @@ int osdp_phy_finalize_packet(struct osdp_pd *pd, uint8_t *buf,
 				/* data_len + 1 for OSDP_SC_EOM_MARKER */
 				goto out_of_space_error;
 			}
-			len += osdp_encrypt_data(pd, is_cp_mode(pd), data, data_len);
+			len += AES_PAD_LEN(data_len + 1);
 		}
 		/* len: with 4bytes MAC; with CRC (2 bytes) or checksum (1 byte); without 1 byte mark */
 		if (len + 4 > max_len) {
@@ -344,8 +405,19 @@ int osdp_phy_finalize_packet(struct osdp_pd *pd, uint8_t *buf,
 		pkt->len_lsb = BYTE_0(len + checksum_len + 4);
 		pkt->len_msb = BYTE_1(len + checksum_len + 4);
 
-		/* compute and extend the buf with 4 MAC bytes */
-		osdp_compute_mac(pd, is_cp_mode(pd), buf, len);
+		/**
+		 * Encrypt the data block (if any) and compute the MAC in a
+		 * single walk over the packet. The header already carries
+		 * the final length since it is part of the MAC input.
+		 */
+		if (data_len >= 0) {
+			osdp_sc_seal(pd, buf, len - AES_PAD_LEN(data_len + 1),
+				     data_len);
+		} else {
+			osdp_compute_mac(pd, is_cp_mode(pd), buf, len);
+		}
+
+		/* extend the buf with 4 MAC bytes */
 		data = is_cp_mode(pd) ? pd->sc.c_mac : pd->sc.r_mac;
 		memcpy(buf + len, data, 4);
 		len += 4;
@@ -436,6 +508,7 @@ static int phy_validate_header(struct osdp_pd *pd, uint8_t *buf,
 	 * skip those wrong-direction packets to play nice with others.
 	 */
 	if (is_pd_mode(pd) && (pkt->pd_address & 0x80)) {
+		osdp_metrics_report(pd, OSDP_METRIC_PACKET_OBSERVED);
 		return OSDP_ERR_PKT_SKIP;
 	}
 
@@ -446,25 +519,153 @@ static int phy_validate_header(struct osdp_pd *pd, uint8_t *buf,
 	 */
 	if (is_cp_mode(pd) && !(pkt->pd_address & 0x80)) {
 		LOG_WRN("Saw a command from another CP on the bus; skipping it");
+		osdp_metrics_report(pd, OSDP_METRIC_PACKET_OBSERVED);
+		return OSDP_ERR_PKT_SKIP;
+	}
+
+#ifdef OPT_OSDP_EARLY_ADDRESS_FILTER
+	/**
+	 * A PD is not interested in commands for other PDs; skip them by the
+	 * header alone instead of checking their CRC first. A corrupt address
+	 * can't make us miss a command: it would have failed the CRC anyway.
+	 * A corrupt length can though: it is trusted without a CRC to back
+	 * it, so the skip may run into the frames that follow. Hence opt-in,
+	 * for busy buses with a trustworthy line.
+	 */
+	if (is_pd_mode(pd) && (pkt->pd_address & 0x7F) != pd->address &&
+	    (pkt->pd_address & 0x7F) != 0x7F) {
+		osdp_metrics_report(pd, OSDP_METRIC_PACKET_OBSERVED);
 		return OSDP_ERR_PKT_SKIP;
 	}
+#endif
 
 	return (int)(pkt_len + mark);
 }
 
 #ifndef OPT_OSDP_RX_ZERO_COPY
-static bool phy_rescan_packet_buf(struct osdp_pd *pd)
+static inline void phy_rx_discarded(struct osdp_pd *pd, unsigned int count)
+{
+	if (count) {
+		osdp_metrics_add(pd, OSDP_METRIC_RX_DISCARD, count);
+	}
+}
+
+/*
+ * Drop what is left of a packet that phy_validate_header() asked to skip.
+ * Its length is known from the header, so the rest of it is not scanned for
+ * a SoM (its payload may well contain one, e.g. another PD's card data).
+ * Returns true while part of it has yet to arrive.
+ */
+static bool phy_rx_skip_pending(struct osdp_pd *pd)
+{
+	if (pd->rx_skip) {
+		pd->rx_skip -= osdp_rb_skip(pd->rx_rb, pd->rx_skip);
+	}
+	return pd->rx_skip != 0;
+}
+
+/*
+ * Skip the whole packet whose header is at @buf; @consumed of its bytes have
+ * already been taken off the RX ring.
+ */
+static void phy_rx_skip_packet(struct osdp_pd *pd, const uint8_t *buf,
+			       unsigned long consumed)
+{
+	const struct osdp_packet_header *pkt;
+	int mark = packet_has_mark(pd);
+	unsigned long len;
+
+	pkt = (const struct osdp_packet_header *)(buf + mark);
+	len = mark + ((pkt->len_msb << 8) | pkt->len_lsb);
+	phy_rx_discarded(pd, len);
+	pd->rx_skip = (uint16_t)(len - consumed);
+	phy_rx_skip_pending(pd);
+}
+#endif /* OPT_OSDP_RX_ZERO_COPY */
+
+#ifdef OPT_OSDP_RX_ARENA
+/*
+ * Drop @count bytes of line noise from the head of the RX arena, counting
+ * the ones that were not MARK bytes.
+ */
+static void phy_arena_discard(struct osdp_pd *pd, int count)
 {
-	unsigned long j = packet_has_mark(pd);
-	unsigned long i = j + 1; /* +1 to skip current SoM */
+	const uint8_t *buf = pd->rx_rb->buffer + pd->rx_rb->tail;
+	unsigned int skipped = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		skipped += (buf[i] != OSDP_PKT_MARK);
+	}
+	osdp_rb_skip(pd->rx_rb, count);
+	phy_rx_discarded(pd, skipped);
+}
+
+static int phy_check_header(struct osdp_pd *pd)
+{
+	int ret, off;
+	uint8_t *buf;
+	struct osdp_rb *rb = pd->rx_rb;
+
+	if (phy_rx_skip_pending(pd)) {
+		pd->packet_buf_len = 0;
+		return OSDP_ERR_PKT_NO_DATA;
+	}
+
+	buf = rb->buffer + rb->tail;
+	off = osdp_rb_scan(rb, OSDP_PKT_SOM);
+	if (off < 0) {
+		/* keep a trailing MARK; its SoM may be in the next read */
+		off = (int)osdp_rb_len(rb);
+		if (off && buf[off - 1] == OSDP_PKT_MARK) {
+			off -= 1;
+		}
+		phy_arena_discard(pd, off);
+		pd->packet_buf_len = 0;
+		return OSDP_ERR_PKT_NO_DATA;
+	}
+	if (off && buf[off - 1] == OSDP_PKT_MARK) {
+		off -= 1;
+	}
+	phy_arena_discard(pd, off);
 
-	while (i < pd->packet_buf_len && pd->packet_buf[i] != OSDP_PKT_SOM) {
-		i++;
+	pd->packet_buf = rb->buffer + rb->tail;
+	pd->packet_buf_len = osdp_rb_len(rb);
+	ret = phy_validate_header(pd, pd->packet_buf, pd->packet_buf_len,
+				  OSDP_PACKET_BUF_SIZE);
+	if (ret == OSDP_ERR_PKT_FMT) {
+		/*
+		 * Drop this SoM (and its MARK) so that the next call resumes
+		 * the scan from the bytes that follow it.
+		 */
+		off = pd->packet_buf[0] == OSDP_PKT_MARK ? 2 : 1;
+		osdp_rb_skip(rb, off);
+		phy_rx_discarded(pd, off);
+		pd->packet_buf_len = 0;
+		return OSDP_ERR_PKT_WAIT;
+	}
+	if (ret == OSDP_ERR_PKT_SKIP) {
+		phy_rx_skip_packet(pd, pd->packet_buf, 0);
+		pd->packet_buf_len = 0;
 	}
 
+	return ret;
+}
+#elif !defined(OPT_OSDP_RX_ZERO_COPY)
+static bool phy_rescan_packet_buf(struct osdp_pd *pd)
+{
+	unsigned long j, i = packet_has_mark(pd) + 1; /* +1 to skip current SoM */
+	const uint8_t *som = NULL;
+
 	if (i < pd->packet_buf_len) {
+		som = memchr(pd->packet_buf + i, OSDP_PKT_SOM,
+			     pd->packet_buf_len - i);
+	}
+
+	if (som) {
 		/* found another SoM; move the rest of the bytes down */
-		if (i && pd->packet_buf[i - 1] == OSDP_PKT_MARK) {
+		i = (unsigned long)(som - pd->packet_buf);
+		if (pd->packet_buf[i - 1] == OSDP_PKT_MARK) {
 			pd->packet_buf[0] = OSDP_PKT_MARK;
 			j = 1;
 			SET_FLAG(pd, PD_FLAG_PKT_HAS_MARK);
@@ -472,52 +673,97 @@ static bool phy_rescan_packet_buf(struct osdp_pd *pd)
 			j = 0;
 			CLEAR_FLAG(pd, PD_FLAG_PKT_HAS_MARK);
 		}
-		while (i < pd->packet_buf_len) {
-			pd->packet_buf[j++] = pd->packet_buf[i++];
-		}
-		pd->packet_buf_len = j;
+		memmove(pd->packet_buf + j, pd->packet_buf + i,
+			pd->packet_buf_len - i);
+		phy_rx_discarded(pd, i - j);
+		pd->packet_buf_len = j + pd->packet_buf_len - i;
 		return true;
 	}
 
 	/* nothing found, discarded all */
+	phy_rx_discarded(pd, pd->packet_buf_len);
 	pd->packet_buf_len = 0;
 	return false;
 }
-#endif /* OPT_OSDP_RX_ZERO_COPY */
 
-#ifndef OPT_OSDP_RX_ZERO_COPY
+/*
+ * Drop @count bytes from the head of the RX ring and return the number of
+ * them that were not MARK bytes (i.e. real garbage on the line).
+ */
+static unsigned int phy_rb_discard(struct osdp_pd *pd, int count)
+{
+	uint8_t chunk[64];
+	unsigned int skipped = 0;
+	int i, len;
+
+	while (count > 0) {
+		len = osdp_rb_pop_buf(pd->rx_rb, chunk,
+				      count < (int)sizeof(chunk) ?
+				      count : (int)sizeof(chunk));
+		if (len <= 0) {
+			break;
+		}
+		for (i = 0; i < len; i++) {
+			skipped += (chunk[i] != OSDP_PKT_MARK);
+		}
+		count -= len;
+	}
+
+	return skipped;
+}
+
 static int phy_check_header(struct osdp_pd *pd)
 {
-	int ret, len;
+	int ret, len, off;
 	uint8_t cur_byte = 0, prev_byte = 0;
 	uint8_t *buf = pd->packet_buf;
 
 	/* Scan for packet start */
-	while (pd->packet_buf_len == 0) {
-		if (osdp_rb_pop(pd->rx_rb, &cur_byte)) {
+	if (pd->packet_buf_len == 0) {
+		if (phy_rx_skip_pending(pd)) {
 			return OSDP_ERR_PKT_NO_DATA;
 		}
-		if (cur_byte == OSDP_PKT_SOM) {
-			if (prev_byte == OSDP_PKT_MARK) {
-				buf[0] = OSDP_PKT_MARK;
-				buf[1] = OSDP_PKT_SOM;
-				pd->packet_buf_len = 2;
-			} else {
-				buf[0] = OSDP_PKT_SOM;
-				pd->packet_buf_len = 1;
+		off = osdp_rb_scan(pd->rx_rb, OSDP_PKT_SOM);
+		if (off < 0) {
+			/*
+			 * No SoM yet; drop everything except a trailing MARK
+			 * which may belong to a SoM that hasn't arrived yet.
+			 */
+			off = (int)osdp_rb_len(pd->rx_rb);
+			if (off && osdp_rb_peek(pd->rx_rb, off - 1, &cur_byte) == 0 &&
+			    cur_byte == OSDP_PKT_MARK) {
+				off -= 1;
 			}
-			break;
+			phy_rx_discarded(pd, phy_rb_discard(pd, off));
+			return OSDP_ERR_PKT_NO_DATA;
+		}
+		prev_byte = 0;
+		if (off > 0) {
+			osdp_rb_peek(pd->rx_rb, off - 1, &prev_byte);
 		}
-		if (cur_byte != OSDP_PKT_MARK) {
-			pd->packet_scan_skip++;
+		phy_rx_discarded(pd, phy_rb_discard(pd, off));
+		osdp_rb_skip(pd->rx_rb, 1); /* SoM */
+		if (prev_byte == OSDP_PKT_MARK) {
+			buf[0] = OSDP_PKT_MARK;
+			buf[1] = OSDP_PKT_SOM;
+			pd->packet_buf_len = 2;
+		} else {
+			buf[0] = OSDP_PKT_SOM;
+			pd->packet_buf_len = 1;
 		}
-		prev_byte = cur_byte;
 	}
 
-	/* Found start of a new packet; wait until we have atleast the header */
-	len = osdp_rb_pop_buf(pd->rx_rb, buf + pd->packet_buf_len,
-			      sizeof(struct osdp_packet_header) - 1);
-	pd->packet_buf_len += len;
+	/*
+	 * Found start of a new packet; wait until we have the header. Take no
+	 * more than that off the ring: a skipped packet can be shorter than
+	 * what a blind read would pull in.
+	 */
+	len = (int)sizeof(struct osdp_packet_header) +
+	      (buf[0] == OSDP_PKT_MARK) - (int)pd->packet_buf_len;
+	if (len > 0) {
+		len = osdp_rb_pop_buf(pd->rx_rb, buf + pd->packet_buf_len, len);
+		pd->packet_buf_len += len;
+	}
 
 	/* Validate header using shared function */
 	ret = phy_validate_header(pd, buf, pd->packet_buf_len, OSDP_PACKET_BUF_SIZE);
@@ -534,6 +780,10 @@ static int phy_check_header(struct osdp_pd *pd)
 		}
 		return OSDP_ERR_PKT_WAIT;
 	}
+	if (ret == OSDP_ERR_PKT_SKIP) {
+		phy_rx_skip_packet(pd, buf, pd->packet_buf_len);
+		pd->packet_buf_len = 0;
+	}
 
 	return ret;
 }
@@ -551,8 +801,9 @@ static int phy_check_packet(struct osdp_pd *pd, uint8_t *buf, int pkt_len)
 	}
 	pkt = (struct osdp_packet_header *)buf;
 
-	/* Frame passed framing checks upstream; account it as received
-	 * regardless of integrity-check outcome. */
+	/* Frame passed framing checks upstream (which skip, in PD mode, the
+	 * ones for other PDs); account it as received regardless of the
+	 * integrity-check outcome. */
 	osdp_metrics_report(pd, OSDP_METRIC_PACKET_RECEIVED);
 
 	/* validate CRC/checksum */
@@ -681,6 +932,7 @@ int osdp_phy_check_packet(struct osdp_pd *pd)
 #else /* OPT_OSDP_RX_ZERO_COPY */
 	{
 		ret = osdp_channel_receive(pd);
+		osdp_metrics_wire(pd, OSDP_METRIC_RX_BYTES, ret);
 	}
 #endif /* OPT_OSDP_RX_ZERO_COPY */
 
@@ -693,6 +945,13 @@ int osdp_phy_check_packet(struct osdp_pd *pd)
 		pd->tstamp = osdp_millis_now();
 	}
 
+	/* CP: first bytes on the wire since our command went out */
+	if (is_cp_mode(pd) && ret > 0 && !pd->phy_rx_seen) {
+		pd->phy_rx_seen = true;
+		osdp_metrics_sample(pd, OSDP_METRIC_HIST_TURNAROUND,
+				    osdp_millis_since(pd->phy_tstamp));
+	}
+
 	/* Parse and validate packet header */
 	if (pd->packet_len == 0) {
 #ifdef OPT_OSDP_RX_ZERO_COPY
@@ -712,6 +971,7 @@ int osdp_phy_check_packet(struct osdp_pd *pd)
 			pd->packet_len = ret;
 			pd->packet_buf_len = ret;
 			pd->rx_pkt->len = ret;
+			osdp_metrics_wire(pd, OSDP_METRIC_RX_BYTES, ret);
 		}
 #else /* OPT_OSDP_RX_ZERO_COPY */
 		{
@@ -720,17 +980,22 @@ int osdp_phy_check_packet(struct osdp_pd *pd)
 				return ret;
 			}
 			pd->packet_len = ret;
-			if (pd->packet_scan_skip) {
-				LOG_DBG("Packet scan skipped:%u mark:%d",
-					pd->packet_scan_skip,
-					ISSET_FLAG(pd, PD_FLAG_PKT_HAS_MARK));
-				pd->packet_scan_skip = 0;
-			}
 		}
 #endif /* OPT_OSDP_RX_ZERO_COPY */
 	}
 
-#ifndef OPT_OSDP_RX_ZERO_COPY
+#ifdef OPT_OSDP_RX_ARENA
+	{
+		/* Arena: the packet is validated where it landed */
+		pd->packet_buf = pd->rx_rb->buffer + pd->rx_rb->tail;
+		pd->packet_buf_len = osdp_rb_len(pd->rx_rb);
+		if (pd->packet_buf_len < pd->packet_len) {
+			return OSDP_ERR_PKT_WAIT;
+		}
+		pd->packet_buf_len = pd->packet_len;
+		pd->packet_claim = pd->packet_len;
+	}
+#elif !defined(OPT_OSDP_RX_ZERO_COPY)
 	{
 		/* Traditional: collect remaining packet bytes from ring buffer */
 		ret = osdp_rb_pop_buf(pd->rx_rb,
@@ -751,7 +1016,7 @@ int osdp_phy_check_packet(struct osdp_pd *pd)
 	ret = phy_check_packet(pd, pd->packet_buf, pd->packet_len);
 
 	/* Relase packet buffers on errors */
-#ifdef OPT_OSDP_RX_ZERO_COPY
+#if defined(OPT_OSDP_RX_ZERO_COPY) || defined(OPT_OSDP_RX_ARENA)
 	if (ret != OSDP_ERR_PKT_NONE) {
 		osdp_phy_release_packet(pd);
 	}
@@ -784,6 +1049,13 @@ int osdp_phy_decode_packet(struct osdp_pd *pd, uint8_t **pkt_start)
 			pd->nak_code = OSDP_PD_NAK_SC_UNSUP;
 			return OSDP_ERR_PKT_NACK;
 		}
+		/* the security block and the cmd/reply ID must both fit */
+		if (len < 3 || pkt->data[0] < 2 || pkt->data[0] >= len) {
+			LOG_ERR("Invalid SB length");
+			pd->reply_id = REPLY_NAK;
+			pd->nak_code = OSDP_PD_NAK_SC_COND;
+			return OSDP_ERR_PKT_NACK;
+		}
 		if (pkt->data[1] < SCS_11 || pkt->data[1] > SCS_18) {
 			LOG_ERR("Invalid SB Type");
 			pd->reply_id = REPLY_NAK;
@@ -845,20 +1117,15 @@ int osdp_phy_decode_packet(struct osdp_pd *pd, uint8_t **pkt_start)
 
 	if (is_sc_active &&
 	    pkt->control & PKT_CONTROL_SCB && pkt->data[1] >= SCS_15) {
-		/* validate MAC */
 		is_cmd = is_pd_mode(pd);
-		osdp_compute_mac(pd, is_cmd, buf, mac_offset);
-		mac = is_cmd ? pd->sc.c_mac : pd->sc.r_mac;
-		if (memcmp(buf + mac_offset, mac, 4) != 0) {
-			LOG_ERR("Invalid MAC; discarding SC");
-			sc_deactivate(pd);
+		len -= 4; /* consume MAC */
+		if (len < 1) {
+			LOG_ERR("No room for MAC and cmd/reply ID");
 			pd->reply_id = REPLY_NAK;
 			pd->nak_code = OSDP_PD_NAK_SC_COND;
 			return OSDP_ERR_PKT_NACK;
 		}
-		len -= 4; /* consume MAC */
 
-		/* decrypt data block */
 		if (pkt->data[1] == SCS_17 || pkt->data[1] == SCS_18) {
 			/**
 			 * Only the data portion of message (after id byte)
@@ -868,9 +1135,24 @@ int osdp_phy_decode_packet(struct osdp_pd *pd, uint8_t **pkt_start)
 			 *
 			 * At this point, the header and security block is
 			 * already consumed. So we can just skip the cmd/reply
-			 * ID (data[0])  when calling osdp_decrypt_data().
+			 * ID (data[0]). MAC validation and decryption are done
+			 * in the same walk over the packet.
 			 */
-			len = osdp_decrypt_data(pd, is_cmd, data + 1, len - 1);
+			if ((len - 1) % 16 != 0) {
+				LOG_ERR("Encrypted data block not block aligned");
+				pd->reply_id = REPLY_NAK;
+				pd->nak_code = OSDP_PD_NAK_SC_COND;
+				return OSDP_ERR_PKT_NACK;
+			}
+			len = osdp_sc_open(pd, buf, (int)(data + 1 - buf),
+					   len - 1, buf + mac_offset);
+			if (len == -1) {
+				LOG_ERR("Invalid MAC; discarding SC");
+				sc_deactivate(pd);
+				pd->reply_id = REPLY_NAK;
+				pd->nak_code = OSDP_PD_NAK_SC_COND;
+				return OSDP_ERR_PKT_NACK;
+			}
 			if (len < 0) {
 				LOG_ERR("Failed at decrypt; discarding SC");
 				sc_deactivate(pd);
@@ -888,6 +1170,17 @@ int osdp_phy_decode_packet(struct osdp_pd *pd, uint8_t **pkt_start)
 					"length; tolerating non-conformance!");
 			}
 			len += 1; /* put back cmd/reply ID */
+		} else {
+			/* validate MAC */
+			osdp_compute_mac(pd, is_cmd, buf, mac_offset);
+			mac = is_cmd ? pd->sc.c_mac : pd->sc.r_mac;
+			if (memcmp(buf + mac_offset, mac, 4) != 0) {
+				LOG_ERR("Invalid MAC; discarding SC");
+				sc_deactivate(pd);
+				pd->reply_id = REPLY_NAK;
+				pd->nak_code = OSDP_PD_NAK_SC_COND;
+				return OSDP_ERR_PKT_NACK;
+			}
 		}
 	}
 
@@ -937,6 +1230,15 @@ void osdp_phy_state_reset(struct osdp_pd *pd, bool is_error)
 	if (pd->rx_pkt && pd->rx_pkt->buf) {
 		osdp_phy_release_packet(pd);
 	}
+#endif
+#ifdef OPT_OSDP_RX_ARENA
+	if (pd->packet_claim) {
+		osdp_phy_release_packet(pd);
+	} else if (pd->packet_buf_len &&
+		   pd->packet_buf == pd->rx_rb->buffer + pd->rx_rb->tail) {
+		/* abandon a partially received packet */
+		osdp_rb_skip(pd->rx_rb, (int)pd->packet_buf_len);
+	}
 #endif
 	pd->packet_buf_len = 0;
 	pd->packet_len = 0;
@@ -952,6 +1254,7 @@ void osdp_phy_state_reset(struct osdp_pd *pd, bool is_error)
 		}
 #ifndef OPT_OSDP_RX_ZERO_COPY
 		osdp_rb_reset(pd->rx_rb);
+		pd->rx_skip = 0;
 #endif
 	}
 }
@@ -5,8 +5,10 @@
  */
 
 #include "osdp_common.h"
+#include "osdp_metrics.h"
 
 #define OSDP_SC_EOM_MARKER             0x80  /* End of Message Marker */
+#define OSDP_SC_CHUNK_SIZE             64    /* seal/open working set */
 
 /* Default key as specified in OSDP specification */
 static const uint8_t osdp_scbk_default[16] = {
@@ -14,10 +16,124 @@ static const uint8_t osdp_scbk_default[16] = {
 	0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F
 };
 
+/**
+ * Session key operations. They run on the cipher handles that
+ * osdp_compute_session_keys() prepares and sc_deactivate() releases.
+ * Callers that install session keys directly have no handle; they get the
+ * one-shot backend calls on the raw key instead, so nothing is left behind
+ * that would need releasing.
+ */
+static void sc_key_encrypt(struct osdp_crypt_key *key, uint8_t *raw_key,
+			   uint8_t *iv, uint8_t *data, int len)
+{
+	if (key->ready) {
+		osdp_crypt_key_encrypt(key, iv, data, len);
+	} else {
+		osdp_encrypt(raw_key, iv, data, len);
+	}
+}
+
+static void sc_key_decrypt(struct osdp_crypt_key *key, uint8_t *raw_key,
+			   uint8_t *iv, uint8_t *data, int len)
+{
+	if (key->ready) {
+		osdp_crypt_key_decrypt(key, iv, data, len);
+	} else {
+		osdp_decrypt(raw_key, iv, data, len);
+	}
+}
+
+static void sc_key_cbc_mac(struct osdp_crypt_key *key, uint8_t *raw_key,
+			   uint8_t *iv, const uint8_t *data, int len)
+{
+	int i;
+
+	if (key->ready) {
+		osdp_crypt_key_cbc_mac(key, iv, data, len);
+		return;
+	}
+	for (; len >= 16; len -= 16, data += 16) {
+		for (i = 0; i < 16; i++) {
+			iv[i] ^= data[i];
+		}
+		osdp_encrypt(raw_key, NULL, iv, 16);
+	}
+}
+
+#define sc_enc(pd, iv, d, l) \
+	sc_key_encrypt(&(pd)->sc.k_enc, (pd)->sc.s_enc, iv, d, l)
+#define sc_dec(pd, iv, d, l) \
+	sc_key_decrypt(&(pd)->sc.k_dec, (pd)->sc.s_enc, iv, d, l)
+#define sc_mac1(pd, iv, d, l) \
+	sc_key_encrypt(&(pd)->sc.k_mac1, (pd)->sc.s_mac1, iv, d, l)
+#define sc_mac1_cbc(pd, iv, d, l) \
+	sc_key_cbc_mac(&(pd)->sc.k_mac1, (pd)->sc.s_mac1, iv, d, l)
+#define sc_mac2(pd, iv, d, l) \
+	sc_key_encrypt(&(pd)->sc.k_mac2, (pd)->sc.s_mac2, iv, d, l)
+
+void osdp_sc_release_keys(struct osdp_pd *pd)
+{
+	osdp_crypt_key_teardown(&pd->sc.k_enc);
+	osdp_crypt_key_teardown(&pd->sc.k_dec);
+	osdp_crypt_key_teardown(&pd->sc.k_mac1);
+	osdp_crypt_key_teardown(&pd->sc.k_mac2);
+	pd->sc.keys_ready = false;
+}
+
+/**
+ * Like memcmp; but operates at constant time.
+ *
+ * Returns 0 if memory pointed to by s1 and and s2 are identical; non-zero
+ * otherwise.
+ */
+static int osdp_ct_compare(const void *s1, const void *s2, size_t len)
+{
+	size_t i, ret = 0;
+	const uint8_t *_s1 = s1;
+	const uint8_t *_s2 = s2;
+
+	for (i = 0; i < len; i++) {
+		ret |= _s1[i] ^ _s2[i];
+	}
+	return (int)ret;
+}
+
+/**
+ * Returns the expanded encrypt schedule of @a raw_key from @a ck, expanding
+ * it only if @a ck was last keyed with something else. SCBKs change far
+ * less often than SC sessions are set up, so a
+ * handshake normally gets its SCBK schedule from here instead of expanding
+ * it for each of the three session key derivations.
+ */
+static struct osdp_crypt_key *sc_cached_key(struct osdp_pd *pd,
+					    struct osdp_sc_cached_key *ck,
+					    const uint8_t *raw_key)
+{
+	if (ck->key.ready && osdp_ct_compare(ck->raw, raw_key, 16) == 0) {
+		osdp_metrics_report(pd, OSDP_METRIC_SC_KEY_CACHE_HIT);
+		return &ck->key;
+	}
+	osdp_metrics_report(pd, OSDP_METRIC_SC_KEY_CACHE_MISS);
+	osdp_sc_release_cached_key(ck);
+	memcpy(ck->raw, raw_key, 16);
+	osdp_crypt_key_setup(&ck->key, raw_key, false);
+	return &ck->key;
+}
+
+void osdp_sc_release_cached_key(struct osdp_sc_cached_key *ck)
+{
+	osdp_crypt_key_teardown(&ck->key);
+	osdp_fill_zeros(ck->raw, sizeof(ck->raw));
+}
+
 void osdp_compute_scbk(struct osdp_pd *pd, uint8_t *master_key, uint8_t *scbk)
 {
 	int i;
 
+	/*
+	 * Not cached: telling a cached schedule from a new key would need a
+	 * copy of the master key, which is the app's to keep, not ours.
+	 */
 	memcpy(scbk, pd->sc.pd_client_uid, 8);
 	for (i = 8; i < 16; i++) {
 		scbk[i] = ~scbk[i - 8];
@@ -29,12 +145,17 @@ void osdp_compute_session_keys(struct osdp_pd *pd)
 {
 	int i;
 	uint8_t scbk[16];
+	struct osdp_crypt_key one_shot = { 0 }, *key = &one_shot;
 
 	if (ISSET_FLAG(pd, PD_FLAG_SC_USE_SCBKD)) {
 		memcpy(scbk, osdp_scbk_default, 16);
 	} else {
 		memcpy(scbk, pd->sc.scbk, 16);
 	}
+	/* without a context, nothing would ever release the schedule */
+	if (pd->osdp_ctx) {
+		key = sc_cached_key(pd, &pd->scbk_key, scbk);
+	}
 
 	memset(pd->sc.s_enc, 0, 16);
 	memset(pd->sc.s_mac1, 0, 16);
@@ -53,10 +174,18 @@ void osdp_compute_session_keys(struct osdp_pd *pd)
 		pd->sc.s_mac2[i] = pd->sc.cp_random[i - 2];
 	}
 
-	osdp_encrypt(scbk, NULL, pd->sc.s_enc, 16);
-	osdp_encrypt(scbk, NULL, pd->sc.s_mac1, 16);
-	osdp_encrypt(scbk, NULL, pd->sc.s_mac2, 16);
+	sc_key_encrypt(key, scbk, NULL, pd->sc.s_enc, 16);
+	sc_key_encrypt(key, scbk, NULL, pd->sc.s_mac1, 16);
+	sc_key_encrypt(key, scbk, NULL, pd->sc.s_mac2, 16);
 	osdp_fill_zeros(scbk, sizeof(scbk));
+
+	/* Key schedules are computed once here and reused for every packet */
+	osdp_sc_release_keys(pd);
+	osdp_crypt_key_setup(&pd->sc.k_enc, pd->sc.s_enc, false);
+	osdp_crypt_key_setup(&pd->sc.k_dec, pd->sc.s_enc, true);
+	osdp_crypt_key_setup(&pd->sc.k_mac1, pd->sc.s_mac1, false);
+	osdp_crypt_key_setup(&pd->sc.k_mac2, pd->sc.s_mac2, false);
+	pd->sc.keys_ready = true;
 }
 
 void osdp_compute_cp_cryptogram(struct osdp_pd *pd)
@@ -64,25 +193,7 @@ void osdp_compute_cp_cryptogram(struct osdp_pd *pd)
 	/* cp_cryptogram = AES-ECB( pd_random[8] || cp_random[8], s_enc ) */
 	memcpy(pd->sc.cp_cryptogram + 0, pd->sc.pd_random, 8);
 	memcpy(pd->sc.cp_cryptogram + 8, pd->sc.cp_random, 8);
-	osdp_encrypt(pd->sc.s_enc, NULL, pd->sc.cp_cryptogram, 16);
-}
-
-/**
- * Like memcmp; but operates at constant time.
- *
- * Returns 0 if memory pointed to by s1 and and s2 are identical; non-zero
- * otherwise.
- */
-static int osdp_ct_compare(const void *s1, const void *s2, size_t len)
-{
-	size_t i, ret = 0;
-	const uint8_t *_s1 = s1;
-	const uint8_t *_s2 = s2;
-
-	for (i = 0; i < len; i++) {
-		ret |= _s1[i] ^ _s2[i];
-	}
-	return (int)ret;
+	sc_enc(pd, NULL, pd->sc.cp_cryptogram, 16);
 }
 
 int osdp_verify_cp_cryptogram(struct osdp_pd *pd)
@@ -92,7 +203,7 @@ int osdp_verify_cp_cryptogram(struct osdp_pd *pd)
 	/* cp_cryptogram = AES-ECB( pd_random[8] || cp_random[8], s_enc ) */
 	memcpy(cp_crypto + 0, pd->sc.pd_random, 8);
 	memcpy(cp_crypto + 8, pd->sc.cp_random, 8);
-	osdp_encrypt(pd->sc.s_enc, NULL, cp_crypto, 16);
+	sc_enc(pd, NULL, cp_crypto, 16);
 
 	int ret = osdp_ct_compare(pd->sc.cp_cryptogram, cp_crypto, 16) == 0 ? 0 : -1;
 	osdp_fill_zeros(cp_crypto, sizeof(cp_crypto));
@@ -104,7 +215,7 @@ void osdp_compute_pd_cryptogram(struct osdp_pd *pd)
 	/* pd_cryptogram = AES-ECB( cp_random[8] || pd_random[8], s_enc ) */
 	memcpy(pd->sc.pd_cryptogram + 0, pd->sc.cp_random, 8);
 	memcpy(pd->sc.pd_cryptogram + 8, pd->sc.pd_random, 8);
-	osdp_encrypt(pd->sc.s_enc, NULL, pd->sc.pd_cryptogram, 16);
+	sc_enc(pd, NULL, pd->sc.pd_cryptogram, 16);
 }
 
 int osdp_verify_pd_cryptogram(struct osdp_pd *pd)
@@ -114,7 +225,7 @@ int osdp_verify_pd_cryptogram(struct osdp_pd *pd)
 	/* pd_cryptogram = AES-ECB( cp_random[8] || pd_random[8], s_enc ) */
 	memcpy(pd_crypto + 0, pd->sc.cp_random, 8);
 	memcpy(pd_crypto + 8, pd->sc.pd_random, 8);
-	osdp_encrypt(pd->sc.s_enc, NULL, pd_crypto, 16);
+	sc_enc(pd, NULL, pd_crypto, 16);
 
 	int ret = osdp_ct_compare(pd->sc.pd_cryptogram, pd_crypto, 16) == 0 ? 0 : -1;
 	osdp_fill_zeros(pd_crypto, sizeof(pd_crypto));
@@ -125,8 +236,42 @@ void osdp_compute_rmac_i(struct osdp_pd *pd)
 {
 	/* rmac_i = AES-ECB( AES-ECB( cp_cryptogram, s_mac1 ), s_mac2 ) */
 	memcpy(pd->sc.r_mac, pd->sc.cp_cryptogram, 16);
-	osdp_encrypt(pd->sc.s_mac1, NULL, pd->sc.r_mac, 16);
-	osdp_encrypt(pd->sc.s_mac2, NULL, pd->sc.r_mac, 16);
+	sc_mac1(pd, NULL, pd->sc.r_mac, 16);
+	sc_mac2(pd, NULL, pd->sc.r_mac, 16);
+}
+
+/**
+ * Removes the EOM marker and zero padding from a decrypted data block.
+ * Returns the plain-text length or -1 if the marker is missing.
+ */
+static int sc_strip_padding(uint8_t *data, int length)
+{
+	length--;
+	while (length && data[length] == 0x00) {
+		length--;
+	}
+	if (data[length] != OSDP_SC_EOM_MARKER) {
+		return -1;
+	}
+	data[length] = 0;
+
+	return length;
+}
+
+/**
+ * Appends the EOM marker and zero padding to a data block and returns the
+ * block aligned length.
+ */
+static int sc_add_padding(uint8_t *data, int length)
+{
+	int pad_len;
+
+	data[length] = OSDP_SC_EOM_MARKER;
+	pad_len = AES_PAD_LEN(length + 1);
+	if ((pad_len - length - 1) > 0) {
+		memset(data + length + 1, 0, pad_len - length - 1);
+	}
+	return pad_len;
 }
 
 int osdp_decrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
@@ -147,18 +292,9 @@ int osdp_decrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
 		iv[i] = ~iv[i];
 	}
 
-	osdp_decrypt(pd->sc.s_enc, iv, data, length);
-
-	length--;
-	while (length && data[length] == 0x00) {
-		length--;
-	}
-	if (data[length] != OSDP_SC_EOM_MARKER) {
-		return -1;
-	}
-	data[length] = 0;
+	sc_dec(pd, iv, data, length);
 
-	return length;
+	return sc_strip_padding(data, length);
 }
 
 int osdp_encrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
@@ -166,17 +302,13 @@ int osdp_encrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
 	int i, pad_len;
 	uint8_t iv[16];
 
-	data[length] = OSDP_SC_EOM_MARKER;  /* append EOM marker */
-	pad_len = AES_PAD_LEN(length + 1);
-	if ((pad_len - length - 1) > 0) {
-		memset(data + length + 1, 0, pad_len - length - 1);
-	}
+	pad_len = sc_add_padding(data, length);
 	memcpy(iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
 	for (i = 0; i < 16; i++) {
 		iv[i] = ~iv[i];
 	}
 
-	osdp_encrypt(pd->sc.s_enc, iv, data, pad_len);
+	sc_enc(pd, iv, data, pad_len);
 
 	return pad_len;
 }
@@ -184,7 +316,7 @@ int osdp_encrypt_data(struct osdp_pd *pd, int is_cmd, uint8_t *data, int length)
 int osdp_compute_mac(struct osdp_pd *pd, int is_cmd,
 		     const uint8_t *data, int len)
 {
-	int i, j, n, full_blocks, rem;
+	int n, full_blocks, rem;
 	const uint8_t *p;
 	uint8_t block[16] = { 0 };
 	uint8_t iv[16];
@@ -206,14 +338,10 @@ int osdp_compute_mac(struct osdp_pd *pd, int is_cmd,
 		n = 1;
 	}
 
-	/* Process B[1]..B[N-1] with SMAC-1 in CBC fashion. */
-	for (i = 0; i < n - 1; i++, p += 16) {
-		memcpy(block, p, 16);
-		for (j = 0; j < 16; j++) {
-			block[j] ^= iv[j];
-		}
-		osdp_encrypt(pd->sc.s_mac1, NULL, block, 16);
-		memcpy(iv, block, 16);
+	/* Process B[1]..B[N-1] with SMAC-1 in CBC fashion; one backend call */
+	if (n > 1) {
+		sc_mac1_cbc(pd, iv, p, (n - 1) * 16);
+		p += (n - 1) * 16;
 	}
 
 	/* Build B[N], using 0x80 + zero padding when len is not block aligned. */
@@ -224,17 +352,150 @@ int osdp_compute_mac(struct osdp_pd *pd, int is_cmd,
 		memcpy(block, p, rem);
 		block[rem] = 0x80; /* end marker */
 	}
-	for (i = 0; i < 16; i++) {
-		block[i] ^= iv[i];
-	}
 
-	/* B[N] encrypted with SMAC-2 == MAC */
-	osdp_encrypt(pd->sc.s_mac2, NULL, block, 16);
+	/* B[N] chained with IV2 and encrypted with SMAC-2 == MAC */
+	sc_mac2(pd, iv, block, 16);
 	memcpy(is_cmd ? pd->sc.c_mac : pd->sc.r_mac, block, 16);
 
 	return 0;
 }
 
+/**
+ * Streaming form of osdp_compute_mac() so that the MAC can be folded into
+ * the same walk over the packet as the data block cipher. The last block
+ * seen is held back since it must go through SMAC-2 instead of SMAC-1.
+ */
+struct sc_mac_stream {
+	uint8_t iv[16];
+	uint8_t block[16];
+	int fill;
+};
+
+static void sc_mac_absorb(struct osdp_pd *pd, struct sc_mac_stream *m,
+			  const uint8_t *data, int len)
+{
+	int n;
+
+	if (m->fill > 0) {
+		n = 16 - m->fill;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(m->block + m->fill, data, n);
+		m->fill += n;
+		data += n;
+		len -= n;
+		if (len == 0) {
+			return;
+		}
+		/* more data follows; held block is not the last one */
+		sc_mac1_cbc(pd, m->iv, m->block, 16);
+		m->fill = 0;
+	}
+
+	if (len > 16) {
+		n = ((len - 1) / 16) * 16;
+		sc_mac1_cbc(pd, m->iv, data, n);
+		data += n;
+		len -= n;
+	}
+
+	memcpy(m->block, data, len);
+	m->fill = len;
+}
+
+static void sc_mac_final(struct osdp_pd *pd, struct sc_mac_stream *m,
+			 uint8_t *mac)
+{
+	if (m->fill < 16) {
+		m->block[m->fill] = 0x80; /* end marker */
+		memset(m->block + m->fill + 1, 0, 16 - m->fill - 1);
+	}
+	sc_mac2(pd, m->iv, m->block, 16);
+	memcpy(mac, m->block, 16);
+}
+
+int osdp_sc_seal(struct osdp_pd *pd, uint8_t *buf, int hdr_len, int data_len)
+{
+	int i, chunk, pad_len, is_cmd = is_cp_mode(pd);
+	uint8_t iv[16], *data = buf + hdr_len;
+	struct sc_mac_stream m = { .fill = 0 };
+	uint64_t cycles = osdp_cycles_now();
+
+	memcpy(m.iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
+	for (i = 0; i < 16; i++) {
+		iv[i] = ~m.iv[i];
+	}
+
+	pad_len = sc_add_padding(data, data_len);
+	sc_mac_absorb(pd, &m, buf, hdr_len);
+	for (i = 0; i < pad_len; i += chunk) {
+		chunk = pad_len - i;
+		if (chunk > OSDP_SC_CHUNK_SIZE) {
+			chunk = OSDP_SC_CHUNK_SIZE;
+		}
+		sc_enc(pd, iv, data + i, chunk);
+		memcpy(iv, data + i + chunk - 16, 16);
+		sc_mac_absorb(pd, &m, data + i, chunk);
+	}
+	sc_mac_final(pd, &m, is_cmd ? pd->sc.c_mac : pd->sc.r_mac);
+
+	osdp_metrics_report(pd, OSDP_METRIC_SC_SEAL);
+	osdp_metrics_add(pd, OSDP_METRIC_SC_SEAL_CYCLES,
+			 osdp_cycles_now() - cycles);
+	return hdr_len + pad_len;
+}
+
+int osdp_sc_open(struct osdp_pd *pd, uint8_t *buf, int hdr_len, int data_len,
+		 const uint8_t *mac)
+{
+	int i, chunk, ret, is_cmd = is_pd_mode(pd);
+	uint8_t iv[16], next_iv[16], *data = buf + hdr_len;
+	struct sc_mac_stream m = { .fill = 0 };
+	uint64_t cycles;
+
+	/* the caller checks these; nothing is absorbed for a bad frame */
+	if (hdr_len < 1 || data_len < 0 || data_len % 16 != 0) {
+		return -2;
+	}
+
+	cycles = osdp_cycles_now();
+	memcpy(m.iv, is_cmd ? pd->sc.r_mac : pd->sc.c_mac, 16);
+	for (i = 0; i < 16; i++) {
+		iv[i] = ~m.iv[i];
+	}
+
+	sc_mac_absorb(pd, &m, buf, hdr_len);
+	for (i = 0; i < data_len; i += chunk) {
+		chunk = data_len - i;
+		if (chunk > OSDP_SC_CHUNK_SIZE) {
+			chunk = OSDP_SC_CHUNK_SIZE;
+		}
+		/* MAC is over the cipher text; absorb before decrypting */
+		sc_mac_absorb(pd, &m, data + i, chunk);
+		memcpy(next_iv, data + i + chunk - 16, 16);
+		sc_dec(pd, iv, data + i, chunk);
+		memcpy(iv, next_iv, 16);
+	}
+	sc_mac_final(pd, &m, is_cmd ? pd->sc.c_mac : pd->sc.r_mac);
+
+	if (osdp_ct_compare(is_cmd ? pd->sc.c_mac : pd->sc.r_mac, mac, 4)) {
+		ret = -1;
+	} else if (data_len == 0) {
+		ret = sc_allow_empty_encrypted_data_block(pd) ? 0 : -2;
+	} else {
+		ret = sc_strip_padding(data, data_len);
+		if (ret < 0) {
+			ret = -2;
+		}
+	}
+
+	osdp_metrics_report(pd, OSDP_METRIC_SC_OPEN);
+	osdp_metrics_add(pd, OSDP_METRIC_SC_OPEN_CYCLES,
+			 osdp_cycles_now() - cycles);
+	return ret;
+}
+
 void osdp_sc_setup(struct osdp_pd *pd)
 {
 	uint8_t scbk[16];
@@ -245,6 +506,7 @@ void osdp_sc_setup(struct osdp_pd *pd)
 	 * must not be re-emitted after a handshake. */
 	pd->last_tx_len = 0;
 
+	osdp_sc_release_keys(pd);
 	memcpy(scbk, pd->sc.scbk, 16);
 	memset(&pd->sc, 0, sizeof(struct osdp_secure_channel));
 	memcpy(pd->sc.scbk, scbk, 16);
@@ -265,7 +527,7 @@ void osdp_sc_setup(struct osdp_pd *pd)
 
 void osdp_sc_teardown(struct osdp_pd *pd)
 {
-	ARG_UNUSED(pd);
+	osdp_sc_release_keys(pd);
 	osdp_crypt_teardown();
 }
 
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Virtual RS-485 multi-drop bus.
+ *
+ * Every send() becomes a frame on a shared wire: its first bit goes out
+ * turnaround_us after the call (or once the node's own previous frame is
+ * done) and each byte then takes 10 bit times. osdp_vbus_advance() walks
+ * the wire in time order and copies each byte, once its wire time is up,
+ * into the RX FIFO of every other node on the bus. There is no carrier
+ * sense on RS-485, so a frame that overlaps another one on the wire is
+ * sent anyway and the overlapping bytes of both come out garbled.
+ *
+ * Time is kept in nanoseconds on the bus. When the bus owns the clock,
+ * osdp_millis_now() returns bus time, so timeouts inside LibOSDP expire
+ * as fast as the caller advances the bus rather than in wall clock time.
+ */
+
+#include "osdp_common.h"
+
+#if defined(OPT_OSDP_STATIC) || defined(OPT_OSDP_RX_ZERO_COPY)
+#error "Virtual bus needs dynamic memory and the byte-stream recv() API"
+#endif
+
+#define VBUS_FRAME_SIZE (OSDP_PACKET_BUF_SIZE + 8)
+
+struct vbus_frame {
+	int src;
+	int len;
+	int pos;            /* bytes already delivered */
+	uint64_t start_ns;  /* first bit on the wire */
+	uint8_t data[VBUS_FRAME_SIZE];
+};
+
+struct vbus_node {
+	struct osdp_vbus *bus;
+	int id;
+	bool attached;
+	uint64_t tx_free_ns; /* this node's UART is idle from here on */
+	uint8_t rx[OSDP_VBUS_RX_FIFO_SIZE];
+	int rx_head;
+	int rx_tail;
+};
+
+struct osdp_vbus {
+	struct osdp_vbus_config config;
+	uint64_t byte_ns;
+	uint64_t turnaround_ns;
+	uint64_t now_ns;
+	tick_t now_ms;
+	uint32_t rng;
+
+	int num_nodes;
+	struct vbus_node *nodes[OSDP_VBUS_MAX_NODES];
+
+	int num_frames;
+	struct vbus_frame frames[OSDP_VBUS_MAX_FRAMES];
+
+	struct osdp_vbus_stats stats;
+};
+
+/* xorshift32; good enough for impairments and reproducible from a seed */
+static uint32_t vbus_rand(struct osdp_vbus *bus)
+{
+	uint32_t x = bus->rng;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	bus->rng = x;
+	return x;
+}
+
+static bool vbus_chance(struct osdp_vbus *bus, uint32_t ppm)
+{
+	return ppm && (vbus_rand(bus) % 1000000) < ppm;
+}
+
+static inline uint64_t vbus_max(uint64_t a, uint64_t b)
+{
+	return a > b ? a : b;
+}
+
+static void vbus_set_time(struct osdp_vbus *bus, uint64_t now_ns)
+{
+	bus->now_ns = now_ns;
+	bus->now_ms = (tick_t)(now_ns / 1000000);
+}
+
+/* Garble the bytes of frame f that are on the wire in [lo, hi) */
+static void vbus_garble(struct osdp_vbus *bus, struct vbus_frame *f,
+			uint64_t lo, uint64_t hi)
+{
+	uint64_t first, last;
+
+	first = (lo - f->start_ns) / bus->byte_ns;
+	last = (hi - f->start_ns + bus->byte_ns - 1) / bus->byte_ns;
+	if (last > (uint64_t)f->len) {
+		last = f->len;
+	}
+	while (first < last) {
+		f->data[first++] ^= (uint8_t)(1 + vbus_rand(bus) % 255);
+	}
+}
+
+static void vbus_check_collisions(struct osdp_vbus *bus, struct vbus_frame *nf)
+{
+	int i;
+	uint64_t lo, hi, nf_end, f_end;
+	struct vbus_frame *f;
+
+	if (bus->byte_ns == 0) {
+		return; /* frames take no wire time; they can't overlap */
+	}
+	nf_end = nf->start_ns + nf->len * bus->byte_ns;
+	for (i = 0; i < bus->num_frames; i++) {
+		f = &bus->frames[i];
+		if (f == nf || f->src == nf->src) {
+			continue;
+		}
+		f_end = f->start_ns + f->len * bus->byte_ns;
+		lo = vbus_max(f->start_ns, nf->start_ns);
+		hi = (f_end < nf_end) ? f_end : nf_end;
+		if (lo >= hi) {
+			continue;
+		}
+		vbus_garble(bus, f, lo, hi);
+		vbus_garble(bus, nf, lo, hi);
+		bus->stats.collisions++;
+	}
+}
+
+static void vbus_deliver(struct osdp_vbus *bus, int src, uint8_t byte)
+{
+	int i, next;
+	struct vbus_node *node;
+
+	if (vbus_chance(bus, bus->config.drop_ppm)) {
+		bus->stats.bytes_dropped++;
+		return;
+	}
+	if (vbus_chance(bus, bus->config.flip_ppm)) {
+		byte ^= (uint8_t)BIT(vbus_rand(bus) % 8);
+		bus->stats.bits_flipped++;
+	}
+
+	for (i = 0; i < bus->num_nodes; i++) {
+		node = bus->nodes[i];
+		if (i == src || !node->attached) {
+			continue;
+		}
+		next = (node->rx_head + 1) % OSDP_VBUS_RX_FIFO_SIZE;
+		if (next == node->rx_tail) {
+			bus->stats.rx_overflows++;
+			continue;
+		}
+		node->rx[node->rx_head] = byte;
+		node->rx_head = next;
+	}
+}
+
+static int vbus_send(void *data, uint8_t *buf, int len)
+{
+	struct vbus_node *node = data;
+	struct osdp_vbus *bus = node->bus;
+	struct vbus_frame *f;
+
+	if (len > VBUS_FRAME_SIZE) {
+		return -1;
+	}
+	if (bus->num_frames == OSDP_VBUS_MAX_FRAMES) {
+		return 0; /* wire backlog full; try again later */
+	}
+
+	f = &bus->frames[bus->num_frames++];
+	f->src = node->id;
+	f->len = len;
+	f->pos = 0;
+	f->start_ns = vbus_max(bus->now_ns + bus->turnaround_ns,
+			       node->tx_free_ns);
+	memcpy(f->data, buf, len);
+	node->tx_free_ns = f->start_ns + len * bus->byte_ns;
+	bus->stats.bytes_sent += len;
+	vbus_check_collisions(bus, f);
+	return len;
+}
+
+static int vbus_recv(void *data, uint8_t *buf, int max_len)
+{
+	struct vbus_node *node = data;
+	int n = 0;
+
+	while (n < max_len && node->rx_tail != node->rx_head) {
+		buf[n++] = node->rx[node->rx_tail];
+		node->rx_tail = (node->rx_tail + 1) % OSDP_VBUS_RX_FIFO_SIZE;
+	}
+	return n;
+}
+
+static void vbus_flush(void *data)
+{
+	struct vbus_node *node = data;
+
+	node->rx_tail = node->rx_head;
+}
+
+static void vbus_close(void *data)
+{
+	struct vbus_node *node = data;
+
+	node->attached = false;
+	node->rx_tail = node->rx_head;
+}
+
+osdp_vbus_t *osdp_vbus_create(const struct osdp_vbus_config *config)
+{
+	struct osdp_vbus *bus;
+
+	if (config == NULL || config->baud_rate < 0 || config->turnaround_us < 0 ||
+	    config->drop_ppm > 1000000 || config->flip_ppm > 1000000) {
+		return NULL;
+	}
+	if (config->virtual_clock && osdp_virtual_clock) {
+		return NULL; /* another bus owns the clock */
+	}
+
+	bus = calloc(1, sizeof(struct osdp_vbus));
+	if (bus == NULL) {
+		return NULL;
+	}
+	bus->config = *config;
+	if (config->baud_rate) {
+		bus->byte_ns = 10ULL * 1000000000ULL / config->baud_rate;
+	}
+	bus->turnaround_ns = (uint64_t)config->turnaround_us * 1000;
+	bus->rng = config->seed ? config->seed : 0x6f736470;
+	/* start at wall clock time so timestamps taken before this carry on */
+	vbus_set_time(bus, (uint64_t)osdp_millis_now() * 1000000);
+	if (config->virtual_clock) {
+		osdp_virtual_clock = &bus->now_ms;
+	}
+	return (osdp_vbus_t *)bus;
+}
+
+void osdp_vbus_destroy(osdp_vbus_t *vbus)
+{
+	int i;
+	struct osdp_vbus *bus = vbus;
+
+	if (bus == NULL) {
+		return;
+	}
+	if (osdp_virtual_clock == &bus->now_ms) {
+		osdp_virtual_clock = NULL;
+	}
+	for (i = 0; i < bus->num_nodes; i++) {
+		free(bus->nodes[i]);
+	}
+	free(bus);
+}
+
+int osdp_vbus_attach(osdp_vbus_t *vbus, struct osdp_channel *channel)
+{
+	struct osdp_vbus *bus = vbus;
+	struct vbus_node *node;
+
+	if (bus == NULL || channel == NULL ||
+	    bus->num_nodes == OSDP_VBUS_MAX_NODES) {
+		return -1;
+	}
+	node = calloc(1, sizeof(struct vbus_node));
+	if (node == NULL) {
+		return -1;
+	}
+	node->bus = bus;
+	node->id = bus->num_nodes;
+	node->attached = true;
+	bus->nodes[bus->num_nodes++] = node;
+
+	memset(channel, 0, sizeof(*channel));
+	channel->data = node;
+	channel->send = vbus_send;
+	channel->recv = vbus_recv;
+	channel->flush = vbus_flush;
+	channel->close = vbus_close;
+	return 0;
+}
+
+int osdp_vbus_advance(osdp_vbus_t *vbus, uint32_t us)
+{
+	int i, next, delivered = 0;
+	uint64_t t, next_t, end_ns;
+	struct osdp_vbus *bus = vbus;
+	struct vbus_frame *f;
+
+	end_ns = bus->now_ns + (uint64_t)us * 1000;
+	for (;;) {
+		/* the byte that leaves the wire next, across all frames */
+		next = -1;
+		next_t = end_ns;
+		for (i = 0; i < bus->num_frames; i++) {
+			f = &bus->frames[i];
+			t = f->start_ns + (f->pos + 1) * bus->byte_ns;
+			if (t <= next_t) {
+				next = i;
+				next_t = t;
+			}
+		}
+		if (next < 0) {
+			break;
+		}
+		f = &bus->frames[next];
+		vbus_set_time(bus, vbus_max(bus->now_ns, next_t));
+		vbus_deliver(bus, f->src, f->data[f->pos++]);
+		delivered++;
+		if (f->pos == f->len) {
+			bus->frames[next] = bus->frames[--bus->num_frames];
+		}
+	}
+	vbus_set_time(bus, end_ns);
+	return delivered;
+}
+
+int osdp_vbus_next_event_us(osdp_vbus_t *vbus)
+{
+	int i;
+	uint64_t t, end_ns = UINT64_MAX;
+	struct osdp_vbus *bus = vbus;
+	struct vbus_frame *f;
+
+	for (i = 0; i < bus->num_frames; i++) {
+		f = &bus->frames[i];
+		t = f->start_ns + f->len * bus->byte_ns;
+		if (t < end_ns) {
+			end_ns = t;
+		}
+	}
+	if (end_ns == UINT64_MAX) {
+		return -1;
+	}
+	if (end_ns <= bus->now_ns) {
+		return 0;
+	}
+	/* round up so that advancing by this much lands the whole frame */
+	return (int)((end_ns - bus->now_ns + 999) / 1000);
+}
+
+uint64_t osdp_vbus_now_us(osdp_vbus_t *vbus)
+{
+	struct osdp_vbus *bus = vbus;
+
+	return bus->now_ns / 1000;
+}
+
+void osdp_vbus_get_stats(osdp_vbus_t *vbus, struct osdp_vbus_stats *stats)
+{
+	struct osdp_vbus *bus = vbus;
+
+	*stats = bus->stats;
+}
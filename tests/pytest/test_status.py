@@ -133,15 +133,44 @@ def test_metrics_access_and_reset():
         "sc_failure_count",
         "command_count",
         "event_count",
+        "sc_sealed_count",
+        "sc_seal_cycles",
+        "sc_opened_count",
+        "sc_open_cycles",
+        "poll_count",
+        "poll_idle_count",
+        "poll_interval_ms",
+        "poll_rtt_ms",
+        "tx_bytes",
+        "rx_bytes",
+        "wire_time_us",
+        "bus_busy_ms",
+        "turnaround_hist",
+        "rtt_hist",
+        "event_drop_count",
+        "event_ring_hwm",
+        "cmd_packed_count",
+        "rx_discarded_bytes",
+        "packets_observed",
+        "probe_count",
+        "recover_count",
+        "recover_time_ms",
+        "sc_key_cache_hits",
+        "sc_key_cache_misses",
     }
     assert set(pd_metrics.keys()) == set(cp_metrics.keys())
 
     # The API provides interval metrics, so a second read after the first
     # snapshot should reset counters back toward zero.
+    # Cycle/time accumulators, the poll gauges and histograms are left out
+    # as they are not event counts.
+    def counts(m):
+        return sum(v for k, v in m.items()
+                   if k.endswith("_count") or k.startswith("packet"))
     next_cp_metrics = cp.get_metrics(pd_addr)
     next_pd_metrics = pd.get_metrics()
-    assert sum(next_cp_metrics.values()) <= sum(cp_metrics.values())
-    assert sum(next_pd_metrics.values()) <= sum(pd_metrics.values())
+    assert counts(next_cp_metrics) <= counts(cp_metrics)
+    assert counts(next_pd_metrics) <= counts(pd_metrics)
 
 def test_pd_info_default_baud_rate():
     info = PDInfo(101, f1, scbk=key).get()
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+static struct test *g_backoff_test;
+static int g_backoff_notif[2]; /* PD status notifications: offline, online */
+
+static int backoff_event_cb(void *arg, int pd, struct osdp_event *ev)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+
+	if (ev->type == OSDP_EVENT_NOTIFICATION &&
+	    ev->notif.type == OSDP_NOTIFICATION_PD_STATUS) {
+		g_backoff_notif[ev->notif.arg0 ? 1 : 0]++;
+	}
+	return 0;
+}
+
+/*
+ * Take an online PD off the bus for 2.5s and bring it back. The CP must
+ * probe it just once in the dark (first probe ~1s in, the next one at
+ * least 2s after that) and be back online with the PD at the second.
+ */
+static int test_cp_reconnect(void *data)
+{
+	int rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_metrics m;
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices(g_backoff_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	if (!test_run_devices(cp, pd, 10000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+	osdp_get_metrics(cp, 0, &m);
+
+	/* the PD goes dark */
+	make_request(osdp_to_pd(cp, 0), CP_REQ_OFFLINE);
+	test_run_devices(cp, NULL, 2500, NULL);
+	osdp_get_metrics(cp, 0, &m);
+	if (test_pd_online(cp) || m.probe_count != 1) {
+		printf(SUB_1 "%u probes while dark\n", m.probe_count);
+		goto out;
+	}
+
+	/* and comes back */
+	test_run_devices(cp, pd, 5000, test_pd_online);
+	osdp_get_metrics(cp, 0, &m);
+	printf(SUB_1 "recovered in %ums with %u more probe(s)\n",
+	       m.recover_time_ms, m.probe_count);
+	if (!test_pd_online(cp) || m.probe_count != 1 ||
+	    m.recover_count != 1 || m.recover_time_ms < 3000 ||
+	    m.recover_time_ms > 5000) {
+		printf(SUB_1 "bad recovery online:%d recover:%u\n",
+		       test_pd_online(cp), m.recover_count);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+/*
+ * A PD that answers every probe but then fails the handshake (here, SC
+ * with the wrong SCBK and ENFORCE_SECURE) is reported offline only once.
+ */
+static int test_cp_reconnect_notify_once(void *data)
+{
+	int rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_pd *p;
+	struct osdp_metrics m;
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices_ext(g_backoff_test, &cp, &pd,
+				   OSDP_FLAG_ENABLE_NOTIFICATION, 0)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	memset(g_backoff_notif, 0, sizeof(g_backoff_notif));
+	osdp_cp_set_event_callback(cp, backoff_event_cb, NULL);
+	if (!test_run_devices(cp, pd, 10000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	p = osdp_to_pd(cp, 0);
+	p->sc.scbk[0] ^= 0xff;
+	osdp_cp_modify_flag(cp, 0, OSDP_FLAG_ENFORCE_SECURE, true);
+	make_request(p, CP_REQ_OFFLINE);
+	test_run_devices(cp, pd, 4500, NULL);
+
+	osdp_get_metrics(cp, 0, &m);
+	if (test_pd_online(cp) || m.probe_count < 2 ||
+	    g_backoff_notif[0] != 1 || g_backoff_notif[1] != 1) {
+		printf(SUB_1 "online:%d probes:%u offline/online notifs:%d/%d\n",
+		       test_pd_online(cp), m.probe_count,
+		       g_backoff_notif[0], g_backoff_notif[1]);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_cp_backoff_tests(struct test *t)
+{
+	printf("\nCP reconnect backoff tests\n");
+
+	g_backoff_test = t;
+
+	DO_TEST(t, test_cp_reconnect);
+	DO_TEST(t, test_cp_reconnect_notify_once);
+}
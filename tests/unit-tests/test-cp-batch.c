@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+#define BATCH_NUM_PD    3
+#define BATCH_BUS_LEN   1024
+
+/*
+ * A multi-drop bus: whatever the CP sends reaches every PD; whatever a PD
+ * sends reaches the CP. Channel data is the PD offset, or -1 for the CP.
+ */
+struct batch_bus_buf {
+	uint8_t data[BATCH_BUS_LEN];
+	int len;
+};
+
+static struct batch_bus_buf g_bus_to_pd[BATCH_NUM_PD];
+static struct batch_bus_buf g_bus_to_cp;
+
+static struct test *g_batch_test;
+static int g_batch_rx_log[32]; /* (pd << 8) | cmd id, in arrival order */
+static int g_batch_rx_count;
+static int g_batch_completions, g_batch_last_pd, g_batch_last_status;
+
+static int bus_push(struct batch_bus_buf *b, const uint8_t *buf, int len)
+{
+	if (b->len + len > BATCH_BUS_LEN) {
+		len = BATCH_BUS_LEN - b->len;
+	}
+	memcpy(b->data + b->len, buf, len);
+	b->len += len;
+	return len;
+}
+
+static int bus_pop(struct batch_bus_buf *b, uint8_t *buf, int len)
+{
+	if (len > b->len) {
+		len = b->len;
+	}
+	memcpy(buf, b->data, len);
+	memmove(b->data, b->data + len, b->len - len);
+	b->len -= len;
+	return len;
+}
+
+static int bus_send(void *data, uint8_t *buf, int len)
+{
+	int i, idx = (int)(intptr_t)data;
+
+	if (idx >= 0) {
+		return bus_push(&g_bus_to_cp, buf, len);
+	}
+	for (i = 0; i < BATCH_NUM_PD; i++) {
+		bus_push(&g_bus_to_pd[i], buf, len);
+	}
+	return len;
+}
+
+static int bus_recv(void *data, uint8_t *buf, int len)
+{
+	int idx = (int)(intptr_t)data;
+
+	return bus_pop(idx >= 0 ? &g_bus_to_pd[idx] : &g_bus_to_cp, buf, len);
+}
+
+static int batch_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	if (g_batch_rx_count < (int)ARRAY_SIZEOF(g_batch_rx_log)) {
+		g_batch_rx_log[g_batch_rx_count] =
+			((int)(intptr_t)arg << 8) | cmd->id;
+	}
+	g_batch_rx_count++;
+	return 0;
+}
+
+static void batch_completion_cb(void *arg, int pd, const struct osdp_cmd *cmd,
+				enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(cmd);
+
+	g_batch_completions++;
+	g_batch_last_pd = pd;
+	g_batch_last_status = status;
+}
+
+static void batch_run(osdp_t *cp, osdp_t **pd, int ms)
+{
+	int i;
+	tick_t start = osdp_millis_now();
+
+	while (osdp_millis_since(start) < (tick_t)ms) {
+		osdp_cp_refresh(cp);
+		for (i = 0; i < BATCH_NUM_PD; i++) {
+			osdp_pd_refresh(pd[i]);
+		}
+		usleep(1000);
+	}
+}
+
+static bool batch_all_online(osdp_t *cp)
+{
+	uint8_t status = 0;
+
+	osdp_get_status_mask(cp, &status);
+	return status == (1 << BATCH_NUM_PD) - 1;
+}
+
+static int test_cp_submit_commands(void *data)
+{
+	int i, rc = -1, pd2_led, pd2_first, pd0_buz;
+	osdp_t *cp = NULL, *pd[BATCH_NUM_PD] = { NULL };
+	osdp_pd_info_t cp_info[BATCH_NUM_PD];
+	struct osdp_channel cp_ch = {
+		.data = (void *)(intptr_t)-1,
+		.send = bus_send,
+		.recv = bus_recv,
+	};
+	struct osdp_pd_cap cap[] = {
+		{ OSDP_PD_CAP_READER_AUDIBLE_OUTPUT, 1, 1 },
+		{ OSDP_PD_CAP_READER_LED_CONTROL, 1, 1 },
+		{ -1, -1, -1 }
+	};
+	struct osdp_cmd cmds[2] = {
+		{
+			.id = OSDP_CMD_LED,
+			.led = {
+				.led_number = 0,
+				.permanent = {
+					.control_code = 1,
+					.on_count = 10,
+					.off_count = 10,
+					.on_color = OSDP_LED_COLOR_RED,
+					.off_color = OSDP_LED_COLOR_NONE,
+				},
+			},
+		},
+		{
+			.id = OSDP_CMD_BUZZER,
+			.buzzer = {
+				.control_code = 2,
+				.on_count = 1,
+				.off_count = 1,
+				.rep_count = 1,
+			},
+		},
+	};
+	struct osdp_cmd ind[2];
+	uint8_t mask = (1 << 0) | (1 << 2);
+	uint8_t offline_mask = 1 << BATCH_NUM_PD;
+
+	ARG_UNUSED(data);
+
+	memset(g_bus_to_pd, 0, sizeof(g_bus_to_pd));
+	memset(&g_bus_to_cp, 0, sizeof(g_bus_to_cp));
+	g_batch_rx_count = g_batch_completions = 0;
+
+	for (i = 0; i < BATCH_NUM_PD; i++) {
+		struct osdp_channel ch = {
+			.data = (void *)(intptr_t)i,
+			.send = bus_send,
+			.recv = bus_recv,
+		};
+		osdp_pd_info_t info = {
+			.address = 101 + i,
+			.baud_rate = 9600,
+			.cap = cap,
+		};
+
+		cp_info[i] = (osdp_pd_info_t) {
+			.address = 101 + i,
+			.baud_rate = 9600,
+		};
+		pd[i] = osdp_pd_setup(&ch, &info);
+		if (pd[i] == NULL) {
+			printf(SUB_1 "PD setup failed\n");
+			goto out;
+		}
+		osdp_pd_set_command_callback(pd[i], batch_pd_command_cb,
+					     (void *)(intptr_t)i);
+	}
+	osdp_logger_init("osdp", g_batch_test->loglevel, NULL);
+	cp = osdp_cp_setup(&cp_ch, BATCH_NUM_PD, cp_info);
+	if (cp == NULL) {
+		printf(SUB_1 "CP setup failed\n");
+		goto out;
+	}
+	osdp_cp_set_command_completion_callback(cp, batch_completion_cb, NULL);
+
+	for (i = 0; i < 1000 && !batch_all_online(cp); i++) {
+		batch_run(cp, pd, 10);
+	}
+	if (!batch_all_online(cp)) {
+		printf(SUB_1 "PDs did not come online\n");
+		goto out;
+	}
+
+	if (osdp_cp_submit_commands(cp, &offline_mask, cmds, 2) == 0 ||
+	    osdp_cp_submit_commands(cp, &mask, cmds, 0) == 0) {
+		printf(SUB_1 "invalid batch accepted\n");
+		goto out;
+	}
+	if (osdp_cp_submit_commands(cp, &mask, cmds, 2) ||
+	    osdp_cp_submit_commands(cp, &mask, cmds, 2) == 0) {
+		printf(SUB_1 "batch accept/busy check failed\n");
+		goto out;
+	}
+	batch_run(cp, pd, 1000);
+
+	if (g_batch_completions != 1 || g_batch_last_pd != OSDP_CP_BATCH_PD ||
+	    g_batch_last_status != OSDP_COMPLETION_OK) {
+		printf(SUB_1 "completions:%d pd:%d status:%d\n",
+		       g_batch_completions, g_batch_last_pd,
+		       g_batch_last_status);
+		goto out;
+	}
+	/*
+	 * The first entry reaches both PDs before the second goes to either;
+	 * which PD is first depends on where the round-robin stood.
+	 */
+	if (g_batch_rx_count != 4 ||
+	    (g_batch_rx_log[0] & 0xff) != OSDP_CMD_LED ||
+	    (g_batch_rx_log[1] & 0xff) != OSDP_CMD_LED ||
+	    (g_batch_rx_log[0] >> 8) == (g_batch_rx_log[1] >> 8) ||
+	    (g_batch_rx_log[2] & 0xff) != OSDP_CMD_BUZZER ||
+	    (g_batch_rx_log[3] & 0xff) != OSDP_CMD_BUZZER ||
+	    (g_batch_rx_log[2] >> 8) == (g_batch_rx_log[3] >> 8) ||
+	    (g_batch_rx_log[0] >> 8) == 1 || (g_batch_rx_log[1] >> 8) == 1) {
+		printf(SUB_1 "unexpected delivery (%d commands):",
+		       g_batch_rx_count);
+		for (i = 0; i < g_batch_rx_count && i < 8; i++) {
+			printf(" %04x", g_batch_rx_log[i]);
+		}
+		printf("\n");
+		goto out;
+	}
+
+	/* the slot is free again */
+	if (osdp_cp_submit_commands(cp, &mask, cmds, 1)) {
+		printf(SUB_1 "second batch rejected\n");
+		goto out;
+	}
+	batch_run(cp, pd, 500);
+	if (g_batch_completions != 2 || g_batch_rx_count != 6) {
+		printf(SUB_1 "second batch: completions:%d commands:%d\n",
+		       g_batch_completions, g_batch_rx_count);
+		goto out;
+	}
+
+	/*
+	 * PD-2 has its own commands queued ahead of the batch; PD-0 must not
+	 * get the second entry until PD-2 has had the first.
+	 */
+	g_batch_rx_count = 0;
+	ind[0] = ind[1] = cmds[0];
+	if (osdp_cp_submit_command(cp, 2, &ind[0]) ||
+	    osdp_cp_submit_command(cp, 2, &ind[1]) ||
+	    osdp_cp_submit_commands(cp, &mask, cmds, 2)) {
+		printf(SUB_1 "third batch rejected\n");
+		goto out;
+	}
+	batch_run(cp, pd, 1000);
+	for (i = 0, pd2_led = 0, pd0_buz = -1, pd2_first = -1;
+	     i < g_batch_rx_count && i < (int)ARRAY_SIZEOF(g_batch_rx_log);
+	     i++) {
+		if (g_batch_rx_log[i] == ((2 << 8) | OSDP_CMD_LED) &&
+		    ++pd2_led == 3) {
+			pd2_first = i;
+		}
+		if (g_batch_rx_log[i] == ((0 << 8) | OSDP_CMD_BUZZER)) {
+			pd0_buz = i;
+		}
+	}
+	if (g_batch_rx_count != 6 || pd2_first < 0 || pd0_buz < pd2_first) {
+		printf(SUB_1 "third batch: commands:%d PD-2 entry 0 at %d, "
+		       "PD-0 entry 1 at %d\n", g_batch_rx_count, pd2_first,
+		       pd0_buz);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	for (i = 0; i < BATCH_NUM_PD; i++) {
+		osdp_pd_teardown(pd[i]);
+	}
+	return rc;
+}
+
+void run_cp_batch_tests(struct test *t)
+{
+	printf("\nCP batch submission tests\n");
+
+	g_batch_test = t;
+
+	DO_TEST(t, test_cp_submit_commands);
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <osdp.h>
+#include "test.h"
+
+/*
+ * Several threads submit commands to one PD while the main thread keeps
+ * refreshing. Build with -fsanitize=thread to check the submission path for
+ * data races.
+ */
+
+#define MPSC_PRODUCERS   4
+#define MPSC_CMDS        64  /* per producer; sequence + 1 goes in on_count */
+
+struct mpsc_producer {
+	osdp_t *cp;
+	int idx;
+	int rejected;
+	pthread_t thread;
+	struct osdp_cmd cmd[MPSC_CMDS];
+};
+
+static struct test *g_mpsc_test;
+static struct mpsc_producer g_mpsc_prod[MPSC_PRODUCERS];
+static int g_mpsc_go;
+
+/* touched only from the refresh thread */
+static int g_mpsc_completed, g_mpsc_failed;
+static int g_mpsc_received, g_mpsc_out_of_order;
+static int g_mpsc_next_seq[MPSC_PRODUCERS];
+
+static int mpsc_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	int idx;
+
+	ARG_UNUSED(arg);
+
+	if (cmd->id != OSDP_CMD_BUZZER) {
+		return 0;
+	}
+	idx = cmd->buzzer.off_count;
+	if (idx >= MPSC_PRODUCERS ||
+	    cmd->buzzer.on_count != g_mpsc_next_seq[idx] + 1) {
+		g_mpsc_out_of_order++;
+	} else {
+		g_mpsc_next_seq[idx]++;
+	}
+	g_mpsc_received++;
+	return 0;
+}
+
+static void mpsc_completion_cb(void *arg, int pd, const struct osdp_cmd *cmd,
+			       enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(cmd);
+
+	if (status == OSDP_COMPLETION_OK) {
+		g_mpsc_completed++;
+	} else {
+		g_mpsc_failed++;
+	}
+}
+
+static void *mpsc_producer_fn(void *arg)
+{
+	int i;
+	struct mpsc_producer *p = arg;
+
+	while (!__atomic_load_n(&g_mpsc_go, __ATOMIC_ACQUIRE)) {
+		sched_yield();
+	}
+	for (i = 0; i < MPSC_CMDS; i++) {
+		p->cmd[i] = (struct osdp_cmd) {
+			.id = OSDP_CMD_BUZZER,
+			.buzzer = {
+				.reader = 0,
+				.control_code = 2,
+				.on_count = i + 1, /* must be non-zero */
+				.off_count = p->idx,
+				.rep_count = 1,
+			},
+		};
+		if (osdp_cp_submit_command(p->cp, 0, &p->cmd[i])) {
+			p->rejected++;
+		}
+		if ((i & 7) == 0) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static bool mpsc_all_done(osdp_t *cp)
+{
+	ARG_UNUSED(cp);
+	return g_mpsc_completed + g_mpsc_failed ==
+	       MPSC_PRODUCERS * MPSC_CMDS;
+}
+
+static int test_cp_mpsc_submit(void *data)
+{
+	int i, rc = -1, started = 0;
+	osdp_t *cp = NULL, *pd = NULL;
+
+	ARG_UNUSED(data);
+
+	g_mpsc_go = 0;
+	g_mpsc_completed = g_mpsc_failed = 0;
+	g_mpsc_received = g_mpsc_out_of_order = 0;
+	memset(g_mpsc_next_seq, 0, sizeof(g_mpsc_next_seq));
+
+	if (test_setup_devices(g_mpsc_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_pd_set_command_callback(pd, mpsc_pd_command_cb, NULL);
+	osdp_cp_set_command_completion_callback(cp, mpsc_completion_cb, NULL);
+	if (!test_run_devices(cp, pd, 10 * 1000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	for (i = 0; i < MPSC_PRODUCERS; i++) {
+		memset(&g_mpsc_prod[i], 0, sizeof(g_mpsc_prod[i]));
+		g_mpsc_prod[i].cp = cp;
+		g_mpsc_prod[i].idx = i;
+		if (pthread_create(&g_mpsc_prod[i].thread, NULL,
+				   mpsc_producer_fn, &g_mpsc_prod[i])) {
+			printf(SUB_1 "pthread_create failed\n");
+			break;
+		}
+		started++;
+	}
+	__atomic_store_n(&g_mpsc_go, 1, __ATOMIC_RELEASE);
+
+	/* keep refreshing while the producers are still pushing */
+	test_run_devices(cp, pd, 30 * 1000, mpsc_all_done);
+	for (i = 0; i < started; i++) {
+		pthread_join(g_mpsc_prod[i].thread, NULL);
+		if (g_mpsc_prod[i].rejected) {
+			printf(SUB_1 "producer %d: %d submissions rejected\n",
+			       i, g_mpsc_prod[i].rejected);
+			goto out;
+		}
+	}
+	if (started != MPSC_PRODUCERS) {
+		goto out;
+	}
+
+	if (!mpsc_all_done(cp) || g_mpsc_failed) {
+		printf(SUB_1 "completions ok:%d failed:%d of %d\n",
+		       g_mpsc_completed, g_mpsc_failed,
+		       MPSC_PRODUCERS * MPSC_CMDS);
+		goto out;
+	}
+	if (g_mpsc_received != MPSC_PRODUCERS * MPSC_CMDS ||
+	    g_mpsc_out_of_order) {
+		printf(SUB_1 "PD received %d commands, %d out of order\n",
+		       g_mpsc_received, g_mpsc_out_of_order);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_cp_mpsc_tests(struct test *t)
+{
+	printf("\nCP multi-producer submission tests\n");
+
+	g_mpsc_test = t;
+
+	DO_TEST(t, test_cp_mpsc_submit);
+}
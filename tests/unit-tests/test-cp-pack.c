@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+#define PACK_LEDS       5
+#define PACK_MAX        4
+
+static struct test *g_pack_test;
+static int g_pack_rx[16]; /* cmd id, in arrival order */
+static int g_pack_rx_seq[16]; /* permanent.on_count of LED commands */
+static int g_pack_rx_count, g_pack_ok, g_pack_failed;
+
+static int pack_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+
+	if (g_pack_rx_count < (int)ARRAY_SIZEOF(g_pack_rx)) {
+		g_pack_rx[g_pack_rx_count] = cmd->id;
+		g_pack_rx_seq[g_pack_rx_count] = cmd->led.permanent.on_count;
+	}
+	g_pack_rx_count++;
+	return 0;
+}
+
+static void pack_completion_cb(void *arg, int pd, const struct osdp_cmd *cmd,
+			       enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(cmd);
+
+	if (status == OSDP_COMPLETION_OK) {
+		g_pack_ok++;
+	} else {
+		g_pack_failed++;
+	}
+}
+
+static int test_cp_command_packing(void *data)
+{
+	int i, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_metrics before, after;
+	struct osdp_cmd cmds[PACK_LEDS + 1];
+
+	ARG_UNUSED(data);
+
+	g_pack_rx_count = g_pack_ok = g_pack_failed = 0;
+	if (test_setup_devices(g_pack_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_pd_set_command_callback(pd, pack_pd_command_cb, NULL);
+	osdp_cp_set_command_completion_callback(cp, pack_completion_cb, NULL);
+	if (!test_run_devices(cp, pd, 10000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	if (osdp_cp_set_command_packing(cp, 0, -1) == 0 ||
+	    osdp_cp_set_command_packing(cp, 1, PACK_MAX) == 0 ||
+	    osdp_cp_set_command_packing(cp, 0, PACK_MAX)) {
+		printf(SUB_1 "packing argument checks failed\n");
+		goto out;
+	}
+
+	for (i = 0; i < PACK_LEDS; i++) {
+		cmds[i] = (struct osdp_cmd) {
+			.id = OSDP_CMD_LED,
+			.led = {
+				.permanent = {
+					.control_code = 1,
+					.on_count = i + 1, /* tells them apart */
+					.off_count = 10,
+					.on_color = OSDP_LED_COLOR_GREEN,
+				},
+			},
+		};
+	}
+	cmds[PACK_LEDS] = (struct osdp_cmd) {
+		.id = OSDP_CMD_BUZZER,
+		.buzzer = {
+			.control_code = 2,
+			.on_count = 1,
+			.off_count = 1,
+			.rep_count = 1,
+		},
+	};
+
+	osdp_get_metrics(cp, 0, &before);
+	for (i = 0; i < PACK_LEDS + 1; i++) {
+		if (osdp_cp_submit_command(cp, 0, &cmds[i])) {
+			printf(SUB_1 "submit %d failed\n", i);
+			goto out;
+		}
+	}
+	test_run_devices(cp, pd, 1000, NULL);
+	osdp_get_metrics(cp, 0, &after);
+
+	/* 4 LEDs in one turn, the 5th on its own, then the buzzer */
+	if (g_pack_ok != PACK_LEDS + 1 || g_pack_failed ||
+	    after.cmd_packed_count - before.cmd_packed_count != PACK_MAX - 1) {
+		printf(SUB_1 "completions ok:%d failed:%d packed:%u\n",
+		       g_pack_ok, g_pack_failed,
+		       after.cmd_packed_count - before.cmd_packed_count);
+		goto out;
+	}
+	if (g_pack_rx_count != PACK_LEDS + 1 ||
+	    g_pack_rx[PACK_LEDS] != OSDP_CMD_BUZZER) {
+		printf(SUB_1 "PD received %d commands\n", g_pack_rx_count);
+		goto out;
+	}
+	for (i = 0; i < PACK_LEDS; i++) {
+		if (g_pack_rx[i] != OSDP_CMD_LED || g_pack_rx_seq[i] != i + 1) {
+			printf(SUB_1 "LED %d out of order\n", i);
+			goto out;
+		}
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_cp_pack_tests(struct test *t)
+{
+	printf("\nCP command packing tests\n");
+
+	g_pack_test = t;
+
+	DO_TEST(t, test_cp_command_packing);
+}
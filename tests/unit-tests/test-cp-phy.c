@@ -520,6 +520,55 @@ static int test_phy_parse_hardcoded_plaintext_when_sc_active_reject(struct osdp
 	return 0;
 }
 
+/*
+ * SCS_17/18 frames with a valid CRC whose secure block length, MAC or
+ * cipher text don't fit the packet must be refused before any of it is
+ * run through the MAC or the cipher.
+ */
+static int test_phy_decode_sc_truncated_reject(struct osdp *ctx)
+{
+	int i, len, err;
+	uint8_t *buf, pkt[64];
+	struct osdp_pd *p = GET_CURRENT_PD(ctx);
+	static const struct {
+		const char *name;
+		uint8_t data[16];
+		int len;
+	} cases[] = {
+		{ "no reply ID", { 0x02, 0x18, 0, 0, 0, 0 }, 6 },
+		{ "short MAC", { 0x02, 0x17, 0x40, 0, 0 }, 5 },
+		{ "SCB past the packet", { 0x7f, 0x18, 0x40, 0, 0, 0, 0 }, 7 },
+		{ "SCB under 2 bytes", { 0x01, 0x18, 0x40, 0, 0, 0, 0 }, 7 },
+		{ "unaligned data", { 0x02, 0x18, 0x40, 1, 2, 3, 4, 5,
+				      0, 0, 0, 0 }, 12 },
+	};
+
+	printf(SUB_1 "Testing truncated SCS_17/SCS_18 packets -- ");
+	for (i = 0; i < (int)ARRAY_SIZEOF(cases); i++) {
+		reset_pd_packet_state(p);
+		sc_activate(p);
+		SET_FLAG(p, PD_FLAG_SKIP_SEQ_CHECK);
+		len = test_osdp_create_packet(0xe5, 0x0C, (uint8_t *)cases[i].data,
+					      cases[i].len, pkt, sizeof(pkt));
+		osdp_rb_push_buf(p->rx_rb, pkt, len);
+		err = osdp_phy_check_packet(p);
+		if (err == OSDP_ERR_PKT_NONE) {
+			p->nak_code = 0;
+			err = osdp_phy_decode_packet(p, &buf);
+		}
+		sc_deactivate(p);
+		CLEAR_FLAG(p, PD_FLAG_SKIP_SEQ_CHECK);
+		if (err != OSDP_ERR_PKT_NACK ||
+		    p->nak_code != OSDP_PD_NAK_SC_COND) {
+			printf("failed! %s: decode returned %d nak=%d\n",
+			       cases[i].name, err, p->nak_code);
+			return -1;
+		}
+	}
+	printf("success!\n");
+	return 0;
+}
+
 int test_phy_decode_packet_ignore_leading_mark_bytes(struct osdp *ctx)
 {
 	uint8_t *buf;
@@ -1481,6 +1530,7 @@ void run_cp_phy_tests(struct test *t)
 	DO_TEST(t, test_phy_parse_hardcoded_sc_inactive_scs16_reject);
 	DO_TEST(t, test_phy_parse_hardcoded_sc_active_invalid_mac_reject);
 	DO_TEST(t, test_phy_parse_hardcoded_plaintext_when_sc_active_reject);
+	DO_TEST(t, test_phy_decode_sc_truncated_reject);
 	DO_TEST(t, test_phy_build_packet_without_mark);
 	DO_TEST(t, test_phy_packet_multiple_commands);
 	DO_TEST(t, test_phy_decode_packet_ack);
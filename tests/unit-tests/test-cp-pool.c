@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test.h"
+
+#ifdef OPT_OSDP_CP_POOL
+
+#include <pthread.h>
+#include <time.h>
+
+#define POOL_NUM_BUS 3
+#define POOL_FIFO_LEN 1024
+
+/* thread-safe byte FIFO; the pool's workers and the test thread share it */
+struct pool_fifo {
+	pthread_mutex_t lock;
+	uint8_t buf[POOL_FIFO_LEN];
+	int head;
+	int tail;
+};
+
+struct pool_bus_mock {
+	struct pool_fifo cp_to_pd;
+	struct pool_fifo pd_to_cp;
+	osdp_t *pd_ctx;
+};
+
+static struct pool_bus_mock g_bus[POOL_NUM_BUS];
+
+static int g_completions[POOL_NUM_BUS][OSDP_COMPLETION_ABORTED + 1];
+static bool g_online[POOL_NUM_BUS];
+
+static int pool_fifo_push(struct pool_fifo *f, const uint8_t *buf, int len)
+{
+	int i;
+
+	pthread_mutex_lock(&f->lock);
+	for (i = 0; i < len; i++) {
+		if ((f->head + 1) % POOL_FIFO_LEN == f->tail) {
+			break;
+		}
+		f->buf[f->head] = buf[i];
+		f->head = (f->head + 1) % POOL_FIFO_LEN;
+	}
+	pthread_mutex_unlock(&f->lock);
+	return i;
+}
+
+static int pool_fifo_pop(struct pool_fifo *f, uint8_t *buf, int len)
+{
+	int i;
+
+	pthread_mutex_lock(&f->lock);
+	for (i = 0; i < len && f->tail != f->head; i++) {
+		buf[i] = f->buf[f->tail];
+		f->tail = (f->tail + 1) % POOL_FIFO_LEN;
+	}
+	pthread_mutex_unlock(&f->lock);
+	return i;
+}
+
+static void pool_fifo_flush(struct pool_fifo *f)
+{
+	pthread_mutex_lock(&f->lock);
+	f->head = f->tail = 0;
+	pthread_mutex_unlock(&f->lock);
+}
+
+static int pool_cp_send(void *data, uint8_t *buf, int len)
+{
+	return pool_fifo_push(&((struct pool_bus_mock *)data)->cp_to_pd, buf, len);
+}
+
+static int pool_cp_recv(void *data, uint8_t *buf, int len)
+{
+	return pool_fifo_pop(&((struct pool_bus_mock *)data)->pd_to_cp, buf, len);
+}
+
+static void pool_cp_flush(void *data)
+{
+	pool_fifo_flush(&((struct pool_bus_mock *)data)->pd_to_cp);
+}
+
+static int pool_pd_send(void *data, uint8_t *buf, int len)
+{
+	return pool_fifo_push(&((struct pool_bus_mock *)data)->pd_to_cp, buf, len);
+}
+
+static int pool_pd_recv(void *data, uint8_t *buf, int len)
+{
+	return pool_fifo_pop(&((struct pool_bus_mock *)data)->cp_to_pd, buf, len);
+}
+
+static void pool_pd_flush(void *data)
+{
+	pool_fifo_flush(&((struct pool_bus_mock *)data)->cp_to_pd);
+}
+
+static int pool_event_cb(void *arg, int bus, int pd, struct osdp_event *ev)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+
+	if (bus >= 0 && bus < POOL_NUM_BUS &&
+	    ev->type == OSDP_EVENT_NOTIFICATION &&
+	    ev->notif.type == OSDP_NOTIFICATION_PD_STATUS) {
+		g_online[bus] = ev->notif.arg0 == 1;
+	}
+	return 0;
+}
+
+static void pool_completion_cb(void *arg, int bus, int pd,
+			       const struct osdp_cmd *cmd,
+			       enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(cmd);
+
+	if (bus >= 0 && bus < POOL_NUM_BUS &&
+	    status <= OSDP_COMPLETION_ABORTED) {
+		g_completions[bus][status]++;
+	}
+}
+
+static int pool_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(cmd);
+	return 0;
+}
+
+static int pool_setup_pds(void)
+{
+	int i;
+	struct osdp_pd_cap cap[] = {
+		{ OSDP_PD_CAP_READER_AUDIBLE_OUTPUT, 1, 1 },
+		{ -1, -1, -1 }
+	};
+	struct osdp_channel ch = {
+		.send = pool_pd_send,
+		.recv = pool_pd_recv,
+		.flush = pool_pd_flush,
+	};
+	osdp_pd_info_t info = {
+		.address = 101,
+		.baud_rate = 9600,
+		.id = {
+			.version = 1,
+			.model = 153,
+			.vendor_code = 31337,
+		},
+		.cap = cap,
+	};
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		pthread_mutex_init(&g_bus[i].cp_to_pd.lock, NULL);
+		pthread_mutex_init(&g_bus[i].pd_to_cp.lock, NULL);
+		ch.data = &g_bus[i];
+		info.id.serial_number = 0x1000 + i;
+		g_bus[i].pd_ctx = osdp_pd_setup(&ch, &info);
+		if (g_bus[i].pd_ctx == NULL) {
+			return -1;
+		}
+		osdp_pd_set_command_callback(g_bus[i].pd_ctx,
+					     pool_pd_command_cb, NULL);
+	}
+	return 0;
+}
+
+static void pool_teardown_pds(void)
+{
+	int i;
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		osdp_pd_teardown(g_bus[i].pd_ctx);
+		g_bus[i].pd_ctx = NULL;
+		pthread_mutex_destroy(&g_bus[i].cp_to_pd.lock);
+		pthread_mutex_destroy(&g_bus[i].pd_to_cp.lock);
+	}
+}
+
+/* drive the PDs from this thread until @cond holds or 10s pass */
+static bool pool_run_until(osdp_cp_pool_t *pool, bool (*cond)(void))
+{
+	int i;
+	time_t start = time(NULL);
+
+	do {
+		for (i = 0; i < POOL_NUM_BUS; i++) {
+			osdp_pd_refresh(g_bus[i].pd_ctx);
+		}
+		osdp_cp_pool_dispatch(pool, 5);
+		if (cond()) {
+			return true;
+		}
+	} while (time(NULL) - start < 10);
+
+	return false;
+}
+
+static bool pool_all_online(void)
+{
+	int i;
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		if (!g_online[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool pool_all_completed(void)
+{
+	int i;
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		if (g_completions[i][OSDP_COMPLETION_OK] == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int test_cp_pool_roundtrip(void *data)
+{
+	int i, j, done, rc = -1;
+	uint8_t mask;
+	osdp_t *ctx;
+	osdp_cp_pool_t *pool;
+	struct osdp_channel ch[POOL_NUM_BUS];
+	struct osdp_cp_bus_info bus[POOL_NUM_BUS];
+	osdp_pd_info_t info = {
+		.address = 101,
+		.baud_rate = 9600,
+		.flags = OSDP_FLAG_ENABLE_NOTIFICATION,
+	};
+	struct osdp_cmd cmd[POOL_NUM_BUS + 1], buz = {
+		.id = OSDP_CMD_BUZZER,
+		.buzzer = {
+			.control_code = 1,
+			.on_count = 10,
+			.off_count = 10,
+			.rep_count = 1,
+		},
+	};
+
+	ARG_UNUSED(data);
+
+	/* commands are queued by reference; each needs its own storage */
+	for (i = 0; i <= POOL_NUM_BUS; i++) {
+		cmd[i] = buz;
+	}
+	memset(g_completions, 0, sizeof(g_completions));
+	memset(g_online, 0, sizeof(g_online));
+	if (pool_setup_pds()) {
+		printf(SUB_1 "pd setup failed\n");
+		goto out;
+	}
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		ch[i] = (struct osdp_channel) {
+			.data = &g_bus[i],
+			.send = pool_cp_send,
+			.recv = pool_cp_recv,
+			.flush = pool_cp_flush,
+		};
+		bus[i].channel = &ch[i];
+		bus[i].num_pd = 1;
+		bus[i].info = &info;
+	}
+
+	/* fewer workers than buses so that one thread owns two of them */
+	pool = osdp_cp_pool_setup(POOL_NUM_BUS, bus, 2);
+	if (pool == NULL) {
+		printf(SUB_1 "pool setup failed\n");
+		goto out;
+	}
+	osdp_cp_pool_set_event_callback(pool, pool_event_cb, NULL);
+	osdp_cp_pool_set_command_completion_callback(pool, pool_completion_cb,
+						     NULL);
+
+	if (!pool_run_until(pool, pool_all_online)) {
+		printf(SUB_1 "not all buses came online\n");
+		osdp_cp_pool_teardown(pool);
+		goto out;
+	}
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		mask = 0;
+		ctx = osdp_cp_pool_get_ctx(pool, i);
+		osdp_get_status_mask(ctx, &mask);
+		osdp_cp_pool_put_ctx(pool, i);
+		if (mask != 1) {
+			printf(SUB_1 "bus-%d status mask %02x\n", i, mask);
+			osdp_cp_pool_teardown(pool);
+			goto out;
+		}
+	}
+
+	for (i = 0; i < POOL_NUM_BUS; i++) {
+		if (osdp_cp_pool_submit_command(pool, i, 0, &cmd[i])) {
+			printf(SUB_1 "submit to bus-%d failed\n", i);
+			osdp_cp_pool_teardown(pool);
+			goto out;
+		}
+	}
+	if (osdp_cp_pool_submit_command(pool, POOL_NUM_BUS, 0, &buz) == 0) {
+		printf(SUB_1 "submit to invalid bus succeeded\n");
+		osdp_cp_pool_teardown(pool);
+		goto out;
+	}
+
+	if (!pool_run_until(pool, pool_all_completed)) {
+		printf(SUB_1 "commands did not complete on all buses\n");
+		osdp_cp_pool_teardown(pool);
+		goto out;
+	}
+
+	/* anything left queued must come back through teardown */
+	osdp_cp_pool_submit_command(pool, 1, 0, &cmd[POOL_NUM_BUS]);
+	osdp_cp_pool_teardown(pool);
+
+	for (i = 0, done = 0; i < POOL_NUM_BUS; i++) {
+		for (j = 0; j <= OSDP_COMPLETION_ABORTED; j++) {
+			done += g_completions[i][j];
+		}
+	}
+	if (done != POOL_NUM_BUS + 1) {
+		printf(SUB_1 "expected %d completions, got %d\n",
+		       POOL_NUM_BUS + 1, done);
+		goto out;
+	}
+	rc = 0;
+out:
+	pool_teardown_pds();
+	return rc;
+}
+
+void run_cp_pool_tests(struct test *t)
+{
+	printf("\nCP pool tests\n");
+
+	DO_TEST(t, test_cp_pool_roundtrip);
+}
+
+#else
+
+void run_cp_pool_tests(struct test *t)
+{
+	ARG_UNUSED(t);
+	printf("\nCP pool tests skipped (OPT_OSDP_CP_POOL not enabled)\n");
+}
+
+#endif /* OPT_OSDP_CP_POOL */
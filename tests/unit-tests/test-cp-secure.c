@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+static struct test *g_secure_test;
+
+static void secure_run_until(osdp_t *cp, osdp_t *pd, bool secure, int ms)
+{
+	tick_t start = osdp_millis_now();
+
+	while (osdp_millis_since(start) < (tick_t)ms &&
+	       (osdp_cp_get_time_to_secure(cp) >= 0) != secure) {
+		osdp_cp_refresh(cp);
+		osdp_pd_refresh(pd);
+		usleep(1000);
+	}
+}
+
+static int test_cp_time_to_secure(void *data)
+{
+	int ms, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	uint8_t sc_mask = 0;
+	tick_t start = osdp_millis_now();
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices(g_secure_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	if (osdp_cp_get_time_to_secure(cp) != -1) {
+		printf(SUB_1 "secure before the first exchange\n");
+		goto out;
+	}
+	secure_run_until(cp, pd, true, 10000);
+	ms = osdp_cp_get_time_to_secure(cp);
+	osdp_get_sc_status_mask(cp, &sc_mask);
+	printf(SUB_1 "all secure in %dms\n", ms);
+	if (ms < 0 || ms > (int)osdp_millis_since(start) || !(sc_mask & 1)) {
+		printf(SUB_1 "bad time to secure %d (sc:%d)\n", ms, sc_mask);
+		goto out;
+	}
+
+	/* losing SC restarts the clock; it stops again once SC is back */
+	make_request(osdp_to_pd(cp, 0), CP_REQ_OFFLINE);
+	secure_run_until(cp, pd, false, 1000);
+	if (osdp_cp_get_time_to_secure(cp) != -1) {
+		printf(SUB_1 "clock not restarted on SC loss\n");
+		goto out;
+	}
+	secure_run_until(cp, pd, true, 10000);
+	ms = osdp_cp_get_time_to_secure(cp);
+	printf(SUB_1 "secure again in %dms\n", ms);
+	if (ms < 0) {
+		printf(SUB_1 "SC did not come back\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+/*
+ * The SCBK schedule is expanded for the first handshake only; later ones
+ * with the same SCBK, on both sides, must be served from the cache.
+ */
+static int test_sc_key_cache(void *data)
+{
+	int i, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_metrics cm, pm;
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices(g_secure_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	for (i = 0; i < 3; i++) {
+		if (i) {
+			make_request(osdp_to_pd(cp, 0), CP_REQ_OFFLINE);
+			secure_run_until(cp, pd, false, 1000);
+		}
+		secure_run_until(cp, pd, true, 10000);
+		if (osdp_cp_get_time_to_secure(cp) < 0) {
+			printf(SUB_1 "SC session %d not established\n", i);
+			goto out;
+		}
+	}
+	osdp_get_metrics(cp, 0, &cm);
+	osdp_get_metrics(pd, 0, &pm);
+	printf(SUB_1 "cp hits:%u misses:%u; pd hits:%u misses:%u\n",
+	       cm.sc_key_cache_hits, cm.sc_key_cache_misses,
+	       pm.sc_key_cache_hits, pm.sc_key_cache_misses);
+	if (cm.sc_key_cache_misses != 1 || cm.sc_key_cache_hits < 2 ||
+	    pm.sc_key_cache_misses != 1 || pm.sc_key_cache_hits < 2) {
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+/*
+ * A PD in install mode that does not know the CP's SCBK must still come up
+ * secure; the CP retries the handshake with SCBK-D after the SCBK one fails.
+ */
+static int test_cp_scbkd_fallback(void *data)
+{
+	int rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_pd *p;
+	tick_t start = osdp_millis_now();
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices_ext(g_secure_test, &cp, &pd, 0,
+				   OSDP_FLAG_INSTALL_MODE)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	p = osdp_to_pd(cp, 0);
+	p->sc.scbk[0] ^= 0xff;
+
+	while (osdp_millis_since(start) < 10000 &&
+	       !(sc_is_active(p) && sc_use_scbkd(p))) {
+		osdp_cp_refresh(cp);
+		osdp_pd_refresh(pd);
+		usleep(1000);
+	}
+	if (!sc_is_active(p) || !sc_use_scbkd(p)) {
+		printf(SUB_1 "no SC with SCBK-D (sc:%d scbkd:%d)\n",
+		       sc_is_active(p), sc_use_scbkd(p));
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_cp_secure_tests(struct test *t)
+{
+	printf("\nCP secure channel startup tests\n");
+
+	g_secure_test = t;
+
+	DO_TEST(t, test_cp_time_to_secure);
+	DO_TEST(t, test_sc_key_cache);
+	DO_TEST(t, test_cp_scbkd_fallback);
+}
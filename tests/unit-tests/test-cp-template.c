@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+static struct test *g_tmpl_test;
+static int g_tmpl_rx_count, g_tmpl_rx_on_count;
+static int g_tmpl_completions, g_tmpl_wait_for, g_tmpl_failed;
+
+static int tmpl_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+
+	if (cmd->id == OSDP_CMD_LED) {
+		g_tmpl_rx_on_count = cmd->led.permanent.on_count;
+	}
+	g_tmpl_rx_count++;
+	return 0;
+}
+
+static void tmpl_completion_cb(void *arg, int pd, const struct osdp_cmd *cmd,
+			       enum osdp_completion_status status)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(cmd);
+
+	g_tmpl_completions++;
+	if (status != OSDP_COMPLETION_OK) {
+		g_tmpl_failed++;
+	}
+}
+
+static bool tmpl_completed(osdp_t *cp)
+{
+	ARG_UNUSED(cp);
+	return g_tmpl_completions == g_tmpl_wait_for;
+}
+
+/* Send the template and return the LED on_count the PD saw, or -1 */
+static int tmpl_send(osdp_t *cp, osdp_t *pd, struct osdp_cmd_template *tmpl)
+{
+	int rx_count = g_tmpl_rx_count;
+
+	g_tmpl_wait_for = g_tmpl_completions + 1;
+	if (osdp_cp_submit_command(cp, 0, &tmpl->cmd) ||
+	    !test_run_devices(cp, pd, 2000, tmpl_completed) || g_tmpl_failed ||
+	    g_tmpl_rx_count != rx_count + 1) {
+		return -1;
+	}
+	return g_tmpl_rx_on_count;
+}
+
+static int test_cp_command_template(void *data)
+{
+	int i, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_cmd_template tmpl, bad;
+	struct osdp_cmd cmd = {
+		.id = OSDP_CMD_LED,
+		.led = {
+			.permanent = {
+				.control_code = 1,
+				.on_count = 3,
+				.off_count = 3,
+				.on_color = OSDP_LED_COLOR_GREEN,
+			},
+		},
+	};
+	struct osdp_cmd comset = {
+		.id = OSDP_CMD_COMSET,
+		.comset = { .address = 101, .baud_rate = 9600 },
+	};
+
+	ARG_UNUSED(data);
+
+	g_tmpl_rx_count = g_tmpl_completions = g_tmpl_failed = 0;
+	if (test_setup_devices(g_tmpl_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_pd_set_command_callback(pd, tmpl_pd_command_cb, NULL);
+	osdp_cp_set_command_completion_callback(cp, tmpl_completion_cb, NULL);
+	if (!test_run_devices(cp, pd, 10000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	memset(&bad, 0, sizeof(bad));
+	bad.cmd.id = OSDP_CMD_LED;
+	bad.cmd.flags = OSDP_CMD_FLAG_TEMPLATE;
+	if (osdp_cp_compile_command(cp, &comset, &tmpl) == 0 ||
+	    osdp_cp_submit_command(cp, 0, &bad.cmd) == 0) {
+		printf(SUB_1 "invalid template accepted\n");
+		goto out;
+	}
+	if (osdp_cp_compile_command(cp, &cmd, &tmpl) ||
+	    tmpl.cmd.flags != OSDP_CMD_FLAG_TEMPLATE) {
+		printf(SUB_1 "compile failed\n");
+		goto out;
+	}
+
+	/* the same template, over and over */
+	for (i = 0; i < 3; i++) {
+		if (tmpl_send(cp, pd, &tmpl) != 3) {
+			printf(SUB_1 "send %d failed\n", i);
+			goto out;
+		}
+	}
+
+	/* the encoded data is what goes out until compiled again */
+	tmpl.cmd.led.permanent.on_count = 7;
+	if (tmpl_send(cp, pd, &tmpl) != 3) {
+		printf(SUB_1 "template was re-encoded\n");
+		goto out;
+	}
+	if (osdp_cp_compile_command(cp, &tmpl.cmd, &tmpl) ||
+	    tmpl_send(cp, pd, &tmpl) != 7) {
+		printf(SUB_1 "compiling again in place failed\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_cp_template_tests(struct test *t)
+{
+	printf("\nCP command template tests\n");
+
+	g_tmpl_test = t;
+
+	DO_TEST(t, test_cp_command_template);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test.h"
+
+typedef uint16_t (*crc16_fn_t)(uint16_t crc, const uint8_t *buf, size_t len);
+
+struct crc16_engine {
+	const char *name;
+	crc16_fn_t fn;
+};
+
+static const struct crc16_engine crc16_engines[] = {
+	{ "bitwise", osdp_crc16_bitwise },
+#if OSDP_CRC16_ENGINE >= 1
+	{ "table", osdp_crc16_table },
+#endif
+#if OSDP_CRC16_ENGINE >= 2
+	{ "slice8", osdp_crc16_slice8 },
+#endif
+#if OSDP_CRC16_ENGINE >= 2 && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+	{ "clmul", osdp_crc16_clmul },
+#endif
+};
+
+static bool crc16_engine_usable(const struct crc16_engine *e)
+{
+#if OSDP_CRC16_ENGINE >= 2 && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+	if (e->fn == osdp_crc16_clmul) {
+		return osdp_crc16_clmul_supported();
+	}
+#endif
+	ARG_UNUSED(e);
+	return true;
+}
+
+static int test_crc16_engines_agree(void *data)
+{
+	size_t i, len;
+	uint16_t seed, ref, got;
+	uint8_t buf[1100];
+	static const uint8_t check[] = "123456789";
+
+	ARG_UNUSED(data);
+
+	/* CRC-16/AUG-CCITT check value */
+	if (osdp_compute_crc16(check, 9) != 0xE5CC) {
+		printf("check value mismatch: %04x\n",
+		       osdp_compute_crc16(check, 9));
+		return -1;
+	}
+
+	for (i = 0; i < sizeof(buf); i++) {
+		buf[i] = (uint8_t)rand();
+	}
+
+	for (len = 0; len <= sizeof(buf); len += (len < 80) ? 1 : 37) {
+		seed = (uint16_t)rand();
+		ref = osdp_crc16_bitwise(seed, buf, len);
+		for (i = 0; i < ARRAY_SIZEOF(crc16_engines); i++) {
+			if (!crc16_engine_usable(&crc16_engines[i])) {
+				continue;
+			}
+			got = crc16_engines[i].fn(seed, buf, len);
+			if (got != ref) {
+				printf("%s: len %zu seed %04x got %04x want %04x\n",
+				       crc16_engines[i].name, len, seed, got, ref);
+				return -1;
+			}
+		}
+		if (seed == 0x1D0F && osdp_compute_crc16(buf, len) != ref) {
+			printf("dispatch mismatch at len %zu\n", len);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void run_crc_tests(struct test *t)
+{
+	printf("\nCRC-16 engine tests\n");
+
+	DO_TEST(t, test_crc16_engines_agree);
+}
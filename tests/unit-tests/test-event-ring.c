@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <pthread.h>
+
+#include <osdp.h>
+#include "test.h"
+
+#define RING_EVENTS 16
+
+static struct test *g_ring_test;
+static int g_ring_callbacks;
+static struct osdp_event g_ring_pd_events[RING_EVENTS];
+
+struct ring_consumer {
+	osdp_t *cp;
+	int received;
+	int out_of_order;
+	int stop;
+};
+
+static int ring_cp_event_cb(void *arg, int pd, struct osdp_event *ev)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+	ARG_UNUSED(ev);
+
+	g_ring_callbacks++;
+	return 0;
+}
+
+static int ring_setup(osdp_t **cp, osdp_t **pd)
+{
+	int i;
+
+	g_ring_callbacks = 0;
+	if (test_setup_devices(g_ring_test, cp, pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_cp_set_event_callback(*cp, ring_cp_event_cb, NULL);
+	if (!test_run_devices(*cp, *pd, 10000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		return -1;
+	}
+	for (i = 0; i < RING_EVENTS; i++) {
+		g_ring_pd_events[i] = (struct osdp_event) {
+			.type = OSDP_EVENT_CARDREAD,
+			.cardread = {
+				.format = OSDP_CARD_FMT_RAW_WIEGAND,
+				.length = 8,
+				.data = { (uint8_t)i },
+			},
+		};
+	}
+	return 0;
+}
+
+static int test_event_ring_drop(void *data)
+{
+	int i, n, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_cp_event ring[4], out[8];
+	struct osdp_metrics m;
+
+	ARG_UNUSED(data);
+
+	if (ring_setup(&cp, &pd)) {
+		goto out;
+	}
+	if (osdp_cp_poll_events(cp, out, 8) != -1 ||
+	    osdp_cp_set_event_ring(cp, ring, 3, OSDP_CP_EVENT_DROP) == 0 ||
+	    osdp_cp_set_event_ring(cp, ring, 4, OSDP_CP_EVENT_DROP)) {
+		printf(SUB_1 "event ring argument checks failed\n");
+		goto out;
+	}
+	osdp_get_metrics(cp, 0, &m);
+
+	for (i = 0; i < 6; i++) {
+		osdp_pd_submit_event(pd, &g_ring_pd_events[i]);
+	}
+	test_run_devices(cp, pd, 1000, NULL);
+
+	osdp_get_metrics(cp, 0, &m);
+	n = osdp_cp_poll_events(cp, out, 8);
+	if (n != 4 || m.event_drop_count != 2 || m.event_ring_hwm != 4) {
+		printf(SUB_1 "drop: got:%d dropped:%u hwm:%u\n",
+		       n, m.event_drop_count, m.event_ring_hwm);
+		goto out;
+	}
+	for (i = 0; i < n; i++) {
+		if (out[i].pd != 0 || out[i].event.cardread.data[0] != i) {
+			printf(SUB_1 "drop: unexpected event at %d\n", i);
+			goto out;
+		}
+	}
+	if (g_ring_callbacks != 0 || osdp_cp_poll_events(cp, out, 8) != 0) {
+		printf(SUB_1 "drop: callbacks:%d\n", g_ring_callbacks);
+		goto out;
+	}
+
+	/* back to the callback */
+	osdp_cp_set_event_ring(cp, NULL, 0, OSDP_CP_EVENT_DROP);
+	osdp_pd_submit_event(pd, &g_ring_pd_events[6]);
+	test_run_devices(cp, pd, 300, NULL);
+	if (g_ring_callbacks != 1) {
+		printf(SUB_1 "callback not restored\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+static void *ring_consumer_fn(void *arg)
+{
+	int i, n;
+	struct ring_consumer *c = arg;
+	struct osdp_cp_event out[3];
+
+	while (!__atomic_load_n(&c->stop, __ATOMIC_ACQUIRE)) {
+		n = osdp_cp_poll_events(c->cp, out, 3);
+		for (i = 0; i < n; i++) {
+			if (out[i].event.cardread.data[0] != c->received) {
+				c->out_of_order++;
+			}
+			__atomic_store_n(&c->received, c->received + 1,
+					 __ATOMIC_RELEASE);
+		}
+		/* a slow consumer; the ring fills up between drains */
+		usleep(150 * 1000);
+	}
+	return NULL;
+}
+
+static int test_event_ring_throttle(void *data)
+{
+	int i, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	pthread_t thread;
+	struct osdp_cp_event ring[2];
+	struct osdp_metrics m;
+	struct ring_consumer consumer = { 0 };
+	tick_t start;
+
+	ARG_UNUSED(data);
+
+	if (ring_setup(&cp, &pd)) {
+		goto out;
+	}
+	osdp_cp_set_event_ring(cp, ring, 2, OSDP_CP_EVENT_THROTTLE);
+	osdp_get_metrics(cp, 0, &m);
+
+	consumer.cp = cp;
+	if (pthread_create(&thread, NULL, ring_consumer_fn, &consumer)) {
+		printf(SUB_1 "pthread_create failed\n");
+		goto out;
+	}
+	for (i = 0; i < RING_EVENTS; i++) {
+		osdp_pd_submit_event(pd, &g_ring_pd_events[i]);
+	}
+	start = osdp_millis_now();
+	while (osdp_millis_since(start) < 10000 &&
+	       __atomic_load_n(&consumer.received, __ATOMIC_ACQUIRE) <
+	       RING_EVENTS) {
+		test_run_devices(cp, pd, 10, NULL);
+	}
+	__atomic_store_n(&consumer.stop, 1, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+
+	osdp_get_metrics(cp, 0, &m);
+	if (consumer.received != RING_EVENTS || consumer.out_of_order ||
+	    m.event_drop_count != 0 || m.event_ring_hwm != 2) {
+		printf(SUB_1 "throttle: got:%d reordered:%d dropped:%u hwm:%u\n",
+		       consumer.received, consumer.out_of_order,
+		       m.event_drop_count, m.event_ring_hwm);
+		goto out;
+	}
+	if (g_ring_callbacks != 0 || !test_pd_online(cp)) {
+		printf(SUB_1 "throttle: callbacks:%d\n", g_ring_callbacks);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_event_ring_tests(struct test *t)
+{
+	printf("\nCP event ring tests\n");
+
+	g_ring_test = t;
+
+	DO_TEST(t, test_event_ring_drop);
+	DO_TEST(t, test_event_ring_throttle);
+}
@@ -247,6 +247,13 @@ static bool test_pd_command_blocking()
 		return false;
 	}
 
+	/* Submissions are refused as soon as the request is posted */
+	ret = osdp_cp_submit_command(g_test_ctx.cp_ctx, 0, &cmd);
+	if (ret == 0) {
+		printf(SUB_2 "Command accepted right after disable\n");
+		return false;
+	}
+
 	/* osdp_cp_disable_pd() only posts a request to the CP FSM; wait for
 	 * the FSM to actually transition the PD to disabled before exercising
 	 * command submission and re-enable below. */
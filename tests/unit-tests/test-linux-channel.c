@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test.h"
+
+#ifdef OPT_OSDP_LINUX_CHANNEL
+
+#include <sys/socket.h>
+
+static int g_lc_buzzer_cmds;
+
+static int lc_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+
+	if (cmd->id == OSDP_CMD_BUZZER) {
+		g_lc_buzzer_cmds++;
+	}
+	return 0;
+}
+
+static bool lc_pd_online(osdp_t *cp)
+{
+	uint8_t status = 0;
+
+	osdp_get_status_mask(cp, &status);
+	return status & 1;
+}
+
+static bool lc_buzzer_received(osdp_t *cp)
+{
+	ARG_UNUSED(cp);
+	return g_lc_buzzer_cmds > 0;
+}
+
+/* the intended event loop: block in epoll until I/O or the next deadline */
+static bool lc_run_until(osdp_channel_loop_t *loop, osdp_t *cp, osdp_t *pd,
+			 bool (*cond)(osdp_t *cp))
+{
+	int cp_wake, pd_wake;
+	tick_t start = osdp_millis_now();
+
+	while (osdp_millis_since(start) < 10 * 1000) {
+		cp_wake = osdp_cp_next_wakeup(cp);
+		pd_wake = osdp_pd_next_wakeup(pd);
+		if (osdp_channel_loop_wait(loop, (cp_wake < pd_wake) ?
+					   cp_wake : pd_wake) < 0) {
+			return false;
+		}
+		osdp_cp_refresh(cp);
+		osdp_pd_refresh(pd);
+		if (cond(cp)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static int test_linux_channel_socketpair(void *data)
+{
+	int sv[2], rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	osdp_channel_loop_t *loop;
+	struct osdp_channel cp_ch = {0}, pd_ch = {0};
+	struct osdp_pd_cap cap[] = {
+		{ OSDP_PD_CAP_READER_AUDIBLE_OUTPUT, 1, 1 },
+		{ -1, -1, -1 }
+	};
+	osdp_pd_info_t pd_info = {
+		.address = 101,
+		.baud_rate = 115200,
+		.id = {
+			.version = 1,
+			.model = 153,
+			.vendor_code = 31337,
+			.serial_number = 0x01020304,
+		},
+		.cap = cap,
+	};
+	osdp_pd_info_t cp_info = {
+		.address = 101,
+		.baud_rate = 115200,
+	};
+	struct osdp_cmd cmd = {
+		.id = OSDP_CMD_BUZZER,
+		.buzzer = {
+			.control_code = 1,
+			.on_count = 10,
+			.off_count = 10,
+			.rep_count = 1,
+		},
+	};
+
+	ARG_UNUSED(data);
+
+	g_lc_buzzer_cmds = 0;
+	loop = osdp_channel_loop_create();
+	if (loop == NULL) {
+		printf(SUB_1 "loop create failed\n");
+		return -1;
+	}
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+		printf(SUB_1 "socketpair failed\n");
+		goto out;
+	}
+	if (osdp_channel_open_fd(loop, &cp_ch, sv[0]) ||
+	    osdp_channel_open_fd(loop, &pd_ch, sv[1])) {
+		printf(SUB_1 "channel open failed\n");
+		goto out;
+	}
+	if (osdp_channel_get_fd(&cp_ch) != sv[0]) {
+		printf(SUB_1 "channel fd mismatch\n");
+		goto out;
+	}
+
+	cp = osdp_cp_setup(&cp_ch, 1, &cp_info);
+	pd = osdp_pd_setup(&pd_ch, &pd_info);
+	if (cp == NULL || pd == NULL) {
+		printf(SUB_1 "device setup failed\n");
+		goto out;
+	}
+	osdp_pd_set_command_callback(pd, lc_pd_command_cb, NULL);
+
+	if (!lc_run_until(loop, cp, pd, lc_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+	if (osdp_cp_submit_command(cp, 0, &cmd) ||
+	    !lc_run_until(loop, cp, pd, lc_buzzer_received)) {
+		printf(SUB_1 "command did not reach the PD\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	/* contexts close their channels (and fds) on teardown */
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	osdp_channel_loop_destroy(loop);
+	return rc;
+}
+
+static int test_linux_channel_eof(void *data)
+{
+	int sv[2], rc = -1;
+	uint8_t buf[8] = { 0x53, 0x65 };
+	osdp_channel_loop_t *loop;
+	struct osdp_channel ch = {0};
+
+	ARG_UNUSED(data);
+
+	loop = osdp_channel_loop_create();
+	if (loop == NULL || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+		osdp_channel_loop_destroy(loop);
+		return -1;
+	}
+	if (osdp_channel_open_fd(loop, &ch, sv[0])) {
+		close(sv[1]);
+		goto out;
+	}
+
+	if (write(sv[1], buf, 2) != 2 ||
+	    osdp_channel_loop_wait(loop, 1000) != 1 ||
+	    ch.recv(ch.data, buf, sizeof(buf)) != 2 ||
+	    ch.recv(ch.data, buf, sizeof(buf)) != 0) {
+		printf(SUB_1 "buffered receive failed\n");
+		close(sv[1]);
+		goto close;
+	}
+	if (ch.send(ch.data, buf, 2) != 2 || read(sv[1], buf, 8) != 2) {
+		printf(SUB_1 "send failed\n");
+		close(sv[1]);
+		goto close;
+	}
+
+	close(sv[1]);
+	if (osdp_channel_loop_wait(loop, 1000) != 1 ||
+	    ch.recv(ch.data, buf, sizeof(buf)) != -1) {
+		printf(SUB_1 "peer hangup not reported\n");
+		goto close;
+	}
+	rc = 0;
+close:
+	ch.close(ch.data);
+out:
+	osdp_channel_loop_destroy(loop);
+	return rc;
+}
+
+void run_linux_channel_tests(struct test *t)
+{
+	printf("\nLinux channel tests\n");
+
+	DO_TEST(t, test_linux_channel_eof);
+	DO_TEST(t, test_linux_channel_socketpair);
+}
+
+#else
+
+void run_linux_channel_tests(struct test *t)
+{
+	ARG_UNUSED(t);
+	printf("\nLinux channel tests skipped (OPT_OSDP_LINUX_CHANNEL not enabled)\n");
+}
+
+#endif /* OPT_OSDP_LINUX_CHANNEL */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+static struct test *g_metrics_test;
+
+static uint32_t hist_total(const uint32_t *h)
+{
+	int i;
+	uint32_t sum = 0;
+
+	for (i = 0; i < OSDP_METRICS_HIST_BUCKETS; i++) {
+		sum += h[i];
+	}
+	return sum;
+}
+
+static bool wire_time_ok(const struct osdp_metrics *m, uint32_t baud_rate)
+{
+	uint64_t expected;
+
+	expected = (uint64_t)(m->tx_bytes + m->rx_bytes) * 10 * 1000000 /
+		   baud_rate;
+	/* per-call truncation may lose up to 1us per packet */
+	return m->wire_time_us <= expected &&
+	       m->wire_time_us + m->packets_sent + m->packets_received + 8 >=
+	       expected;
+}
+
+static int test_bus_metrics(void *data)
+{
+	int i, rc = -1;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_metrics cm, pm;
+
+	ARG_UNUSED(data);
+
+	if (test_setup_devices(g_metrics_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	test_run_devices(cp, pd, 10000, test_pd_online);
+	osdp_get_metrics(cp, 0, &cm);
+	osdp_get_metrics(pd, 0, &pm);
+
+	/* let a window of plain polls run and look at just that */
+	test_run_devices(cp, pd, 500, NULL);
+	osdp_get_metrics(cp, 0, &cm);
+	osdp_get_metrics(pd, 0, &pm);
+
+	if (cm.tx_bytes == 0 || cm.rx_bytes == 0 ||
+	    cm.tx_bytes != pm.rx_bytes || cm.rx_bytes < pm.tx_bytes) {
+		printf(SUB_1 "byte counts cp:%u/%u pd:%u/%u\n",
+		       cm.tx_bytes, cm.rx_bytes, pm.tx_bytes, pm.rx_bytes);
+		goto out;
+	}
+	if (!wire_time_ok(&cm, 9600) || !wire_time_ok(&pm, 9600)) {
+		printf(SUB_1 "wire time cp:%uus pd:%uus\n",
+		       cm.wire_time_us, pm.wire_time_us);
+		goto out;
+	}
+
+	/* every completed exchange lands in both CP histograms */
+	if (hist_total(cm.rtt_hist) == 0 ||
+	    hist_total(cm.rtt_hist) > cm.packets_sent ||
+	    hist_total(cm.turnaround_hist) < hist_total(cm.rtt_hist)) {
+		printf(SUB_1 "histograms rtt:%u turnaround:%u sent:%u\n",
+		       hist_total(cm.rtt_hist), hist_total(cm.turnaround_hist),
+		       cm.packets_sent);
+		goto out;
+	}
+	/* the mock channel is instant; nothing should be near 256ms */
+	if (cm.rtt_hist[OSDP_METRICS_HIST_BUCKETS - 1] != 0) {
+		printf(SUB_1 "RTT samples in the overflow bucket\n");
+		goto out;
+	}
+	for (i = 0; i < OSDP_METRICS_HIST_BUCKETS; i++) {
+		if (pm.rtt_hist[i] || pm.turnaround_hist[i]) {
+			printf(SUB_1 "PD mode recorded latency samples\n");
+			goto out;
+		}
+	}
+	if (cm.bus_busy_ms > 500) {
+		printf(SUB_1 "bus busy %ums in a 500ms window\n",
+		       cm.bus_busy_ms);
+		goto out;
+	}
+
+	/* counters are interval deltas */
+	osdp_get_metrics(cp, 0, &cm);
+	if (cm.tx_bytes || hist_total(cm.rtt_hist)) {
+		printf(SUB_1 "metrics not reset on read\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_metrics_tests(struct test *t)
+{
+	printf("\nMetrics tests\n");
+
+	g_metrics_test = t;
+
+	DO_TEST(t, test_bus_metrics);
+}
@@ -300,6 +300,184 @@ static int test_pd_phy_sc_setup_clears_cache(struct osdp *ctx)
 	return 0;
 }
 
+/* Wrap @inner in the data block of another PD's reply (osdp_RAW) */
+static int pd_test_build_foreign_reply(const uint8_t *inner, int inner_len,
+				       uint8_t *out, int max_len)
+{
+	int len = 0, pkt_len = 5 + 1 + inner_len + 1;
+
+	if (max_len < pkt_len + 1) {
+		return -1;
+	}
+	out[len++] = 0xff;
+	out[len++] = 0x53;
+	out[len++] = 0x80 | (PD_TEST_ADDR + 1);
+	out[len++] = pkt_len & 0xff;
+	out[len++] = (pkt_len >> 8) & 0xff;
+	out[len++] = 0x01;
+	out[len++] = REPLY_RAW;
+	memcpy(out + len, inner, inner_len);
+	len += inner_len;
+	out[len] = test_osdp_compute_checksum(out + 1, len - 1);
+	return len + 1;
+}
+
+/* Another PD's reply is skipped whole by its length field, even when its
+ * payload looks like a command for us, and is counted as discarded. */
+static int test_pd_phy_skip_foreign_packet(struct osdp *ctx)
+{
+	struct osdp_pd *p = osdp_to_pd(ctx, 0);
+	uint8_t cmd[32], foreign[64];
+	int cmd_len, foreign_len, err;
+	uint32_t discarded;
+
+	printf(SUB_1 "Testing PD skips foreign packets by length -- ");
+
+	osdp_phy_state_reset(p, true);
+	cmd_len = pd_test_build_cmd_packet(0x00, CMD_POLL, NULL, 0,
+					   cmd, sizeof(cmd));
+	foreign_len = pd_test_build_foreign_reply(cmd, cmd_len, foreign,
+						  sizeof(foreign));
+	if (cmd_len < 0 || foreign_len < 0) {
+		printf("failed to build packets\n");
+		return -1;
+	}
+
+	/* whole foreign packet in one read */
+	discarded = p->metrics.rx_discarded_bytes;
+	osdp_rb_push_buf(p->rx_rb, foreign, foreign_len);
+	err = osdp_phy_check_packet(p);
+	osdp_phy_state_reset(p, false);
+	if (err != OSDP_ERR_PKT_SKIP ||
+	    osdp_phy_check_packet(p) != OSDP_ERR_PKT_NO_DATA ||
+	    p->metrics.rx_discarded_bytes - discarded != (uint32_t)foreign_len) {
+		printf("embedded packet was parsed (err:%d discarded:%u)\n",
+		       err, p->metrics.rx_discarded_bytes - discarded);
+		return -1;
+	}
+
+	/* split across reads, followed by a packet that is for us */
+	osdp_phy_state_reset(p, true);
+	osdp_rb_push_buf(p->rx_rb, foreign, 10);
+	err = osdp_phy_check_packet(p);
+	osdp_phy_state_reset(p, false);
+	if (err != OSDP_ERR_PKT_SKIP) {
+		printf("expected OSDP_ERR_PKT_SKIP, got %d\n", err);
+		return -1;
+	}
+	osdp_rb_push_buf(p->rx_rb, foreign + 10, foreign_len - 10);
+	osdp_rb_push_buf(p->rx_rb, cmd, cmd_len);
+	err = osdp_phy_check_packet(p);
+	if (err != OSDP_ERR_PKT_NONE) {
+		printf("packet after a skipped one: got %d\n", err);
+		return -1;
+	}
+	osdp_phy_state_reset(p, true);
+	printf("success!\n");
+	return 0;
+}
+
+/* A foreign packet shorter than header + a blind read, arriving in pieces,
+ * must not take the start of the next packet down with it. */
+static int test_pd_phy_skip_short_foreign_packet(struct osdp *ctx)
+{
+	struct osdp_pd *p = osdp_to_pd(ctx, 0);
+	uint8_t cmd[32];
+	/* MARK, SoM, addr, len (6), control, reply ID; no checksum */
+	const uint8_t foreign[] = {
+		0xff, 0x53, 0x80 | (PD_TEST_ADDR + 1), 0x06, 0x00, 0x00,
+		REPLY_ACK,
+	};
+	int cmd_len, err, i;
+
+	printf(SUB_1 "Testing PD skips short foreign packets in pieces -- ");
+
+	osdp_phy_state_reset(p, true);
+	cmd_len = pd_test_build_cmd_packet(0x00, CMD_POLL, NULL, 0,
+					   cmd, sizeof(cmd));
+	if (cmd_len < 0) {
+		printf("failed to build packet\n");
+		return -1;
+	}
+
+	for (i = 0; i < 4; i += 2) {
+		osdp_rb_push_buf(p->rx_rb, foreign + i, 2);
+		err = osdp_phy_check_packet(p);
+		if (err != OSDP_ERR_PKT_WAIT && err != OSDP_ERR_PKT_NO_DATA) {
+			printf("partial header: got %d\n", err);
+			return -1;
+		}
+	}
+	osdp_rb_push_buf(p->rx_rb, foreign + 4, sizeof(foreign) - 4);
+	osdp_rb_push_buf(p->rx_rb, cmd, cmd_len);
+	err = osdp_phy_check_packet(p);
+	osdp_phy_state_reset(p, false);
+	if (err != OSDP_ERR_PKT_SKIP || p->rx_skip != 0) {
+		printf("expected OSDP_ERR_PKT_SKIP, got %d (rx_skip:%u)\n",
+		       err, p->rx_skip);
+		return -1;
+	}
+	err = osdp_phy_check_packet(p);
+	if (err != OSDP_ERR_PKT_NONE) {
+		printf("packet after a skipped one: got %d\n", err);
+		return -1;
+	}
+	osdp_phy_state_reset(p, true);
+	printf("success!\n");
+	return 0;
+}
+
+/* With OPT_OSDP_EARLY_ADDRESS_FILTER, commands for other PDs are skipped by
+ * address before any CRC check and are counted as observed, not received.
+ * Without it, they are checked (and here, rejected) like any other frame. */
+static int test_pd_phy_early_address_filter(struct osdp *ctx)
+{
+	struct osdp_pd *p = osdp_to_pd(ctx, 0);
+	struct osdp_metrics before = p->metrics;
+	uint8_t packet[32];
+	int pkt_len, err, mark = 1;
+
+	printf(SUB_1 "Testing PD handling of other PDs' commands -- ");
+
+#ifdef OPT_OSDP_SKIP_MARK_BYTE
+	mark = 0;
+#endif
+	osdp_phy_state_reset(p, true);
+	pkt_len = pd_test_build_cmd_packet(0x00, CMD_POLL, NULL, 0,
+					   packet, sizeof(packet));
+	if (pkt_len < 0) {
+		printf("failed to build packet\n");
+		return -1;
+	}
+	packet[mark + 1] = PD_TEST_ADDR + 1;
+	packet[pkt_len - 1] ^= 0xff; /* would fail the checksum */
+
+	osdp_rb_push_buf(p->rx_rb, packet, pkt_len);
+	err = osdp_phy_check_packet(p);
+	osdp_phy_state_reset(p, false);
+#ifdef OPT_OSDP_EARLY_ADDRESS_FILTER
+	if (err != OSDP_ERR_PKT_SKIP ||
+	    p->metrics.packets_observed != before.packets_observed + 1 ||
+	    p->metrics.packets_received != before.packets_received ||
+	    p->metrics.packet_check_errors != before.packet_check_errors) {
+#else
+	if (err != OSDP_ERR_PKT_FMT ||
+	    p->metrics.packets_observed != before.packets_observed ||
+	    p->metrics.packets_received != before.packets_received + 1 ||
+	    p->metrics.packet_check_errors != before.packet_check_errors + 1) {
+#endif
+		printf("got %d; observed:%u received:%u check errors:%u\n", err,
+		       p->metrics.packets_observed - before.packets_observed,
+		       p->metrics.packets_received - before.packets_received,
+		       p->metrics.packet_check_errors -
+		       before.packet_check_errors);
+		return -1;
+	}
+	osdp_phy_state_reset(p, true);
+	printf("success!\n");
+	return 0;
+}
+
 static int test_pd_phy_setup(struct test *t)
 {
 	static uint8_t scbk[16] = {
@@ -366,6 +544,9 @@ void run_pd_phy_tests(struct test *t)
 	DO_TEST(t, test_pd_phy_seq_zero_clears_cache);
 	DO_TEST(t, test_pd_phy_sc_deactivate_clears_cache);
 	DO_TEST(t, test_pd_phy_sc_setup_clears_cache);
+	DO_TEST(t, test_pd_phy_skip_foreign_packet);
+	DO_TEST(t, test_pd_phy_skip_short_foreign_packet);
+	DO_TEST(t, test_pd_phy_early_address_filter);
 
 	test_pd_phy_teardown(t);
 }
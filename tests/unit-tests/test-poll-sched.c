@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+static struct test *g_sched_test;
+static int g_sched_card_reads;
+
+static int sched_cp_event_cb(void *arg, int pd, struct osdp_event *ev)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(pd);
+
+	if (ev->type == OSDP_EVENT_CARDREAD) {
+		g_sched_card_reads++;
+	}
+	return 0;
+}
+
+static bool sched_card_read(osdp_t *cp)
+{
+	ARG_UNUSED(cp);
+	return g_sched_card_reads > 0;
+}
+
+static int test_poll_sched(void *data)
+{
+	int rc = -1, fixed_polls;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_metrics m;
+	struct osdp_event card = {
+		.type = OSDP_EVENT_CARDREAD,
+		.cardread = {
+			.reader_no = 0,
+			.format = OSDP_CARD_FMT_RAW_WIEGAND,
+			.direction = 0,
+			.length = 16,
+			.data = { 0xa5, 0x5a },
+		},
+	};
+
+	ARG_UNUSED(data);
+
+	g_sched_card_reads = 0;
+	if (test_setup_devices(g_sched_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_cp_set_event_callback(cp, sched_cp_event_cb, NULL);
+	if (!test_run_devices(cp, pd, 10 * 1000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	/* baseline: the fixed policy polls an idle PD at the full rate */
+	osdp_get_metrics(cp, 0, &m);
+	test_run_devices(cp, pd, 1000, NULL);
+	osdp_get_metrics(cp, 0, &m);
+	fixed_polls = m.poll_count;
+	if (m.poll_interval_ms != OSDP_PD_POLL_TIMEOUT_MS ||
+	    m.poll_idle_count == 0) {
+		printf(SUB_1 "fixed: interval:%u idle:%u\n",
+		       m.poll_interval_ms, m.poll_idle_count);
+		goto out;
+	}
+
+	/* an idle PD backs off under the activity policy ... */
+	osdp_cp_set_poll_policy(cp, OSDP_CP_POLL_ACTIVITY);
+	test_run_devices(cp, pd, 1000, NULL);
+	osdp_get_metrics(cp, 0, &m);
+	test_run_devices(cp, pd, 1000, NULL);
+	osdp_get_metrics(cp, 0, &m);
+	if (m.poll_interval_ms != OSDP_PD_POLL_IDLE_MAX_MS ||
+	    m.poll_count * 2 >= (uint32_t)fixed_polls) {
+		printf(SUB_1 "activity: interval:%u polls:%u (fixed:%d)\n",
+		       m.poll_interval_ms, m.poll_count, fixed_polls);
+		goto out;
+	}
+
+	/* ... and returns to the full rate once it has something to say */
+	if (osdp_pd_submit_event(pd, &card) ||
+	    !test_run_devices(cp, pd, 2 * 1000, sched_card_read)) {
+		printf(SUB_1 "card read not delivered\n");
+		goto out;
+	}
+	osdp_get_metrics(cp, 0, &m);
+	if (m.poll_interval_ms != OSDP_PD_POLL_TIMEOUT_MS) {
+		printf(SUB_1 "activity: interval %u after event\n",
+		       m.poll_interval_ms);
+		goto out;
+	}
+
+	osdp_cp_set_poll_policy(cp, OSDP_CP_POLL_PRIORITY);
+	if (osdp_cp_set_poll_priority(cp, 0, OSDP_PD_POLL_PRIORITY_MAX + 1) == 0 ||
+	    osdp_cp_set_poll_priority(cp, 0, 2)) {
+		printf(SUB_1 "priority range check failed\n");
+		goto out;
+	}
+	osdp_get_metrics(cp, 0, &m);
+	if (m.poll_interval_ms != OSDP_PD_POLL_TIMEOUT_MS << 2) {
+		printf(SUB_1 "priority: interval %u\n", m.poll_interval_ms);
+		goto out;
+	}
+
+	osdp_cp_set_poll_policy(cp, OSDP_CP_POLL_LATENCY);
+	osdp_cp_set_poll_latency(cp, 0, 150);
+	osdp_get_metrics(cp, 0, &m);
+	if (m.poll_interval_ms != 150 - m.poll_rtt_ms) {
+		printf(SUB_1 "latency: interval:%u rtt:%u\n",
+		       m.poll_interval_ms, m.poll_rtt_ms);
+		goto out;
+	}
+	osdp_cp_set_poll_latency(cp, 0, 1);
+	osdp_get_metrics(cp, 0, &m);
+	if (m.poll_interval_ms != OSDP_PD_POLL_MIN_MS) {
+		printf(SUB_1 "latency: unmet target gave interval %u\n",
+		       m.poll_interval_ms);
+		goto out;
+	}
+	osdp_cp_set_poll_latency(cp, 0, 150);
+	if (!test_run_devices(cp, pd, 500, NULL) || !test_pd_online(cp)) {
+		printf(SUB_1 "PD went offline\n");
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_poll_sched_tests(struct test *t)
+{
+	printf("\nPoll scheduler tests\n");
+
+	g_sched_test = t;
+
+	DO_TEST(t, test_poll_sched);
+}
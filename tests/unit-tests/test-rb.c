@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test.h"
+
+#define RB_MARK 0xFF
+#define RB_SOM 0x53
+
+static struct osdp_rb g_rb;
+
+static int test_rb_wrap_roundtrip(void *data)
+{
+	int i, n, round, cap = (int)sizeof(g_rb.buffer) - 1;
+	uint8_t in[sizeof(g_rb.buffer)], out[sizeof(g_rb.buffer)];
+	uint8_t seq = 0, expect = 0;
+
+	ARG_UNUSED(data);
+
+	osdp_rb_reset(&g_rb);
+
+	/* fill to capacity; the extra byte must be refused */
+	memset(in, 0xA5, sizeof(in));
+	if (osdp_rb_push_buf(&g_rb, in, sizeof(in)) != cap ||
+	    osdp_rb_len(&g_rb) != (size_t)cap ||
+	    osdp_rb_push(&g_rb, 0) == 0) {
+		printf(SUB_1 "capacity check failed\n");
+		return -1;
+	}
+	osdp_rb_reset(&g_rb);
+
+	/* odd-sized chunks so that head/tail walk across the wrap point */
+	for (round = 0; round < 200; round++) {
+		n = 1 + (round * 37) % (cap / 2);
+		for (i = 0; i < n; i++) {
+			in[i] = seq++;
+		}
+		if (osdp_rb_push_buf(&g_rb, in, n) != n) {
+			printf(SUB_1 "push short at round %d\n", round);
+			return -1;
+		}
+		n = osdp_rb_pop_buf(&g_rb, out, n - (round & 1));
+		for (i = 0; i < n; i++) {
+			if (out[i] != expect++) {
+				printf(SUB_1 "data mismatch at round %d\n", round);
+				return -1;
+			}
+		}
+	}
+
+	n = osdp_rb_pop_buf(&g_rb, out, sizeof(out));
+	for (i = 0; i < n; i++) {
+		if (out[i] != expect++) {
+			printf(SUB_1 "tail data mismatch\n");
+			return -1;
+		}
+	}
+	if (expect != seq || osdp_rb_len(&g_rb) != 0) {
+		printf(SUB_1 "ring not drained\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_rb_peek_scan(void *data)
+{
+	int i, off;
+	uint8_t b, buf[16];
+	const int pad = (int)sizeof(g_rb.buffer) - 4;
+
+	ARG_UNUSED(data);
+
+	/* park head/tail near the end so that the content wraps */
+	osdp_rb_reset(&g_rb);
+	for (i = 0; i < pad; i++) {
+		osdp_rb_push(&g_rb, 0);
+	}
+	osdp_rb_skip(&g_rb, pad);
+
+	for (i = 0; i < 10; i++) {
+		osdp_rb_push(&g_rb, (uint8_t)(0x10 + i));
+	}
+	osdp_rb_push(&g_rb, RB_MARK);
+	osdp_rb_push(&g_rb, RB_SOM);
+
+	off = osdp_rb_scan(&g_rb, RB_SOM);
+	if (off != 11 || osdp_rb_scan(&g_rb, 0x13) != 3 ||
+	    osdp_rb_scan(&g_rb, 0x99) != -1) {
+		printf(SUB_1 "scan returned wrong offsets (%d)\n", off);
+		return -1;
+	}
+	if (osdp_rb_peek(&g_rb, off - 1, &b) || b != RB_MARK ||
+	    osdp_rb_peek(&g_rb, off + 1, &b) == 0) {
+		printf(SUB_1 "peek failed\n");
+		return -1;
+	}
+	if (osdp_rb_peek_buf(&g_rb, buf, sizeof(buf)) != 12 ||
+	    osdp_rb_len(&g_rb) != 12 || buf[5] != 0x15) {
+		printf(SUB_1 "peek_buf consumed or mis-copied data\n");
+		return -1;
+	}
+	if (osdp_rb_skip(&g_rb, off) != off ||
+	    osdp_rb_pop(&g_rb, &b) || b != RB_SOM ||
+	    osdp_rb_len(&g_rb) != 0) {
+		printf(SUB_1 "skip failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int test_rb_compact(void *data)
+{
+	int i, n;
+	uint8_t b;
+	const int pad = (int)sizeof(g_rb.buffer) - 8;
+
+	ARG_UNUSED(data);
+
+	/* wrapped content must come out linear and in order */
+	osdp_rb_reset(&g_rb);
+	for (i = 0; i < pad; i++) {
+		osdp_rb_push(&g_rb, 0);
+	}
+	osdp_rb_skip(&g_rb, pad);
+	for (i = 0; i < 20; i++) {
+		osdp_rb_push(&g_rb, (uint8_t)i);
+	}
+	osdp_rb_compact(&g_rb);
+	if (g_rb.tail != 0 || g_rb.head != 20) {
+		printf(SUB_1 "wrapped compact left tail %zu head %zu\n",
+		       g_rb.tail, g_rb.head);
+		return -1;
+	}
+	for (i = 0; i < 20; i++) {
+		if (g_rb.buffer[i] != (uint8_t)i) {
+			printf(SUB_1 "wrapped compact corrupted data\n");
+			return -1;
+		}
+	}
+
+	/* plain case */
+	osdp_rb_skip(&g_rb, 5);
+	osdp_rb_compact(&g_rb);
+	n = (int)osdp_rb_len(&g_rb);
+	if (n != 15 || g_rb.tail != 0 || osdp_rb_peek(&g_rb, 0, &b) || b != 5) {
+		printf(SUB_1 "linear compact failed\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+void run_rb_tests(struct test *t)
+{
+	printf("\nRX ring buffer tests\n");
+
+	DO_TEST(t, test_rb_wrap_roundtrip);
+	DO_TEST(t, test_rb_peek_scan);
+	DO_TEST(t, test_rb_compact);
+}
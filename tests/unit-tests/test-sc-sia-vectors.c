@@ -235,6 +235,27 @@ static int test_scbkd_vectors(void *data)
 	return 0;
 }
 
+/*
+ * test_scbkd_vectors() ran on the best AES code of this build; on TinyAES,
+ * run the same vectors on each of its fallbacks as well.
+ */
+static int test_scbkd_vectors_fallback(void *data)
+{
+	int level, runs = 0, rc = 0;
+
+	for (level = 1; level <= 2 && rc == 0; level++) {
+		if (test_tinyaes_fallback(level) == 0) {
+			rc = test_scbkd_vectors(data);
+			runs++;
+		}
+	}
+	test_tinyaes_fallback(0);
+	if (runs == 0) {
+		TEST_SKIP("no TinyAES fallback in this build");
+	}
+	return rc;
+}
+
 void run_vector_tests(struct test *t)
 {
 	printf("Annex E vector tests\n");
@@ -242,4 +263,5 @@ void run_vector_tests(struct test *t)
 	DO_TEST(t, test_crc_vectors);
 	DO_TEST(t, test_checksum_vectors);
 	DO_TEST(t, test_scbkd_vectors);
+	DO_TEST(t, test_scbkd_vectors_fallback);
 }
@@ -154,6 +154,97 @@ static int test_aes_cbc_decrypt_vector(struct osdp *ctx)
 	return 0;
 }
 
+static int test_aes_key_handle_vector(struct osdp *ctx)
+{
+	int i;
+	uint8_t buf[sizeof(tv_pt_4blk)];
+	uint8_t iv[sizeof(tv_iv)];
+	struct osdp_crypt_key enc = { 0 }, dec = { 0 };
+
+	ARG_UNUSED(ctx);
+
+	osdp_crypt_key_setup(&enc, tv_key, false);
+	osdp_crypt_key_setup(&dec, tv_key, true);
+
+	/* CBC over all blocks, then ECB on the same handle must not leak IV */
+	memcpy(buf, tv_pt_4blk, sizeof(buf));
+	memcpy(iv, tv_iv, sizeof(iv));
+	osdp_crypt_key_encrypt(&enc, iv, buf, sizeof(buf));
+	if (memcmp(buf, tv_ct_4blk, sizeof(buf)) != 0) {
+		printf("key handle CBC encrypt mismatch\n");
+		goto error;
+	}
+	memcpy(iv, tv_iv, sizeof(iv));
+	osdp_crypt_key_decrypt(&dec, iv, buf, sizeof(buf));
+	if (memcmp(buf, tv_pt_4blk, sizeof(buf)) != 0) {
+		printf("key handle CBC decrypt mismatch\n");
+		goto error;
+	}
+	for (i = 0; i < 16; i++) {
+		buf[i] = tv_pt_4blk[i] ^ tv_iv[i];
+	}
+	osdp_crypt_key_encrypt(&enc, NULL, buf, 16);
+	if (memcmp(buf, tv_ct_1blk, 16) != 0) {
+		printf("key handle ECB encrypt mismatch\n");
+		goto error;
+	}
+
+	osdp_crypt_key_teardown(&enc);
+	osdp_crypt_key_teardown(&dec);
+	if (enc.ready || dec.ready) {
+		printf("key handle not released on teardown\n");
+		return -1;
+	}
+	return 0;
+error:
+	osdp_crypt_key_teardown(&enc);
+	osdp_crypt_key_teardown(&dec);
+	return -1;
+}
+
+static int test_aes_key_cbc_mac_vector(struct osdp *ctx)
+{
+	int rc = 0;
+	uint8_t iv[sizeof(tv_iv)];
+	struct osdp_crypt_key key = { 0 };
+
+	ARG_UNUSED(ctx);
+
+	osdp_crypt_key_setup(&key, tv_key, false);
+	memcpy(iv, tv_iv, sizeof(iv));
+	osdp_crypt_key_cbc_mac(&key, iv, tv_pt_4blk, sizeof(tv_pt_4blk));
+	if (memcmp(iv, tv_ct_4blk_last, 16) != 0) {
+		printf("CBC-MAC chaining value mismatch\n");
+		hexdump(tv_ct_4blk_last, 16, SUB_1 "Expected");
+		hexdump(iv, 16, SUB_1 "Found");
+		rc = -1;
+	}
+	osdp_crypt_key_teardown(&key);
+
+	return rc;
+}
+
+/* The AES vectors above, on each TinyAES fallback this build has */
+static int test_aes_vectors_fallback(struct osdp *ctx)
+{
+	int level, runs = 0, rc = 0;
+
+	for (level = 1; level <= 2 && rc == 0; level++) {
+		if (test_tinyaes_fallback(level) == 0) {
+			rc = test_aes_cbc_encrypt_vector(ctx) ||
+			     test_aes_cbc_decrypt_vector(ctx) ||
+			     test_aes_key_handle_vector(ctx) ||
+			     test_aes_key_cbc_mac_vector(ctx);
+			runs++;
+		}
+	}
+	test_tinyaes_fallback(0);
+	if (runs == 0) {
+		TEST_SKIP("no TinyAES fallback in this build");
+	}
+	return rc ? -1 : 0;
+}
+
 static int test_sc_mac_cmd_one_block(struct osdp *ctx)
 {
 	struct osdp_pd pd;
@@ -404,6 +495,59 @@ static int test_sc_decrypt_data_invalid_marker(struct osdp *ctx)
 	return 0;
 }
 
+static int test_sc_seal_open_roundtrip(struct osdp *ctx)
+{
+	int i, rc;
+	struct osdp_pd pd;
+	uint8_t ref[9 + 48], buf[9 + 48], ref_mac[16];
+	const int hdr_len = 9, data_len = 37;
+
+	ARG_UNUSED(ctx);
+	init_sc_mac_ctx(&pd, true);
+	memcpy(pd.sc.s_enc, tv_key, sizeof(tv_key));
+
+	for (i = 0; i < hdr_len + data_len; i++) {
+		ref[i] = (uint8_t)i;
+	}
+	memcpy(buf, ref, sizeof(buf));
+
+	/* Reference: encrypt, then MAC in a separate pass */
+	rc = test_osdp_encrypt_data(&pd, 1, ref + hdr_len, data_len);
+	test_osdp_compute_mac(&pd, 1, ref, hdr_len + rc);
+	memcpy(ref_mac, pd.sc.c_mac, 16);
+	memset(pd.sc.c_mac, 0, 16);
+
+	rc = osdp_sc_seal(&pd, buf, hdr_len, data_len);
+	if (rc != (int)sizeof(buf) || memcmp(buf, ref, sizeof(buf)) != 0 ||
+	    memcmp(pd.sc.c_mac, ref_mac, 16) != 0) {
+		printf("seal does not match two pass output\n");
+		return -1;
+	}
+
+	/* Receiving side of a command is the PD */
+	SET_FLAG(&pd, PD_FLAG_PD_MODE);
+	memcpy(buf, ref, sizeof(buf));
+	buf[hdr_len + 3] ^= 0x01;
+	if (osdp_sc_open(&pd, buf, hdr_len, 48, ref_mac) != -1) {
+		printf("open accepted a tampered packet\n");
+		return -1;
+	}
+	memcpy(buf, ref, sizeof(buf));
+	rc = osdp_sc_open(&pd, buf, hdr_len, 48, ref_mac);
+	if (rc != data_len) {
+		printf("open returned %d, expected %d\n", rc, data_len);
+		return -1;
+	}
+	for (i = 0; i < data_len; i++) {
+		if (buf[hdr_len + i] != (uint8_t)(hdr_len + i)) {
+			printf("open plain text mismatch at %d\n", i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 void run_sc_tests(struct test *t)
 {
 	printf("\n");
@@ -414,6 +558,9 @@ void run_sc_tests(struct test *t)
 
 	DO_TEST(t, test_aes_cbc_encrypt_vector);
 	DO_TEST(t, test_aes_cbc_decrypt_vector);
+	DO_TEST(t, test_aes_key_handle_vector);
+	DO_TEST(t, test_aes_key_cbc_mac_vector);
+	DO_TEST(t, test_aes_vectors_fallback);
 	DO_TEST(t, test_sc_mac_cmd_one_block);
 	DO_TEST(t, test_sc_mac_cmd_four_blocks);
 	DO_TEST(t, test_sc_mac_reply_one_block);
@@ -425,6 +572,7 @@ void run_sc_tests(struct test *t)
 	DO_TEST(t, test_sc_decrypt_data_reply_16b);
 	DO_TEST(t, test_sc_decrypt_data_invalid_len);
 	DO_TEST(t, test_sc_decrypt_data_invalid_marker);
+	DO_TEST(t, test_sc_seal_open_roundtrip);
 
 	osdp_crypt_teardown();
 }
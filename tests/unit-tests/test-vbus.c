@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test.h"
+
+#ifdef OPT_OSDP_VIRTUAL_BUS
+
+#define VBUS_NUM_PD      OSDP_PD_MAX
+
+static struct test *g_vbus_test;
+
+static int test_vbus_wire(void *data)
+{
+	int i, rc = -1;
+	uint8_t tx[10], rx[32];
+	struct osdp_vbus_stats stats;
+	struct osdp_channel a, b, c;
+	struct osdp_vbus_config config = {
+		.baud_rate = 9600,   /* 1041.6us per byte */
+		.turnaround_us = 100,
+	};
+	osdp_vbus_t *bus = osdp_vbus_create(&config);
+
+	ARG_UNUSED(data);
+
+	if (bus == NULL || osdp_vbus_attach(bus, &a) ||
+	    osdp_vbus_attach(bus, &b) || osdp_vbus_attach(bus, &c)) {
+		printf(SUB_1 "bus setup failed\n");
+		goto out;
+	}
+	for (i = 0; i < (int)sizeof(tx); i++) {
+		tx[i] = (uint8_t)(0x30 + i);
+	}
+
+	/* bytes show up one wire time at a time, to everyone but the sender */
+	if (a.send(a.data, tx, sizeof(tx)) != sizeof(tx) ||
+	    osdp_vbus_advance(bus, 5000) != 4 ||
+	    b.recv(b.data, rx, sizeof(rx)) != 4 ||
+	    osdp_vbus_advance(bus, 10000) != 6 ||
+	    b.recv(b.data, rx + 4, sizeof(rx)) != 6 ||
+	    memcmp(rx, tx, sizeof(tx)) ||
+	    c.recv(c.data, rx, sizeof(rx)) != 10 ||
+	    a.recv(a.data, rx, sizeof(rx)) != 0) {
+		printf(SUB_1 "wire timing/delivery failed\n");
+		goto out;
+	}
+
+	/* two talkers at once garble each other */
+	if (a.send(a.data, tx, 4) != 4 || b.send(b.data, tx + 4, 4) != 4 ||
+	    osdp_vbus_advance(bus, 10000) != 8 ||
+	    c.recv(c.data, rx, sizeof(rx)) != 8 ||
+	    memcmp(rx, tx, 4) == 0 || memcmp(rx + 4, tx + 4, 4) == 0) {
+		printf(SUB_1 "collision not simulated\n");
+		goto out;
+	}
+	osdp_vbus_get_stats(bus, &stats);
+	if (stats.collisions != 1 || stats.bytes_sent != 18) {
+		printf(SUB_1 "stats collisions:%llu sent:%llu\n",
+		       (unsigned long long)stats.collisions,
+		       (unsigned long long)stats.bytes_sent);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_vbus_destroy(bus);
+	return rc;
+}
+
+static int test_vbus_impairments(void *data)
+{
+	int i, rc = -1;
+	uint8_t tx[64], rx[64];
+	struct osdp_vbus_stats stats;
+	struct osdp_channel a, b;
+	struct osdp_vbus_config config = {
+		.baud_rate = 115200,
+		.flip_ppm = 1000000,
+		.seed = 7,
+	};
+	osdp_vbus_t *bus = osdp_vbus_create(&config);
+
+	ARG_UNUSED(data);
+
+	if (bus == NULL || osdp_vbus_attach(bus, &a) ||
+	    osdp_vbus_attach(bus, &b)) {
+		printf(SUB_1 "bus setup failed\n");
+		goto out;
+	}
+	memset(tx, 0x55, sizeof(tx));
+
+	/* every byte gets exactly one bit flipped */
+	if (a.send(a.data, tx, sizeof(tx)) != sizeof(tx) ||
+	    osdp_vbus_advance(bus, 10000) != sizeof(tx) ||
+	    b.recv(b.data, rx, sizeof(rx)) != sizeof(tx)) {
+		printf(SUB_1 "flip delivery failed\n");
+		goto out;
+	}
+	for (i = 0; i < (int)sizeof(tx); i++) {
+		rx[i] ^= tx[i];
+		if (rx[i] == 0 || (rx[i] & (rx[i] - 1))) {
+			printf(SUB_1 "byte %d: diff %02x is not a 1-bit flip\n",
+			       i, rx[i]);
+			goto out;
+		}
+	}
+	osdp_vbus_get_stats(bus, &stats);
+	if (stats.bits_flipped != sizeof(tx) || stats.bytes_dropped != 0) {
+		printf(SUB_1 "stats flipped:%llu dropped:%llu\n",
+		       (unsigned long long)stats.bits_flipped,
+		       (unsigned long long)stats.bytes_dropped);
+		goto out;
+	}
+	rc = 0;
+out:
+	osdp_vbus_destroy(bus);
+	return rc;
+}
+
+static int vbus_count_online(osdp_t *cp)
+{
+	int i, n = 0;
+	uint8_t mask[(VBUS_NUM_PD + 7) / 8];
+
+	osdp_get_status_mask(cp, mask);
+	for (i = 0; i < VBUS_NUM_PD; i++) {
+		n += !!(mask[i / 8] & BIT(i % 8));
+	}
+	return n;
+}
+
+/* Refresh everyone, then jump to the next frame end or timer deadline */
+static void vbus_step(osdp_vbus_t *bus, osdp_t *cp, osdp_t **pd, int num_pd)
+{
+	int i, us, step;
+
+	osdp_cp_refresh(cp);
+	step = osdp_cp_next_wakeup(cp) * 1000;
+	for (i = 0; i < num_pd; i++) {
+		osdp_pd_refresh(pd[i]);
+		us = osdp_pd_next_wakeup(pd[i]) * 1000;
+		step = (us < step) ? us : step;
+	}
+	us = osdp_vbus_next_event_us(bus);
+	if (us >= 0 && us < step) {
+		step = us;
+	}
+	osdp_vbus_advance(bus, step ? step : 1);
+}
+
+/* OSDP_PD_MAX PDs on one 115200 line; all must come online and secure */
+static int test_vbus_full_bus(void *data)
+{
+	int i, online = 0, secure_ms = -1, rc = -1;
+	osdp_t *cp = NULL, *pd[VBUS_NUM_PD] = { 0 };
+	osdp_vbus_t *bus;
+	struct osdp_vbus_stats stats;
+	struct osdp_channel cp_channel, pd_channel;
+	osdp_pd_info_t info_cp[VBUS_NUM_PD], info_pd;
+	struct osdp_pd_cap cap[] = {
+		{ OSDP_PD_CAP_READER_LED_CONTROL, 1, 1 },
+		{ -1, -1, -1 }
+	};
+	uint8_t scbk[16] = {
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+		0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+	};
+	struct osdp_vbus_config config = {
+		.baud_rate = 115200,
+		.turnaround_us = 200,
+		.seed = 1,
+		.virtual_clock = true,
+	};
+	uint64_t start_us;
+	tick_t wall_start = millis_now();
+
+	ARG_UNUSED(data);
+
+#ifndef OPT_OSDP_LOG_MINIMAL
+	osdp_logger_init("osdp", g_vbus_test->loglevel, NULL);
+#endif
+	bus = osdp_vbus_create(&config);
+	if (bus == NULL || osdp_vbus_create(&config) != NULL) {
+		printf(SUB_1 "bus setup failed\n");
+		goto out;
+	}
+
+	memset(info_cp, 0, sizeof(info_cp));
+	for (i = 0; i < VBUS_NUM_PD; i++) {
+		info_cp[i].address = i + 1;
+		info_cp[i].baud_rate = 115200;
+		info_cp[i].scbk = scbk;
+	}
+	if (osdp_vbus_attach(bus, &cp_channel) ||
+	    (cp = osdp_cp_setup(&cp_channel, VBUS_NUM_PD, info_cp)) == NULL) {
+		printf(SUB_1 "cp setup failed\n");
+		goto out;
+	}
+	for (i = 0; i < VBUS_NUM_PD; i++) {
+		memset(&info_pd, 0, sizeof(info_pd));
+		info_pd.address = i + 1;
+		info_pd.baud_rate = 115200;
+		info_pd.cap = cap;
+		info_pd.scbk = scbk;
+		if (osdp_vbus_attach(bus, &pd_channel) ||
+		    (pd[i] = osdp_pd_setup(&pd_channel, &info_pd)) == NULL) {
+			printf(SUB_1 "pd %d setup failed\n", i);
+			goto out;
+		}
+	}
+
+	start_us = osdp_vbus_now_us(bus);
+	while (osdp_vbus_now_us(bus) - start_us < 30 * 1000 * 1000ULL) {
+		vbus_step(bus, cp, pd, VBUS_NUM_PD);
+		online = vbus_count_online(cp);
+		secure_ms = osdp_cp_get_time_to_secure(cp);
+		if (online == VBUS_NUM_PD && secure_ms >= 0) {
+			break;
+		}
+	}
+	osdp_vbus_get_stats(bus, &stats);
+	printf(SUB_1 "%d PDs online, all secure in %dms bus time "
+	       "(%llums wall); %llu bytes, %llu collisions\n", online,
+	       secure_ms, (unsigned long long)(millis_now() - wall_start),
+	       (unsigned long long)stats.bytes_sent,
+	       (unsigned long long)stats.collisions);
+	if (online != VBUS_NUM_PD || secure_ms < 0) {
+		goto out;
+	}
+	rc = 0;
+out:
+	if (cp) {
+		osdp_cp_teardown(cp);
+	}
+	for (i = 0; i < VBUS_NUM_PD; i++) {
+		if (pd[i]) {
+			osdp_pd_teardown(pd[i]);
+		}
+	}
+	osdp_vbus_destroy(bus);
+	return rc;
+}
+
+void run_vbus_tests(struct test *t)
+{
+	printf("\nVirtual bus tests\n");
+
+	g_vbus_test = t;
+
+	DO_TEST(t, test_vbus_wire);
+	DO_TEST(t, test_vbus_impairments);
+	DO_TEST(t, test_vbus_full_bus);
+}
+
+#else
+
+void run_vbus_tests(struct test *t)
+{
+	ARG_UNUSED(t);
+	printf("\nVirtual bus tests skipped (OPT_OSDP_VIRTUAL_BUS not enabled)\n");
+}
+
+#endif /* OPT_OSDP_VIRTUAL_BUS */
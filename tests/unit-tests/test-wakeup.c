@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 Siddharth Chandrasekaran <sidcha.dev@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <osdp.h>
+#include "test.h"
+
+/*
+ * The mock channel cannot signal readiness the way a poll()-able fd would,
+ * so the loop below stands in for that with a short fixed ceiling.
+ */
+#define WAKEUP_IO_LATENCY_MS 5
+
+static struct test *g_wakeup_test;
+static int g_wakeup_max_seen;
+
+static int wakeup_min(int a, int b)
+{
+	return (a < b) ? a : b;
+}
+
+/* refresh both ends, sleeping only as long as next_wakeup() allows */
+static void wakeup_run(osdp_t *cp, osdp_t *pd, int ms)
+{
+	int wake;
+	tick_t start = osdp_millis_now();
+
+	while (osdp_millis_since(start) < (tick_t)ms) {
+		osdp_cp_refresh(cp);
+		osdp_pd_refresh(pd);
+		wake = wakeup_min(osdp_cp_next_wakeup(cp),
+				  osdp_pd_next_wakeup(pd));
+		if (wake > g_wakeup_max_seen) {
+			g_wakeup_max_seen = wake;
+		}
+		usleep(wakeup_min(wake, WAKEUP_IO_LATENCY_MS) * 1000);
+	}
+}
+
+static int wakeup_pd_command_cb(void *arg, struct osdp_cmd *cmd)
+{
+	ARG_UNUSED(arg);
+	ARG_UNUSED(cmd);
+	return 0;
+}
+
+static int test_next_wakeup(void *data)
+{
+	int rc = -1, wake, i;
+	osdp_t *cp = NULL, *pd = NULL;
+	struct osdp_cmd cmd = {
+		.id = OSDP_CMD_BUZZER,
+		.buzzer = {
+			.control_code = 1,
+			.on_count = 10,
+			.off_count = 10,
+			.rep_count = 1,
+		},
+	};
+
+	ARG_UNUSED(data);
+
+	g_wakeup_max_seen = 0;
+	if (test_setup_devices(g_wakeup_test, &cp, &pd)) {
+		printf(SUB_1 "device setup failed\n");
+		return -1;
+	}
+	osdp_pd_set_command_callback(pd, wakeup_pd_command_cb, NULL);
+
+	if (!test_run_devices(cp, pd, 10 * 1000, test_pd_online)) {
+		printf(SUB_1 "PD did not come online\n");
+		goto out;
+	}
+
+	/* keep polling for a while; the PD must not drop offline */
+	wakeup_run(cp, pd, 1500);
+	if (!test_pd_online(cp)) {
+		printf(SUB_1 "PD went offline while sleeping on next_wakeup\n");
+		goto out;
+	}
+	if (g_wakeup_max_seen == 0 || g_wakeup_max_seen > OSDP_WAKEUP_MAX_MS) {
+		printf(SUB_1 "max wakeup %dms out of range\n", g_wakeup_max_seen);
+		goto out;
+	}
+
+	wake = osdp_cp_next_wakeup(cp);
+	if (wake < 0 || wake > OSDP_RESP_TOUT_MS + 1) {
+		printf(SUB_1 "online CP wakeup out of range: %dms\n", wake);
+		goto out;
+	}
+
+	/* a freshly queued command must be sent without delay */
+	for (i = 0; i < 1000 && osdp_cp_next_wakeup(cp) == 0; i++) {
+		osdp_cp_refresh(cp);
+		osdp_pd_refresh(pd);
+		usleep(1000);
+	}
+	if (osdp_cp_submit_command(cp, 0, &cmd)) {
+		printf(SUB_1 "command submit failed\n");
+		goto out;
+	}
+	if (osdp_cp_next_wakeup(cp) != 0) {
+		printf(SUB_1 "pending command did not force wakeup\n");
+		goto out;
+	}
+	test_run_devices(cp, pd, 100, NULL);
+
+	rc = 0;
+out:
+	osdp_cp_teardown(cp);
+	osdp_pd_teardown(pd);
+	return rc;
+}
+
+void run_wakeup_tests(struct test *t)
+{
+	printf("\nNext-wakeup tests\n");
+
+	g_wakeup_test = t;
+
+	DO_TEST(t, test_next_wakeup);
+}
@@ -13,6 +13,8 @@
 #include <osdp.h>
 
 #include "osdp_common.h"
+#include "crypto/tinyaes_hw.h"
+#include "crypto/tinyaes_ct.h"
 #include "test.h"
 
 #include <utils/workqueue.h>
@@ -691,6 +693,67 @@ int test_setup_devices(struct test *t, osdp_t **cp, osdp_t **pd)
 	return test_setup_devices_ext(t, cp, pd, 0, 0);
 }
 
+bool test_pd_online(osdp_t *cp)
+{
+	uint8_t status = 0;
+
+	osdp_get_status_mask(cp, &status);
+	return status & 1;
+}
+
+bool test_run_devices(osdp_t *cp, osdp_t *pd, int ms, bool (*cond)(osdp_t *cp))
+{
+	tick_t start = osdp_millis_now();
+
+	while (osdp_millis_since(start) < (tick_t)ms) {
+		osdp_cp_refresh(cp);
+		if (pd) {
+			osdp_pd_refresh(pd);
+		}
+		if (cond && cond(cp)) {
+			return true;
+		}
+		usleep(1000);
+	}
+	return cond == NULL;
+}
+
+#if !defined(OPT_OSDP_USE_OPENSSL) && !defined(OPT_OSDP_USE_MBEDTLS)
+extern bool test_tinyaes_ct_disable;
+#ifdef TINYAES_HW
+extern bool test_tinyaes_hw_disable;
+#endif
+#endif
+
+int test_tinyaes_fallback(int level)
+{
+#if !defined(OPT_OSDP_USE_OPENSSL) && !defined(OPT_OSDP_USE_MBEDTLS)
+	bool have_hw;
+
+#ifdef TINYAES_HW
+	test_tinyaes_hw_disable = false;
+	have_hw = tinyaes_hw_name() != NULL;
+	test_tinyaes_hw_disable = level >= 1;
+#else
+	have_hw = false;
+#endif
+	test_tinyaes_ct_disable = level >= 2;
+	if (level == 1) {
+		return have_hw ? 0 : -1;
+	}
+	if (level == 2) {
+#ifdef TINYAES_CT
+		return 0;
+#else
+		return -1;
+#endif
+	}
+	return 0;
+#else
+	return level ? -1 : 0;
+#endif
+}
+
 void test_start(struct test *t, int log_level)
 {
 	memset(t, 0, sizeof(*t));
@@ -867,6 +930,21 @@ int main(int argc, char *argv[])
 		{ "async_fuzz", run_async_fuzz_tests },
 		{ "sc", run_sc_tests },
 		{ "vectors", run_vector_tests },
+		{ "crc", run_crc_tests },
+		{ "rb", run_rb_tests },
+		{ "cp_pool", run_cp_pool_tests },
+		{ "wakeup", run_wakeup_tests },
+		{ "linux_channel", run_linux_channel_tests },
+		{ "poll_sched", run_poll_sched_tests },
+		{ "metrics", run_metrics_tests },
+		{ "cp_mpsc", run_cp_mpsc_tests },
+		{ "event_ring", run_event_ring_tests },
+		{ "cp_batch", run_cp_batch_tests },
+		{ "cp_pack", run_cp_pack_tests },
+		{ "cp_template", run_cp_template_tests },
+		{ "vbus", run_vbus_tests },
+		{ "cp_backoff", run_cp_backoff_tests },
+		{ "cp_secure", run_cp_secure_tests },
 	};
 
 	ARG_UNUSED(argc);
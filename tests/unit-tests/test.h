@@ -116,6 +116,20 @@ void test_suite_end(struct test *t);
 
 /* Helpers */
 int test_setup_devices(struct test *t, osdp_t **cp, osdp_t **pd);
+/* true once the CP sees PD-0 online; a test_run_devices() condition */
+bool test_pd_online(osdp_t *cp);
+/**
+ * Refresh @cp and @pd (CP only if @pd is NULL) every 1ms for up to @ms.
+ * Returns as soon as @cond(@cp) holds; false if it never did. With a NULL
+ * @cond it runs for all of @ms and returns true.
+ */
+bool test_run_devices(osdp_t *cp, osdp_t *pd, int ms, bool (*cond)(osdp_t *cp));
+/**
+ * Make TinyAES keys set up from here on skip the AES instructions (@level
+ * 1) or those and the bitsliced code (@level 2); 0 restores the default.
+ * Returns -1 if that doesn't pick a different code path in this build.
+ */
+int test_tinyaes_fallback(int level);
 int test_setup_devices_ext(struct test *t, osdp_t **cp, osdp_t **pd,
 			   uint32_t cp_flags, uint32_t pd_flags);
 int async_runner_start(osdp_t *ctx, void (*fn)(osdp_t *));
@@ -142,6 +156,21 @@ void run_notification_tests(struct test *t);
 void run_async_fuzz_tests(struct test *t);
 void run_sc_tests(struct test *t);
 void run_vector_tests(struct test *t);
+void run_crc_tests(struct test *t);
+void run_rb_tests(struct test *t);
+void run_cp_pool_tests(struct test *t);
+void run_wakeup_tests(struct test *t);
+void run_linux_channel_tests(struct test *t);
+void run_poll_sched_tests(struct test *t);
+void run_metrics_tests(struct test *t);
+void run_cp_mpsc_tests(struct test *t);
+void run_event_ring_tests(struct test *t);
+void run_cp_batch_tests(struct test *t);
+void run_cp_pack_tests(struct test *t);
+void run_cp_template_tests(struct test *t);
+void run_vbus_tests(struct test *t);
+void run_cp_backoff_tests(struct test *t);
+void run_cp_secure_tests(struct test *t);
 
 #define printf(...) test_printf(__VA_ARGS__)
 